@@ -0,0 +1,196 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_drm.h"
+#include "../../plugins/platforms/drm/drm_buffer_gbm.h"
+#include "../../plugins/platforms/drm/gbm_surface.h"
+#include <QtTest>
+
+#include <gbm.h>
+
+#include <memory>
+
+// mocking
+
+struct gbm_device {
+};
+
+struct gbm_bo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t handle;
+    void *userData = nullptr;
+    void (*destroyUserData)(gbm_bo *, void *) = nullptr;
+};
+
+struct gbm_surface {
+    QVector<gbm_bo *> bos;
+    int next = 0;
+};
+
+static const int s_bufferCount = 3;
+
+struct gbm_surface *gbm_surface_create(struct gbm_device *gbm, uint32_t width, uint32_t height, uint32_t format, uint32_t flags)
+{
+    Q_UNUSED(gbm)
+    Q_UNUSED(format)
+    Q_UNUSED(flags)
+    static uint32_t handle = 0;
+    auto surface = new gbm_surface;
+    for (int i = 0; i < s_bufferCount; ++i) {
+        surface->bos << new gbm_bo{width, height, ++handle};
+    }
+    return surface;
+}
+
+void gbm_surface_destroy(struct gbm_surface *surface)
+{
+    for (gbm_bo *bo : qAsConst(surface->bos)) {
+        if (bo->destroyUserData) {
+            bo->destroyUserData(bo, bo->userData);
+        }
+        delete bo;
+    }
+    delete surface;
+}
+
+struct gbm_bo *gbm_surface_lock_front_buffer(struct gbm_surface *surface)
+{
+    gbm_bo *bo = surface->bos.at(surface->next);
+    surface->next = (surface->next + 1) % surface->bos.count();
+    return bo;
+}
+
+void gbm_surface_release_buffer(struct gbm_surface *surface, struct gbm_bo *bo)
+{
+    Q_UNUSED(surface)
+    Q_UNUSED(bo)
+}
+
+uint32_t gbm_bo_get_width(struct gbm_bo *bo)
+{
+    return bo->width;
+}
+
+uint32_t gbm_bo_get_height(struct gbm_bo *bo)
+{
+    return bo->height;
+}
+
+uint32_t gbm_bo_get_stride(struct gbm_bo *bo)
+{
+    return bo->width * 4;
+}
+
+union gbm_bo_handle gbm_bo_get_handle(struct gbm_bo *bo)
+{
+    union gbm_bo_handle handle;
+    handle.u32 = bo->handle;
+    return handle;
+}
+
+void gbm_bo_set_user_data(struct gbm_bo *bo, void *data, void (*destroy_user_data)(struct gbm_bo *, void *))
+{
+    bo->userData = data;
+    bo->destroyUserData = destroy_user_data;
+}
+
+void *gbm_bo_get_user_data(struct gbm_bo *bo)
+{
+    return bo->userData;
+}
+
+using KWin::DrmSurfaceBuffer;
+using KWin::GbmSurface;
+
+class GbmBufferTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void testSteadyState();
+    void testSurfaceDestroyed();
+};
+
+void GbmBufferTest::init()
+{
+    MockDrm::resetFramebufferCounts();
+}
+
+void GbmBufferTest::testSteadyState()
+{
+    // this test verifies that after every bo got scanned out once, presenting a frame
+    // neither adds nor removes a framebuffer
+    auto surface = std::make_shared<GbmSurface>(nullptr, 1920, 1080, 0, 0);
+    QVERIFY(*surface);
+
+    std::unique_ptr<DrmSurfaceBuffer> presented;
+    QVector<quint32> bufferIds;
+    for (int i = 0; i < s_bufferCount; ++i) {
+        auto buffer = std::make_unique<DrmSurfaceBuffer>(0, surface);
+        QVERIFY(buffer->hasBo());
+        QVERIFY(buffer->bufferId() != 0);
+        QCOMPARE(buffer->size(), QSize(1920, 1080));
+        bufferIds << buffer->bufferId();
+        // the previous buffer is released after the page flip
+        presented = std::move(buffer);
+    }
+    QCOMPARE(MockDrm::addedFramebuffers(), s_bufferCount);
+    QCOMPARE(MockDrm::removedFramebuffers(), 0);
+
+    MockDrm::resetFramebufferCounts();
+    for (int frame = 0; frame < 100; ++frame) {
+        auto buffer = std::make_unique<DrmSurfaceBuffer>(0, surface);
+        QCOMPARE(buffer->bufferId(), bufferIds.at(frame % s_bufferCount));
+        presented = std::move(buffer);
+        QCOMPARE(MockDrm::addedFramebuffers(), 0);
+        QCOMPARE(MockDrm::removedFramebuffers(), 0);
+    }
+
+    // the framebuffers go away together with the surface
+    presented.reset();
+    QCOMPARE(MockDrm::removedFramebuffers(), 0);
+    surface.reset();
+    QCOMPARE(MockDrm::removedFramebuffers(), s_bufferCount);
+}
+
+void GbmBufferTest::testSurfaceDestroyed()
+{
+    // this test verifies that resizing, which replaces the surface, only removes the
+    // framebuffers of the old surface once its last buffer is gone
+    auto surface = std::make_shared<GbmSurface>(nullptr, 1920, 1080, 0, 0);
+    auto buffer = std::make_unique<DrmSurfaceBuffer>(0, surface);
+    QCOMPARE(MockDrm::addedFramebuffers(), 1);
+
+    surface = std::make_shared<GbmSurface>(nullptr, 1280, 1024, 0, 0);
+    auto resizedBuffer = std::make_unique<DrmSurfaceBuffer>(0, surface);
+    QCOMPARE(resizedBuffer->size(), QSize(1280, 1024));
+    QCOMPARE(MockDrm::addedFramebuffers(), 2);
+    QCOMPARE(MockDrm::removedFramebuffers(), 0);
+
+    buffer.reset();
+    QCOMPARE(MockDrm::removedFramebuffers(), 1);
+    resizedBuffer.reset();
+    surface.reset();
+    QCOMPARE(MockDrm::removedFramebuffers(), 2);
+}
+
+QTEST_GUILESS_MAIN(GbmBufferTest)
+#include "gbmbuffertest.moc"
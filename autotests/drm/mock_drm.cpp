@@ -19,10 +19,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "mock_drm.h"
 
+#include <xf86drm.h>
+
 #include <QMap>
 #include <QVector>
 
 static QMap<int, QVector<_drmModeProperty>> s_drmProperties{};
+static uint32_t s_nextFramebufferId = 0;
+static int s_addedFramebuffers = 0;
+static int s_removedFramebuffers = 0;
 
 namespace MockDrm
 {
@@ -32,6 +37,22 @@ void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties)
     s_drmProperties.insert(fd, properties);
 }
 
+int addedFramebuffers()
+{
+    return s_addedFramebuffers;
+}
+
+int removedFramebuffers()
+{
+    return s_removedFramebuffers;
+}
+
+void resetFramebufferCounts()
+{
+    s_addedFramebuffers = 0;
+    s_removedFramebuffers = 0;
+}
+
 }
 
 int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
@@ -76,3 +97,34 @@ void drmModeFreeProperty(drmModePropertyPtr ptr)
 {
     delete ptr;
 }
+
+int drmModeAddFB(int fd, uint32_t width, uint32_t height, uint8_t depth, uint8_t bpp, uint32_t pitch, uint32_t bo_handle, uint32_t *buf_id)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(depth)
+    Q_UNUSED(bpp)
+    Q_UNUSED(pitch)
+    Q_UNUSED(bo_handle)
+    *buf_id = ++s_nextFramebufferId;
+    s_addedFramebuffers++;
+    return 0;
+}
+
+int drmModeRmFB(int fd, uint32_t bufferId)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(bufferId)
+    s_removedFramebuffers++;
+    return 0;
+}
+
+int drmIoctl(int fd, unsigned long request, void *arg)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(request)
+    Q_UNUSED(arg)
+    // dumb buffers are not supported
+    return -1;
+}
@@ -29,4 +29,12 @@ namespace MockDrm
 
 void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties);
 
+/**
+ * Number of framebuffers added with drmModeAddFB and removed with drmModeRmFB
+ * since the last resetFramebufferCounts().
+ */
+int addedFramebuffers();
+int removedFramebuffers();
+void resetFramebufferCounts();
+
 }
@@ -0,0 +1,232 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "options.h"
+#include "platform.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "x11client.h"
+#include "xcbutils.h"
+
+#include <xcb/xcb_icccm.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_desktop_switch_x11_benchmark-0");
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+class DesktopSwitchX11Benchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testOnlyChangedClientsUpdated();
+    void testDesktopChangeUpdatesIndex();
+    void benchmarkSwitch_data();
+    void benchmarkSwitch();
+
+private:
+    void createWindows(int count);
+
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+    QList<X11Client *> m_clients;
+};
+
+void DesktopSwitchX11Benchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::X11Client *>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+
+    // really unmap the windows on other desktops, so hiding is visible as well
+    options->setHiddenPreviews(HiddenPreviewsNever);
+}
+
+void DesktopSwitchX11Benchmark::init()
+{
+    VirtualDesktopManager::self()->setCount(3);
+    VirtualDesktopManager::self()->setCurrent(1u);
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+}
+
+void DesktopSwitchX11Benchmark::cleanup()
+{
+    m_clients.clear();
+    m_connection.reset();
+    QTRY_VERIFY_WITH_TIMEOUT(workspace()->clientList().isEmpty(), 30000);
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+void DesktopSwitchX11Benchmark::createWindows(int count)
+{
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    for (int i = 0; i < count; ++i) {
+        const QRect windowGeometry(0, 0, 100, 200);
+        xcb_window_t w = xcb_generate_id(m_connection.data());
+        xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                          windowGeometry.x(),
+                          windowGeometry.y(),
+                          windowGeometry.width(),
+                          windowGeometry.height(),
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        xcb_size_hints_t hints;
+        memset(&hints, 0, sizeof(hints));
+        xcb_icccm_size_hints_set_position(&hints, 1, windowGeometry.x(), windowGeometry.y());
+        xcb_icccm_size_hints_set_size(&hints, 1, windowGeometry.width(), windowGeometry.height());
+        xcb_icccm_set_wm_normal_hints(m_connection.data(), w, &hints);
+        xcb_map_window(m_connection.data(), w);
+    }
+    xcb_flush(m_connection.data());
+
+    QTRY_COMPARE_WITH_TIMEOUT(clientAddedSpy.count(), count, 30000);
+    for (const QList<QVariant> &arguments : qAsConst(clientAddedSpy)) {
+        m_clients << arguments.first().value<X11Client *>();
+    }
+}
+
+void DesktopSwitchX11Benchmark::testOnlyChangedClientsUpdated()
+{
+    // this test verifies that switching the desktop only maps and unmaps the windows
+    // which are on exactly one of both desktops
+    createWindows(4);
+    X11Client *first = m_clients.at(0);
+    X11Client *second = m_clients.at(1);
+    X11Client *both = m_clients.at(2);
+    X11Client *sticky = m_clients.at(3);
+    workspace()->sendClientToDesktop(second, 2, true);
+    both->setDesktops({VirtualDesktopManager::self()->desktopForX11Id(1),
+                       VirtualDesktopManager::self()->desktopForX11Id(2)});
+    sticky->setOnAllDesktops(true);
+    QVERIFY(first->isOnCurrentDesktop());
+    QVERIFY(!second->isOnCurrentDesktop());
+
+    QList<QSignalSpy *> shownSpies;
+    QList<QSignalSpy *> hiddenSpies;
+    for (X11Client *client : qAsConst(m_clients)) {
+        shownSpies << new QSignalSpy(client, &X11Client::windowShown);
+        hiddenSpies << new QSignalSpy(client, &X11Client::windowHidden);
+    }
+
+    VirtualDesktopManager::self()->setCurrent(2u);
+    QCOMPARE(hiddenSpies.at(0)->count(), 1);
+    QCOMPARE(shownSpies.at(0)->count(), 0);
+    QCOMPARE(hiddenSpies.at(1)->count(), 0);
+    QCOMPARE(shownSpies.at(1)->count(), 1);
+    for (int i = 2; i < m_clients.count(); ++i) {
+        QCOMPARE(hiddenSpies.at(i)->count(), 0);
+        QCOMPARE(shownSpies.at(i)->count(), 0);
+        QVERIFY(m_clients.at(i)->isOnCurrentDesktop());
+    }
+
+    // and switching to a desktop without any windows only hides
+    VirtualDesktopManager::self()->setCurrent(3u);
+    QCOMPARE(hiddenSpies.at(1)->count(), 1);
+    QCOMPARE(hiddenSpies.at(2)->count(), 1);
+    QCOMPARE(hiddenSpies.at(3)->count(), 0);
+
+    qDeleteAll(shownSpies);
+    qDeleteAll(hiddenSpies);
+}
+
+void DesktopSwitchX11Benchmark::testDesktopChangeUpdatesIndex()
+{
+    // this test verifies that a window which changed its desktop is shown and hidden
+    // according to its new desktop
+    createWindows(1);
+    X11Client *client = m_clients.first();
+    QVERIFY(client->isOnCurrentDesktop());
+
+    workspace()->sendClientToDesktop(client, 2, true);
+    QVERIFY(!client->isOnCurrentDesktop());
+    QSignalSpy shownSpy(client, &X11Client::windowShown);
+    QVERIFY(shownSpy.isValid());
+    VirtualDesktopManager::self()->setCurrent(2u);
+    QCOMPARE(shownSpy.count(), 1);
+
+    client->setOnAllDesktops(true);
+    QSignalSpy hiddenSpy(client, &X11Client::windowHidden);
+    QVERIFY(hiddenSpy.isValid());
+    VirtualDesktopManager::self()->setCurrent(3u);
+    QVERIFY(hiddenSpy.isEmpty());
+    QVERIFY(client->isOnCurrentDesktop());
+}
+
+void DesktopSwitchX11Benchmark::benchmarkSwitch_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("20") << 20;
+    QTest::newRow("100") << 100;
+    QTest::newRow("200") << 200;
+}
+
+void DesktopSwitchX11Benchmark::benchmarkSwitch()
+{
+    // every desktop gets a third of the windows, the rest is on all desktops
+    QFETCH(int, count);
+    createWindows(count);
+    for (int i = 0; i < count; ++i) {
+        if (i % 3 == 1) {
+            workspace()->sendClientToDesktop(m_clients.at(i), 2, true);
+        } else if (i % 3 == 2) {
+            m_clients.at(i)->setOnAllDesktops(true);
+        }
+    }
+
+    uint desktop = 1;
+    QBENCHMARK {
+        desktop = desktop == 1 ? 2 : 1;
+        VirtualDesktopManager::self()->setCurrent(desktop);
+    }
+    for (X11Client *client : qAsConst(m_clients)) {
+        Xcb::WindowAttributes attributes(client->frameId());
+        QVERIFY(!attributes.isNull());
+        QCOMPARE(attributes->map_state == XCB_MAP_STATE_VIEWABLE, client->isOnCurrentDesktop());
+    }
+}
+
+WAYLANDTEST_MAIN(DesktopSwitchX11Benchmark)
+#include "desktop_switch_x11_benchmark.moc"
@@ -0,0 +1,168 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "outputframescheduler.h"
+#include "platform.h"
+#include "scene.h"
+#include "xdgshellclient.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include "effect_builtins.h"
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur-0");
+
+class BlurTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCachedBlurSkipsPasses();
+
+private:
+    void waitForIdle();
+};
+
+void BlurTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::XdgShellClient *>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void BlurTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void BlurTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+void BlurTest::waitForIdle()
+{
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    auto busy = [&schedulers] {
+        return std::any_of(schedulers.begin(), schedulers.end(),
+                           [](OutputFrameScheduler *s) { return s->hasRepaints(); });
+    };
+    QTRY_VERIFY(!busy());
+    // give the frame in flight the chance to finish
+    QTest::qWait(100);
+}
+
+void BlurTest::testCachedBlurSkipsPasses()
+{
+    // This test verifies that the blurred background of a window is reused as long as only
+    // the window itself changes, and that a change underneath the window blurs it again.
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    if (!effectsImpl->loadEffect(QStringLiteral("blur"))) {
+        QSKIP("The blur effect is not supported");
+    }
+    Effect *effect = effectsImpl->findEffect(QStringLiteral("blur"));
+    QVERIFY(effect);
+
+    // Create a window and a translucent blurred window on top of it.
+    using namespace KWayland::Client;
+    QScopedPointer<Surface> bottomSurface(Test::createSurface());
+    QVERIFY(!bottomSurface.isNull());
+    QScopedPointer<XdgShellSurface> bottomShellSurface(Test::createXdgShellStableSurface(bottomSurface.data()));
+    QVERIFY(!bottomShellSurface.isNull());
+    XdgShellClient *bottom = Test::renderAndWaitForShown(bottomSurface.data(), QSize(500, 500), Qt::blue);
+    QVERIFY(bottom);
+    bottom->move(QPoint(0, 0));
+
+    QScopedPointer<Surface> topSurface(Test::createSurface());
+    QVERIFY(!topSurface.isNull());
+    QScopedPointer<XdgShellSurface> topShellSurface(Test::createXdgShellStableSurface(topSurface.data()));
+    QVERIFY(!topShellSurface.isNull());
+    XdgShellClient *top = Test::renderAndWaitForShown(topSurface.data(), QSize(200, 200), QColor(255, 0, 0, 128));
+    QVERIFY(top);
+    top->move(QPoint(100, 100));
+    QVERIFY(top->hasAlpha());
+    // an empty region blurs the whole window
+    top->effectWindow()->setData(WindowBlurBehindRole, QVariant::fromValue(QRegion()));
+
+    // The first frame has to blur the background.
+    Compositor::self()->addRepaintFull();
+    QTRY_VERIFY(effect->debug(QStringLiteral("blurPasses")).toLongLong() > 0);
+    waitForIdle();
+
+    // Repainting only the blurred window reuses its background.
+    const qint64 passes = effect->debug(QStringLiteral("blurPasses")).toLongLong();
+    const qint64 hits = effect->debug(QStringLiteral("cacheHits")).toLongLong();
+    Test::render(topSurface.data(), QSize(200, 200), QColor(0, 255, 0, 128));
+    QTRY_VERIFY(effect->debug(QStringLiteral("cacheHits")).toLongLong() > hits);
+    waitForIdle();
+    QCOMPARE(effect->debug(QStringLiteral("blurPasses")).toLongLong(), passes);
+
+    // A change of the window underneath has to blur the background again.
+    Test::render(bottomSurface.data(), QSize(500, 500), Qt::yellow);
+    QTRY_VERIFY(effect->debug(QStringLiteral("blurPasses")).toLongLong() > passes);
+}
+
+WAYLANDTEST_MAIN(BlurTest)
+#include "blur_test.moc"
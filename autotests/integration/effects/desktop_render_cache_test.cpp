@@ -0,0 +1,196 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include "effect_builtins.h"
+#include "effects/desktopgrid/desktoprendercache.h"
+
+#include <kwinglutils.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_desktop_render_cache-0");
+
+class DesktopRenderCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testBudget();
+    void testInvalidate();
+    void testResolution();
+    void testOutsideScreen();
+};
+
+void DesktopRenderCacheTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+
+    auto scene = Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), OpenGL2Compositing);
+}
+
+void DesktopRenderCacheTest::init()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    if (!DesktopRenderCache::supported()) {
+        QSKIP("Framebuffer blits are not supported");
+    }
+    // the cache reads from the framebuffer of the screen
+    QCOMPARE(GLRenderTarget::virtualScreenGeometry(), QRect(0, 0, 1280, 1024));
+}
+
+void DesktopRenderCacheTest::testBudget()
+{
+    // a desktop is only cached while its texture fits into the memory limit
+    const qint64 textureSize = 100 * 100 * 4;
+    DesktopRenderCache cache;
+    cache.setBudget(2 * textureSize, 1.0);
+    const QRect geometry(0, 0, 100, 100);
+
+    cache.capture(1, 0, geometry, 1.0);
+    QVERIFY(cache.isValid(1, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), textureSize);
+    cache.capture(2, 0, geometry, 1.0);
+    QVERIFY(cache.isValid(2, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 2 * textureSize);
+
+    // the third desktop exceeds the budget
+    cache.capture(3, 0, geometry, 1.0);
+    QVERIFY(!cache.isValid(3, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 2 * textureSize);
+
+    // capturing again reuses the texture
+    cache.capture(1, 0, geometry, 1.0);
+    QVERIFY(cache.isValid(1, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 2 * textureSize);
+
+    // a smaller cell replaces the texture, which makes room for the third desktop
+    const QRect smaller(0, 0, 50, 50);
+    cache.capture(1, 0, smaller, 1.0);
+    QVERIFY(!cache.isValid(1, 0, geometry, 1.0));
+    QVERIFY(cache.isValid(1, 0, smaller, 1.0));
+    QCOMPARE(cache.memoryUsage(), textureSize + 50 * 50 * 4);
+    cache.capture(3, 0, smaller, 1.0);
+    QVERIFY(cache.isValid(3, 0, smaller, 1.0));
+    QCOMPARE(cache.memoryUsage(), textureSize + 2 * 50 * 50 * 4);
+
+    // an unchanged budget keeps the cache, a changed one drops it
+    cache.setBudget(2 * textureSize, 1.0);
+    QVERIFY(cache.isValid(2, 0, geometry, 1.0));
+    cache.setBudget(4 * textureSize, 1.0);
+    QVERIFY(!cache.isValid(2, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 0);
+}
+
+void DesktopRenderCacheTest::testInvalidate()
+{
+    // invalidating keeps the textures around for the next capture
+    const qint64 textureSize = 100 * 100 * 4;
+    DesktopRenderCache cache;
+    cache.setBudget(8 * textureSize, 1.0);
+    const QRect first(0, 0, 100, 100);
+    const QRect second(200, 0, 100, 100);
+
+    cache.capture(1, 0, first, 1.0);
+    cache.capture(1, 1, second, 1.0);
+    cache.capture(2, 0, second, 1.0);
+    QCOMPARE(cache.memoryUsage(), 3 * textureSize);
+
+    // geometry and brightness have to match
+    QVERIFY(cache.isValid(1, 0, first, 1.0));
+    QVERIFY(!cache.isValid(1, 0, second, 1.0));
+    QVERIFY(!cache.isValid(1, 0, first, 0.7));
+    QVERIFY(!cache.isValid(1, 2, first, 1.0));
+
+    // all screens of the desktop are invalidated
+    cache.invalidate(1);
+    QVERIFY(!cache.isValid(1, 0, first, 1.0));
+    QVERIFY(!cache.isValid(1, 1, second, 1.0));
+    QVERIFY(cache.isValid(2, 0, second, 1.0));
+    QCOMPARE(cache.memoryUsage(), 3 * textureSize);
+
+    cache.capture(1, 0, first, 0.7);
+    QVERIFY(cache.isValid(1, 0, first, 0.7));
+    QCOMPARE(cache.memoryUsage(), 3 * textureSize);
+
+    cache.invalidateAll();
+    QVERIFY(!cache.isValid(1, 0, first, 0.7));
+    QVERIFY(!cache.isValid(2, 0, second, 1.0));
+    QCOMPARE(cache.memoryUsage(), 3 * textureSize);
+
+    cache.clear();
+    QCOMPARE(cache.memoryUsage(), 0);
+}
+
+void DesktopRenderCacheTest::testResolution()
+{
+    // a reduced resolution shrinks the textures
+    DesktopRenderCache cache;
+    cache.setBudget(100 * 100 * 4, 0.5);
+    const QRect geometry(0, 0, 100, 100);
+    cache.capture(1, 0, geometry, 1.0);
+    QVERIFY(cache.isValid(1, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 50 * 50 * 4);
+}
+
+void DesktopRenderCacheTest::testOutsideScreen()
+{
+    // a cell not fully on the painted screen cannot be read back
+    DesktopRenderCache cache;
+    cache.setBudget(1024 * 1024 * 4, 1.0);
+    const QRect geometry(1200, 0, 100, 100);
+    cache.capture(1, 0, geometry, 1.0);
+    QVERIFY(!cache.isValid(1, 0, geometry, 1.0));
+    QCOMPARE(cache.memoryUsage(), 0);
+}
+
+WAYLANDTEST_MAIN(DesktopRenderCacheTest)
+#include "desktop_render_cache_test.moc"
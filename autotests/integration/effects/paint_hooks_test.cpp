@@ -0,0 +1,255 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "scene.h"
+#include "xdgshellclient.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include "effect_builtins.h"
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_paint_hooks-0");
+
+/**
+ * Counts how often each of its paint hooks gets called.
+ */
+class HookEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    explicit HookEffect(PaintHooks hooks)
+        : m_hooks(hooks)
+    {
+    }
+
+    PaintHooks paintHooks() const override {
+        return m_hooks;
+    }
+
+    void prePaintScreen(ScreenPrePaintData &data, int time) override {
+        m_calls[PrePaintScreenHook]++;
+        effects->prePaintScreen(data, time);
+    }
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override {
+        m_calls[PaintScreenHook]++;
+        effects->paintScreen(mask, region, data);
+    }
+    void postPaintScreen() override {
+        m_calls[PostPaintScreenHook]++;
+        effects->postPaintScreen();
+    }
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, int time) override {
+        m_calls[PrePaintWindowHook]++;
+        effects->prePaintWindow(w, data, time);
+    }
+    void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override {
+        m_calls[PaintWindowHook]++;
+        effects->paintWindow(w, mask, region, data);
+    }
+    void postPaintWindow(EffectWindow *w) override {
+        m_calls[PostPaintWindowHook]++;
+        effects->postPaintWindow(w);
+    }
+    void drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data) override {
+        m_calls[DrawWindowHook]++;
+        effects->drawWindow(w, mask, region, data);
+    }
+
+    int calls(PaintHook hook) const {
+        return m_calls.value(hook);
+    }
+    void resetCalls() {
+        m_calls.clear();
+    }
+
+private:
+    PaintHooks m_hooks;
+    QHash<int, int> m_calls;
+};
+
+class PaintHooksTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testDefaultHooks();
+    void testPartialHooks();
+
+private:
+    HookEffect *loadHookEffect(const QString &name, Effect::PaintHooks hooks);
+    void paintFrame();
+};
+
+void PaintHooksTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::XdgShellClient *>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+    QVERIFY(Compositor::self()->scene());
+}
+
+void PaintHooksTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void PaintHooksTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+HookEffect *PaintHooksTest::loadHookEffect(const QString &name, Effect::PaintHooks hooks)
+{
+    // hand the effect to the effects handler like a loaded plugin
+    auto loader = effects->findChild<AbstractEffectLoader *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!loader) {
+        return nullptr;
+    }
+    HookEffect *effect = new HookEffect(hooks);
+    emit loader->effectLoaded(effect, name);
+    return effect;
+}
+
+void PaintHooksTest::paintFrame()
+{
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+}
+
+void PaintHooksTest::testDefaultHooks()
+{
+    // an effect not declaring its paint hooks takes part in all the chains
+    HookEffect *effect = loadHookEffect(QStringLiteral("all"), Effect::AllPaintHooks);
+    QVERIFY(effect);
+    QCOMPARE(effect->paintHooks(), Effect::AllPaintHooks);
+
+    using namespace KWayland::Client;
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    XdgShellClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    effect->resetCalls();
+    paintFrame();
+    QVERIFY(effect->calls(Effect::PrePaintScreenHook) > 0);
+    QVERIFY(effect->calls(Effect::PaintScreenHook) > 0);
+    QVERIFY(effect->calls(Effect::PostPaintScreenHook) > 0);
+    QVERIFY(effect->calls(Effect::PrePaintWindowHook) > 0);
+    QVERIFY(effect->calls(Effect::PaintWindowHook) > 0);
+    QVERIFY(effect->calls(Effect::PostPaintWindowHook) > 0);
+    QVERIFY(effect->calls(Effect::DrawWindowHook) > 0);
+}
+
+void PaintHooksTest::testPartialHooks()
+{
+    // an effect is only called from the chains of the hooks it declares, and the
+    // other effects in a chain are still called when it is skipped
+    HookEffect *all = loadHookEffect(QStringLiteral("all"), Effect::AllPaintHooks);
+    QVERIFY(all);
+    HookEffect *paintWindow = loadHookEffect(QStringLiteral("paintWindow"), Effect::PaintWindowHook);
+    QVERIFY(paintWindow);
+    HookEffect *drawWindow = loadHookEffect(QStringLiteral("drawWindow"),
+                                            Effect::PrePaintScreenHook | Effect::DrawWindowHook);
+    QVERIFY(drawWindow);
+
+    using namespace KWayland::Client;
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    XdgShellClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    all->resetCalls();
+    paintWindow->resetCalls();
+    drawWindow->resetCalls();
+    paintFrame();
+
+    QVERIFY(paintWindow->calls(Effect::PaintWindowHook) > 0);
+    QCOMPARE(paintWindow->calls(Effect::PaintWindowHook), all->calls(Effect::PaintWindowHook));
+    QCOMPARE(paintWindow->calls(Effect::PrePaintScreenHook), 0);
+    QCOMPARE(paintWindow->calls(Effect::PaintScreenHook), 0);
+    QCOMPARE(paintWindow->calls(Effect::PostPaintScreenHook), 0);
+    QCOMPARE(paintWindow->calls(Effect::PrePaintWindowHook), 0);
+    QCOMPARE(paintWindow->calls(Effect::PostPaintWindowHook), 0);
+    QCOMPARE(paintWindow->calls(Effect::DrawWindowHook), 0);
+
+    QVERIFY(drawWindow->calls(Effect::DrawWindowHook) > 0);
+    QCOMPARE(drawWindow->calls(Effect::DrawWindowHook), all->calls(Effect::DrawWindowHook));
+    QVERIFY(drawWindow->calls(Effect::PrePaintScreenHook) > 0);
+    QCOMPARE(drawWindow->calls(Effect::PrePaintScreenHook), all->calls(Effect::PrePaintScreenHook));
+    QCOMPARE(drawWindow->calls(Effect::PaintScreenHook), 0);
+    QCOMPARE(drawWindow->calls(Effect::PostPaintScreenHook), 0);
+    QCOMPARE(drawWindow->calls(Effect::PrePaintWindowHook), 0);
+    QCOMPARE(drawWindow->calls(Effect::PaintWindowHook), 0);
+    QCOMPARE(drawWindow->calls(Effect::PostPaintWindowHook), 0);
+
+    // the chains without the partial effects still reach the effect declaring all hooks
+    QVERIFY(all->calls(Effect::PaintScreenHook) > 0);
+    QCOMPARE(all->calls(Effect::PostPaintScreenHook), all->calls(Effect::PrePaintScreenHook));
+    QVERIFY(all->calls(Effect::PrePaintWindowHook) > 0);
+    QVERIFY(all->calls(Effect::PostPaintWindowHook) > 0);
+}
+
+WAYLANDTEST_MAIN(PaintHooksTest)
+#include "paint_hooks_test.moc"
@@ -27,8 +27,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "wayland_server.h"
 #include "effect_builtins.h"
 
+#include <kwinglplatform.h>
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
 #include <KConfigGroup>
 
+#include <QDataStream>
+#include <QDir>
+#include <QStandardPaths>
+
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
 using namespace KWin;
 static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_opengl-0");
 
@@ -118,3 +130,155 @@ void GenericSceneOpenGLTest::testRestart()
     // TODO: introduce frameRendered signal in SceneOpenGL
     QTest::qWait(100);
 }
+
+void GenericSceneOpenGLTest::testDamagedShmUpload()
+{
+    // only the damaged part of a shm buffer gets uploaded to the texture
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    auto client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue, QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(client);
+
+    auto scene = KWin::Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+
+    GLTexture::resetUploadStatistics();
+    QSignalSpy damagedSpy(client, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    QImage image(QSize(100, 50), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+    surface->damage(QRect(10, 20, 30, 10));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    QVERIFY(frameRenderedSpy.wait());
+
+    const GLTextureUploadStatistics statistics = GLTexture::uploadStatistics();
+    QCOMPARE(statistics.uploads, quint64(1));
+    QCOMPARE(statistics.rects, quint64(1));
+    QCOMPARE(statistics.bytes, quint64(30 * 10 * 4));
+    if (!GLPlatform::instance()->isGLES()) {
+        // the buffer is already in the upload format
+        QCOMPARE(statistics.convertedBytes, quint64(0));
+    }
+}
+
+static bool restartCompositing()
+{
+    QSignalSpy sceneCreatedSpy(KWin::Compositor::self(), &Compositor::sceneCreated);
+    KWin::Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty() && !sceneCreatedSpy.wait()) {
+        return false;
+    }
+    auto scene = KWin::Compositor::self()->scene();
+    return scene && scene->makeOpenGLContextCurrent();
+}
+
+static QDir shaderCacheDir()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/ukui-kwin/shaders"));
+}
+
+void GenericSceneOpenGLTest::testShaderCache()
+{
+    // programs linked in an earlier compositing session are loaded from the cache
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene->makeOpenGLContextCurrent());
+    if (!ShaderManager::instance()->isProgramCacheEnabled()) {
+        QSKIP("The driver does not support program binaries");
+    }
+    const ShaderTraits traits = ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+
+    QVERIFY(restartCompositing());
+
+    const int hits = ShaderManager::instance()->cacheStatistics().hits;
+    const int misses = ShaderManager::instance()->cacheStatistics().misses;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().hits, hits + 1);
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().misses, misses);
+}
+
+void GenericSceneOpenGLTest::testShaderCacheInvalidBinary()
+{
+    // a binary the driver rejects gets compiled again and replaced in the cache
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene->makeOpenGLContextCurrent());
+    if (!ShaderManager::instance()->isProgramCacheEnabled()) {
+        QSKIP("The driver does not support program binaries");
+    }
+    const ShaderTraits traits = ShaderTrait::MapTexture | ShaderTrait::AdjustSaturation;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+
+    // keep the header, but garble the program binaries
+    const QFileInfoList drivers = shaderCacheDir().entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(drivers.count(), 1);
+    const QFileInfoList binaries = QDir(drivers.first().filePath()).entryInfoList(QDir::Files);
+    QVERIFY(!binaries.isEmpty());
+    for (const QFileInfo &info : binaries) {
+        QFile file(info.filePath());
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QDataStream stream(&file);
+        quint32 magic, version, binaryFormat;
+        qint64 compileTime;
+        QByteArray binary;
+        stream >> magic >> version >> binaryFormat >> compileTime >> binary;
+        QCOMPARE(stream.status(), QDataStream::Ok);
+        binary.fill('\xff');
+        file.seek(0);
+        stream << magic << version << binaryFormat << compileTime << binary;
+        file.close();
+    }
+
+    QVERIFY(restartCompositing());
+    const auto statistics = ShaderManager::instance()->cacheStatistics();
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().hits, statistics.hits);
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().misses, statistics.misses + 1);
+
+    // the compiled program replaced the broken binary
+    QVERIFY(restartCompositing());
+    const int hits = ShaderManager::instance()->cacheStatistics().hits;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().hits, hits + 1);
+}
+
+void GenericSceneOpenGLTest::testShaderCachePrune()
+{
+    // binaries of other drivers are removed when the cache is opened
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene->makeOpenGLContextCurrent());
+    if (!ShaderManager::instance()->isProgramCacheEnabled()) {
+        QSKIP("The driver does not support program binaries");
+    }
+    const ShaderTraits traits = ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+
+    QDir cacheDir = shaderCacheDir();
+    const QStringList drivers = cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(drivers.count(), 1);
+    QVERIFY(cacheDir.mkpath(QStringLiteral("stale-driver")));
+    QFile staleBinary(cacheDir.filePath(QStringLiteral("stale-driver/0123456789abcdef")));
+    QVERIFY(staleBinary.open(QIODevice::WriteOnly));
+    staleBinary.write(QByteArrayLiteral("stale"));
+    staleBinary.close();
+    QFile staleFile(cacheDir.filePath(QStringLiteral("fedcba9876543210")));
+    QVERIFY(staleFile.open(QIODevice::WriteOnly));
+    staleFile.close();
+
+    QVERIFY(restartCompositing());
+    QVERIFY(ShaderManager::instance()->isProgramCacheEnabled());
+    QCOMPARE(cacheDir.entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot), drivers);
+
+    // the binaries of the current driver are kept
+    const int hits = ShaderManager::instance()->cacheStatistics().hits;
+    QVERIFY(ShaderManager::instance()->shader(traits)->isValid());
+    QCOMPARE(ShaderManager::instance()->cacheStatistics().hits, hits + 1);
+}
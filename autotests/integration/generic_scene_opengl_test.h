@@ -34,6 +34,10 @@ private Q_SLOTS:
     void cleanup();
     void testRestart_data();
     void testRestart();
+    void testDamagedShmUpload();
+    void testShaderCache();
+    void testShaderCacheInvalidBinary();
+    void testShaderCachePrune();
 
 private:
     QByteArray m_envVariable;
@@ -27,16 +27,20 @@ class Window : public QRasterWindow
 {
     Q_OBJECT
 public:
-    explicit Window();
+    explicit Window(const QString &text);
     ~Window() override;
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void focusInEvent(QFocusEvent *event) override;
+
+private:
+    QString m_text;
 };
 
-Window::Window()
+Window::Window(const QString &text)
     : QRasterWindow()
+    , m_text(text)
 {
 }
 
@@ -53,15 +57,18 @@ void Window::focusInEvent(QFocusEvent *event)
 {
     QRasterWindow::focusInEvent(event);
     // TODO: make it work without singleshot
-    QTimer::singleShot(100,[] {
-        qApp->clipboard()->setText(QStringLiteral("test"));
+    QTimer::singleShot(100, this, [this] {
+        qApp->clipboard()->setText(m_text);
     });
 }
 
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
-    QScopedPointer<Window> w(new Window);
+    // optionally the size of the text to copy, for measuring large transfers
+    const int size = app.arguments().value(1).toInt();
+    const QString text = size > 0 ? QString(size, QLatin1Char('x')) : QStringLiteral("test");
+    QScopedPointer<Window> w(new Window(text));
     w->setGeometry(QRect(0, 0, 100, 200));
     w->show();
 
@@ -51,9 +51,12 @@ void Window::paintEvent(QPaintEvent *event)
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
+    // optionally the size of the text copied by the copy helper
+    const int size = app.arguments().value(1).toInt();
+    const QString text = size > 0 ? QString(size, QLatin1Char('x')) : QStringLiteral("test");
     QObject::connect(app.clipboard(), &QClipboard::changed, &app,
-        [] {
-            if (qApp->clipboard()->text() == QLatin1String("test")) {
+        [text] {
+            if (qApp->clipboard()->text() == text) {
                 QTimer::singleShot(100, qApp, &QCoreApplication::quit);
             }
         }
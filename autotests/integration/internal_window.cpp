@@ -76,6 +76,7 @@ private Q_SLOTS:
     void testChangeWindowType_data();
     void testChangeWindowType();
     void testEffectWindow();
+    void testPartialUpdateSwapsBuffers();
 };
 
 class HelperWindow : public QRasterWindow
@@ -797,5 +798,37 @@ void InternalWindowTest::testEffectWindow()
 
 }
 
+void InternalWindowTest::testPartialUpdateSwapsBuffers()
+{
+    // this test verifies that a partial update is presented in a fresh buffer which already
+    // carries the rest of the window contents, and only the updated area is damaged
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    HelperWindow win;
+    win.setGeometry(0, 0, 100, 100);
+    win.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+    auto internalClient = clientAddedSpy.first().first().value<InternalClient *>();
+    QVERIFY(internalClient);
+
+    const QImage firstImage = internalClient->internalImageObject();
+    QVERIFY(!firstImage.isNull());
+    QCOMPARE(firstImage.pixelColor(50, 50), QColor(Qt::red));
+
+    QSignalSpy damagedSpy(internalClient, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    win.update(QRect(0, 0, 10, 10));
+    QVERIFY(damagedSpy.wait());
+    QCOMPARE(damagedSpy.count(), 1);
+    QCOMPARE(damagedSpy.first().at(1).toRect(), QRect(0, 0, 10, 10));
+
+    const QImage secondImage = internalClient->internalImageObject();
+    QVERIFY(secondImage.constBits() != firstImage.constBits());
+    QCOMPARE(secondImage.size(), firstImage.size());
+    QCOMPARE(secondImage.pixelColor(5, 5), QColor(Qt::red));
+    QCOMPARE(secondImage.pixelColor(50, 50), QColor(Qt::red));
+    QCOMPARE(firstImage.pixelColor(50, 50), QColor(Qt::red));
+}
+
 WAYLANDTEST_MAIN(KWin::InternalWindowTest)
 #include "internal_window.moc"
@@ -0,0 +1,152 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "input.h"
+#include "platform.h"
+#include "wayland_server.h"
+
+#include <KGlobalAccel>
+
+#include <QAction>
+
+#include <linux/input.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_key_filter_benchmark-0");
+
+class KeyFilterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testRegisteredShortcutTriggers();
+    void benchmarkKeys_data();
+    void benchmarkKeys();
+
+private:
+    void registerShortcuts(int count);
+
+    QList<QAction *> m_actions;
+};
+
+void KeyFilterBenchmark::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+    qputenv("KWIN_XKB_DEFAULT_KEYMAP", "1");
+    qputenv("XKB_DEFAULT_RULES", "evdev");
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void KeyFilterBenchmark::cleanup()
+{
+    for (QAction *action : qAsConst(m_actions)) {
+        KGlobalAccel::self()->removeAllShortcuts(action);
+    }
+    qDeleteAll(m_actions);
+    m_actions.clear();
+}
+
+void KeyFilterBenchmark::registerShortcuts(int count)
+{
+    static const int modifiers[] = {
+        Qt::CTRL | Qt::ALT,
+        Qt::CTRL | Qt::META,
+        Qt::ALT | Qt::META,
+        Qt::CTRL | Qt::ALT | Qt::META,
+    };
+    for (int i = 0; i < count; ++i) {
+        const QKeySequence sequence(modifiers[(i / 26) % 4] | (Qt::Key_A + i % 26));
+        QAction *action = new QAction(nullptr);
+        action->setProperty("componentName", QStringLiteral(UKUI_KWIN_NAME));
+        action->setObjectName(QStringLiteral("key-filter-benchmark-%1").arg(i));
+        KGlobalAccel::self()->setShortcut(action, QList<QKeySequence>{sequence}, KGlobalAccel::NoAutoloading);
+        input()->registerShortcut(sequence, action);
+        m_actions << action;
+    }
+}
+
+void KeyFilterBenchmark::testRegisteredShortcutTriggers()
+{
+    // this test verifies that a shortcut registered after the plugin got enabled is part of
+    // the lookup table pushed to the GlobalShortcutsManager
+    registerShortcuts(30);
+    QSignalSpy triggeredSpy(m_actions.last(), &QAction::triggered);
+    QVERIFY(triggeredSpy.isValid());
+
+    // the last action is Ctrl+Meta+D
+    quint32 timestamp = 0;
+    kwinApp()->platform()->keyboardKeyPressed(KEY_LEFTCTRL, timestamp++);
+    kwinApp()->platform()->keyboardKeyPressed(KEY_LEFTMETA, timestamp++);
+    kwinApp()->platform()->keyboardKeyPressed(KEY_D, timestamp++);
+    QTRY_COMPARE(triggeredSpy.count(), 1);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_D, timestamp++);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_LEFTMETA, timestamp++);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_LEFTCTRL, timestamp++);
+
+    // a combination which is not registered must not trigger anything
+    kwinApp()->platform()->keyboardKeyPressed(KEY_LEFTCTRL, timestamp++);
+    kwinApp()->platform()->keyboardKeyPressed(KEY_LEFTMETA, timestamp++);
+    kwinApp()->platform()->keyboardKeyPressed(KEY_Z, timestamp++);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_Z, timestamp++);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_LEFTMETA, timestamp++);
+    kwinApp()->platform()->keyboardKeyReleased(KEY_LEFTCTRL, timestamp++);
+    QVERIFY(!triggeredSpy.wait(100));
+    QCOMPARE(triggeredSpy.count(), 1);
+}
+
+void KeyFilterBenchmark::benchmarkKeys_data()
+{
+    QTest::addColumn<int>("shortcutCount");
+
+    QTest::newRow("0") << 0;
+    QTest::newRow("50") << 50;
+    QTest::newRow("100") << 100;
+}
+
+void KeyFilterBenchmark::benchmarkKeys()
+{
+    // a key press and release passing through the spies and the filter chain without
+    // matching a shortcut, which is the case for ordinary typing
+    QFETCH(int, shortcutCount);
+    registerShortcuts(shortcutCount);
+
+    quint32 timestamp = 0;
+    QBENCHMARK {
+        kwinApp()->platform()->keyboardKeyPressed(KEY_X, timestamp++);
+        kwinApp()->platform()->keyboardKeyReleased(KEY_X, timestamp++);
+    }
+}
+
+WAYLANDTEST_MAIN(KeyFilterBenchmark)
+#include "key_filter_benchmark.moc"
@@ -0,0 +1,306 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "options.h"
+#include "outputframescheduler.h"
+#include "platform.h"
+#include "scene.h"
+#include "screens.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "plugins/scenes/qpainter/scene_qpainter.h"
+
+#include <KConfigGroup>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_output_frame_scheduler-0");
+
+class OutputFrameSchedulerTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testSchedulerPerOutput();
+    void testRepaintOnlyAffectedOutput_data();
+    void testRepaintOnlyAffectedOutput();
+    void testRepaintSpanningOutputs();
+    void testPartialRepaintOnSecondaryOutput();
+    void testRenderTimePrediction();
+    void testSchedulersSurviveScreensChange();
+    void testSwapCompletesPerOutput_data();
+    void testSwapCompletesPerOutput();
+
+private:
+    void waitForIdle();
+};
+
+void OutputFrameSchedulerTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(int, 2));
+
+    // disable all effects - we don't want to have them schedule repaints
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QCOMPARE(screens()->count(), 2);
+    waylandServer()->initWorkspace();
+    QVERIFY(Compositor::self());
+    QVERIFY(Compositor::self()->scene());
+    QVERIFY(Compositor::self()->scene()->perScreenRendering());
+}
+
+void OutputFrameSchedulerTest::waitForIdle()
+{
+    auto scene = Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    auto busy = [&schedulers] {
+        return std::any_of(schedulers.begin(), schedulers.end(),
+                           [](OutputFrameScheduler *s) { return s->hasRepaints(); });
+    };
+    while (busy()) {
+        QVERIFY(frameRenderedSpy.wait());
+    }
+    // give the frame timers the chance to go idle
+    QTest::qWait(300);
+}
+
+void OutputFrameSchedulerTest::testSchedulerPerOutput()
+{
+    // every output gets its own scheduler covering the output's geometry
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    QCOMPARE(schedulers.count(), 2);
+    QCOMPARE(outputs.count(), 2);
+    for (int i = 0; i < schedulers.count(); ++i) {
+        QCOMPARE(schedulers.at(i)->output(), outputs.at(i));
+        QCOMPARE(schedulers.at(i)->geometry(), screens()->geometry(i));
+        QVERIFY(schedulers.at(i)->refreshRate() > 0);
+    }
+}
+
+void OutputFrameSchedulerTest::testRepaintOnlyAffectedOutput_data()
+{
+    QTest::addColumn<int>("screen");
+
+    QTest::newRow("first") << 0;
+    QTest::newRow("second") << 1;
+}
+
+void OutputFrameSchedulerTest::testRepaintOnlyAffectedOutput()
+{
+    // damage on one output must not cause a repaint of the other output
+    waitForIdle();
+
+    QFETCH(int, screen);
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    OutputFrameScheduler *damaged = schedulers.at(screen);
+    OutputFrameScheduler *other = schedulers.at(1 - screen);
+    QSignalSpy damagedFrameSpy(damaged, &OutputFrameScheduler::frameRequested);
+    QVERIFY(damagedFrameSpy.isValid());
+    QSignalSpy otherFrameSpy(other, &OutputFrameScheduler::frameRequested);
+    QVERIFY(otherFrameSpy.isValid());
+
+    const QRect repaint(damaged->geometry().topLeft() + QPoint(100, 100), QSize(10, 10));
+    Compositor::self()->addRepaint(repaint);
+    QCOMPARE(damaged->repaints(), QRegion(repaint));
+    QVERIFY(!other->hasRepaints());
+
+    QVERIFY(damagedFrameSpy.wait());
+    QVERIFY(!damaged->hasRepaints());
+    QVERIFY(otherFrameSpy.isEmpty());
+}
+
+void OutputFrameSchedulerTest::testRepaintSpanningOutputs()
+{
+    // a repaint crossing the output boundary is split between both outputs
+    waitForIdle();
+
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    const QRect repaint(1270, 0, 20, 20);
+    Compositor::self()->addRepaint(repaint);
+    QCOMPARE(schedulers.at(0)->repaints(), QRegion(1270, 0, 10, 20));
+    QCOMPARE(schedulers.at(1)->repaints(), QRegion(1280, 0, 10, 20));
+
+    QSignalSpy secondFrameSpy(schedulers.at(1), &OutputFrameScheduler::frameRequested);
+    QVERIFY(secondFrameSpy.isValid());
+    QVERIFY(secondFrameSpy.wait());
+    QVERIFY(!schedulers.at(1)->hasRepaints());
+}
+
+void OutputFrameSchedulerTest::testPartialRepaintOnSecondaryOutput()
+{
+    // a small repaint on the second output only repaints the damaged area, the rest of
+    // the output's buffer is kept from the previous frame
+    waitForIdle();
+
+    auto scene = Compositor::self()->scene();
+    QCOMPARE(scene->compositingType(), QPainterCompositing);
+    QPainterBackend *backend = static_cast<SceneQPainter *>(scene)->backend();
+    QVERIFY(!backend->needsFullRepaintForScreen(1));
+    QImage *buffer = backend->bufferForScreen(1);
+    QVERIFY(buffer);
+
+    // mark the buffer, the repainted area loses the mark
+    buffer->fill(Qt::red);
+    const QRect output = screens()->geometry(1);
+    const QRect repaint(output.topLeft() + QPoint(100, 100), QSize(10, 10));
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->addRepaint(repaint);
+    QVERIFY(frameRenderedSpy.wait());
+
+    const QRect local = repaint.translated(-output.topLeft());
+    QCOMPARE(buffer->pixelColor(local.center()), QColor(Qt::black));
+    QCOMPARE(buffer->pixelColor(local.topLeft() - QPoint(1, 1)), QColor(Qt::red));
+    QCOMPARE(buffer->pixelColor(local.bottomRight() + QPoint(2, 2)), QColor(Qt::red));
+    QCOMPARE(buffer->pixelColor(QPoint(500, 500)), QColor(Qt::red));
+    QVERIFY(!backend->needsFullRepaintForScreen(1));
+}
+
+void OutputFrameSchedulerTest::testRenderTimePrediction()
+{
+    // the predicted render time follows the slowest of the recent frames
+    OutputFrameScheduler scheduler(nullptr, QRect(0, 0, 100, 100), 60000);
+    scheduler.configure(true, false, options->maxFpsInterval());
+    QCOMPARE(scheduler.predictedRenderTime(), options->vBlankTime());
+
+    const qint64 ms = 1000 * 1000;
+    for (int i = 0; i < 10; ++i) {
+        scheduler.frameRendered(2 * ms);
+    }
+    QCOMPARE(scheduler.lastRenderTime(), 2 * ms);
+    QCOMPARE(scheduler.predictedRenderTime(), 2 * ms);
+
+    scheduler.frameRendered(5 * ms);
+    scheduler.frameRendered(3 * ms);
+    QCOMPARE(scheduler.lastRenderTime(), 3 * ms);
+    QCOMPARE(scheduler.predictedRenderTime(), 5 * ms);
+
+    // the slow frame leaves the window again
+    for (int i = 0; i < 32; ++i) {
+        scheduler.frameRendered(3 * ms);
+    }
+    QCOMPARE(scheduler.predictedRenderTime(), 3 * ms);
+
+    // a prediction longer than a refresh cycle is pointless
+    scheduler.frameRendered(100 * ms);
+    QVERIFY(scheduler.predictedRenderTime() < 1000 * ms / 60);
+}
+
+void OutputFrameSchedulerTest::testSchedulersSurviveScreensChange()
+{
+    // a change of the screens keeps the schedulers of the remaining outputs together
+    // with their pending swap and repaints
+    waitForIdle();
+
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    QCOMPARE(schedulers.count(), 2);
+    OutputFrameScheduler *first = schedulers.at(0);
+    OutputFrameScheduler *second = schedulers.at(1);
+    QSignalSpy destroyedSpy(first, &QObject::destroyed);
+    QVERIFY(destroyedSpy.isValid());
+
+    Compositor::self()->aboutToSwapBuffers(first->output());
+    QVERIFY(first->isSwapPending());
+    QVERIFY(!second->isSwapPending());
+
+    emit screens()->changed();
+    QCOMPARE(Compositor::self()->frameSchedulers(), schedulers);
+    QVERIFY(destroyedSpy.isEmpty());
+    QVERIFY(first->isSwapPending());
+    QVERIFY(!second->isSwapPending());
+    QCOMPARE(first->geometry(), screens()->geometry(0));
+    QCOMPARE(second->geometry(), screens()->geometry(1));
+
+    // completing the swap composites the repaint queued in the meantime
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->bufferSwapComplete(first->output());
+    QVERIFY(!first->isSwapPending());
+    QVERIFY(frameRenderedSpy.wait());
+    waitForIdle();
+    QVERIFY(!first->hasRepaints());
+}
+
+void OutputFrameSchedulerTest::testSwapCompletesPerOutput_data()
+{
+    QTest::addColumn<int>("screen");
+
+    QTest::newRow("first") << 0;
+    QTest::newRow("second") << 1;
+}
+
+void OutputFrameSchedulerTest::testSwapCompletesPerOutput()
+{
+    // Mirrors the nested Wayland backend with two outputs: both outputs are presented,
+    // but only one of them gets its frame callback. That output has to continue
+    // compositing while the other one still waits for its swap.
+    waitForIdle();
+
+    QFETCH(int, screen);
+    const auto schedulers = Compositor::self()->frameSchedulers();
+    OutputFrameScheduler *presented = schedulers.at(screen);
+    OutputFrameScheduler *other = schedulers.at(1 - screen);
+
+    Compositor::self()->aboutToSwapBuffers(presented->output());
+    Compositor::self()->aboutToSwapBuffers(other->output());
+    QVERIFY(presented->isSwapPending());
+    QVERIFY(other->isSwapPending());
+
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    const QRect repaint(presented->geometry().topLeft() + QPoint(100, 100), QSize(10, 10));
+    Compositor::self()->addRepaint(repaint);
+    Compositor::self()->bufferSwapComplete(presented->output());
+    QVERIFY(!presented->isSwapPending());
+    QVERIFY(other->isSwapPending());
+
+    QVERIFY(frameRenderedSpy.wait());
+    QVERIFY(!presented->hasRepaints());
+    QVERIFY(other->isSwapPending());
+
+    Compositor::self()->bufferSwapComplete(other->output());
+    QVERIFY(!other->isSwapPending());
+}
+
+WAYLANDTEST_MAIN(OutputFrameSchedulerTest)
+#include "output_frame_scheduler_test.moc"
@@ -0,0 +1,202 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "placement.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "windowgeometryindex.h"
+#include "workspace.h"
+#include "xdgshellclient.h"
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_placement_benchmark-0");
+
+class PlacementBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testIndexFollowsGeometry();
+
+    void benchmarkPlaceSmart_data();
+    void benchmarkPlaceSmart();
+    void benchmarkSnap_data();
+    void benchmarkSnap();
+    void benchmarkPack_data();
+    void benchmarkPack();
+
+private:
+    void addData();
+    void createWindows(int count);
+
+    QList<AbstractClient *> m_clients;
+    AbstractClient *m_probe = nullptr;
+};
+
+void PlacementBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::XdgShellClient *>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void PlacementBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void PlacementBenchmark::cleanup()
+{
+    m_clients.clear();
+    m_probe = nullptr;
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(waylandServer()->clients().isEmpty());
+    QCOMPARE(workspace()->geometryIndex()->count(), 0);
+}
+
+void PlacementBenchmark::addData()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("50") << 50;
+    QTest::newRow("200") << 200;
+    QTest::newRow("1000") << 1000;
+}
+
+void PlacementBenchmark::createWindows(int count)
+{
+    // scatter the windows over the screen, so that smart placement has to try a lot of positions
+    for (int i = 0; i < count + 1; ++i) {
+        KWayland::Client::Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        KWayland::Client::XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        XdgShellClient *client = Test::renderAndWaitForShown(surface, QSize(200, 150), Qt::blue);
+        QVERIFY(client);
+        if (i == count) {
+            m_probe = client;
+            break;
+        }
+        client->move(QPoint((i * 97) % 1080, (i * 61) % 874));
+        m_clients << client;
+    }
+    QCOMPARE(workspace()->geometryIndex()->count(), count + 1);
+}
+
+void PlacementBenchmark::testIndexFollowsGeometry()
+{
+    createWindows(2);
+    AbstractClient *client = m_clients.first();
+    QVERIFY(workspace()->geometryIndex()->contains(client));
+
+    client->move(QPoint(1000, 800));
+    QVERIFY(workspace()->geometryIndex()->intersecting(QRect(1100, 900, 10, 10)).contains(client));
+    client->move(QPoint(0, 0));
+    QVERIFY(!workspace()->geometryIndex()->intersecting(QRect(1100, 900, 10, 10)).contains(client));
+    QVERIFY(workspace()->geometryIndex()->intersecting(QRect(10, 10, 10, 10)).contains(client));
+
+    // the Clients are returned in the order they got managed
+    for (AbstractClient *c : qAsConst(m_clients)) {
+        c->move(QPoint(100, 100));
+    }
+    m_probe->move(QPoint(100, 100));
+    const auto found = workspace()->geometryIndex()->intersecting(QRect(0, 0, 1280, 1024));
+    QCOMPARE(found.count(), 3);
+    QCOMPARE(found.at(0), m_clients.at(0));
+    QCOMPARE(found.at(1), m_clients.at(1));
+    QCOMPARE(found.at(2), m_probe);
+}
+
+void PlacementBenchmark::benchmarkPlaceSmart_data()
+{
+    addData();
+}
+
+void PlacementBenchmark::benchmarkPlaceSmart()
+{
+    QFETCH(int, count);
+    createWindows(count);
+
+    const QRect area = workspace()->clientArea(PlacementArea, m_probe);
+    QBENCHMARK {
+        Placement::self()->placeSmart(m_probe, area);
+    }
+}
+
+void PlacementBenchmark::benchmarkSnap_data()
+{
+    addData();
+}
+
+void PlacementBenchmark::benchmarkSnap()
+{
+    QFETCH(int, count);
+    createWindows(count);
+
+    // what an interactive move does on every pointer motion
+    int i = 0;
+    QBENCHMARK {
+        workspace()->adjustClientPosition(m_probe, QPoint(i % 1080, (i * 3) % 874), true);
+        ++i;
+    }
+}
+
+void PlacementBenchmark::benchmarkPack_data()
+{
+    addData();
+}
+
+void PlacementBenchmark::benchmarkPack()
+{
+    QFETCH(int, count);
+    createWindows(count);
+
+    m_probe->move(QPoint(540, 437));
+    QBENCHMARK {
+        workspace()->packPositionLeft(m_probe, m_probe->frameGeometry().left(), true);
+        workspace()->packPositionRight(m_probe, m_probe->frameGeometry().right(), true);
+        workspace()->packPositionUp(m_probe, m_probe->frameGeometry().top(), true);
+        workspace()->packPositionDown(m_probe, m_probe->frameGeometry().bottom(), true);
+    }
+}
+
+WAYLANDTEST_MAIN(PlacementBenchmark)
+#include "placement_benchmark.moc"
@@ -0,0 +1,151 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xdgshellclient.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_opengl_benchmark-0");
+
+class SceneOpenGLBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void benchmarkFrame_data();
+    void benchmarkFrame();
+};
+
+void SceneOpenGLBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::XdgShellClient *>();
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - windows are only batched if no effect paints them
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+    QVERIFY(Compositor::self());
+}
+
+void SceneOpenGLBenchmark::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    if (effectsImpl) {
+        effectsImpl->unloadAllEffects();
+    }
+    Test::destroyWaylandConnection();
+}
+
+void SceneOpenGLBenchmark::benchmarkFrame_data()
+{
+    QTest::addColumn<bool>("batching");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("blur");
+
+    QTest::newRow("10 windows, per window") << false << 10 << false;
+    QTest::newRow("10 windows, batched") << true << 10 << false;
+    QTest::newRow("40 windows, per window") << false << 40 << false;
+    QTest::newRow("40 windows, batched") << true << 40 << false;
+    // the blur effect takes part in drawing windows, but doesn't paint unblurred ones
+    QTest::newRow("40 windows, per window, blur") << false << 40 << true;
+    QTest::newRow("40 windows, batched, blur") << true << 40 << true;
+}
+
+void SceneOpenGLBenchmark::benchmarkFrame()
+{
+    // this test measures the time to paint a full frame of untransformed
+    // windows, run it with LIBGL_ALWAYS_SOFTWARE=1 to get llvmpipe
+    QFETCH(bool, batching);
+    qputenv("KWIN_GL_WINDOW_BATCHING", batching ? QByteArrayLiteral("1") : QByteArrayLiteral("0"));
+
+    QSignalSpy sceneCreatedSpy(Compositor::self(), &Compositor::sceneCreated);
+    QVERIFY(sceneCreatedSpy.isValid());
+    Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+    auto scene = Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), KWin::OpenGL2Compositing);
+
+    QFETCH(bool, blur);
+    if (blur && !static_cast<EffectsHandlerImpl *>(effects)->loadEffect(QStringLiteral("blur"))) {
+        QSKIP("The blur effect is not supported");
+    }
+
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QFETCH(int, count);
+    for (int i = 0; i < count; ++i) {
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        // alternate opaque and translucent windows
+        const QColor color = i % 2 ? QColor(255, 0, 0, 128) : Qt::blue;
+        XdgShellClient *client = Test::renderAndWaitForShown(surface, QSize(400, 300), color, QImage::Format_ARGB32_Premultiplied);
+        QVERIFY(client);
+        client->move(QPoint((i * 20) % 880, (i * 15) % 724));
+    }
+
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QBENCHMARK {
+        Compositor::self()->addRepaintFull();
+        QVERIFY(frameRenderedSpy.wait());
+    }
+}
+
+WAYLANDTEST_MAIN(SceneOpenGLBenchmark)
+#include "scene_opengl_benchmark.moc"
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KConfigGroup>
 
 #include <KWayland/Client/seat.h>
+#include <KWayland/Client/shm_pool.h>
 #include <KWayland/Client/surface.h>
 #include <KWayland/Client/pointer.h>
 #include <KWayland/Server/buffer_interface.h>
@@ -43,7 +44,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xcb_icccm.h>
 
 using namespace KWin;
-static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_qpainter-0");
+// the tests are run with and without rasterizing the frames on multiple threads
+#ifndef QPAINTER_RENDER_THREADS
+#define QPAINTER_RENDER_THREADS 4
+#endif
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_qpainter-%1").arg(QPAINTER_RENDER_THREADS);
 
 class SceneQPainterTest : public QObject
 {
@@ -56,6 +61,9 @@ private Q_SLOTS:
     void testWindow_data();
     void testWindow();
     void testWindowScaled();
+    void testWindowPartialDamage();
+    void testOverlappingWindows();
+    void testTranslucentWindow();
     void testCompositorRestart_data();
     void testCompositorRestart();
     void testX11Window();
@@ -95,6 +103,7 @@ void SceneQPainterTest::initTestCase()
     }
     qputenv("XCURSOR_SIZE", QByteArrayLiteral("24"));
     qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+    qputenv("KWIN_QPAINTER_RENDER_THREADS", QByteArray::number(QPAINTER_RENDER_THREADS));
 
     kwinApp()->start();
     QVERIFY(workspaceCreatedSpy.wait());
@@ -253,6 +262,136 @@ void SceneQPainterTest::testWindowScaled()
     QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
 }
 
+void SceneQPainterTest::testWindowPartialDamage()
+{
+    // this test verifies that a buffer which is only partially damaged is rendered correctly
+    KWin::Cursor::setPos(1000, 900);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> s(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss(Test::createXdgShellStableSurface(s.data()));
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+
+    QImage img(QSize(200, 300), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::blue);
+    Test::render(s.data(), img);
+    QVERIFY(Test::waitForWaylandWindowShown());
+    if (frameRenderedSpy.isEmpty()) {
+        QVERIFY(frameRenderedSpy.wait());
+    }
+
+    QImage referenceImage(QSize(1280, 1024), QImage::Format_RGB32);
+    referenceImage.fill(Qt::black);
+    QPainter painter(&referenceImage);
+    painter.fillRect(0, 0, 200, 300, Qt::blue);
+    const QImage cursorImage = kwinApp()->platform()->softwareCursor();
+    QVERIFY(!cursorImage.isNull());
+    painter.drawImage(KWin::Cursor::pos() - kwinApp()->platform()->softwareCursorHotspot(), cursorImage);
+    QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
+
+    // only damage the parts which changed in a new buffer
+    QPainter surfacePainter(&img);
+    surfacePainter.fillRect(10, 20, 30, 40, Qt::red);
+    s->attachBuffer(Test::waylandShmPool()->createBuffer(img));
+    s->damage(QRect(10, 20, 30, 40));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(frameRenderedSpy.wait());
+    painter.fillRect(10, 20, 30, 40, Qt::red);
+    QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
+
+    // a second partial update has to keep the previous one
+    surfacePainter.fillRect(100, 150, 50, 50, Qt::green);
+    s->attachBuffer(Test::waylandShmPool()->createBuffer(img));
+    s->damage(QRect(100, 150, 50, 50));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(frameRenderedSpy.wait());
+    painter.fillRect(100, 150, 50, 50, Qt::green);
+    QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
+}
+
+void SceneQPainterTest::testOverlappingWindows()
+{
+    // this test verifies that overlapping windows crossing the bands rasterized
+    // on different threads are rendered correctly
+    KWin::Cursor::setPos(1000, 900);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+
+    QImage referenceImage(QSize(1280, 1024), QImage::Format_RGB32);
+    referenceImage.fill(Qt::black);
+    QPainter painter(&referenceImage);
+
+    const QVector<QPair<QRect, QColor>> windows = {
+        {QRect(10, 15, 300, 500), Qt::blue},
+        {QRect(150, 100, 400, 333), Qt::red},
+        {QRect(99, 301, 97, 700), Qt::green}
+    };
+    QVector<Surface *> surfaces;
+    for (const auto &window : windows) {
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        surfaces << surface;
+
+        XdgShellClient *client = Test::renderAndWaitForShown(surface, window.first.size(), window.second);
+        QVERIFY(client);
+        client->move(window.first.topLeft());
+        painter.fillRect(window.first, window.second);
+    }
+    const QImage cursorImage = kwinApp()->platform()->softwareCursor();
+    QVERIFY(!cursorImage.isNull());
+    painter.drawImage(KWin::Cursor::pos() - kwinApp()->platform()->softwareCursorHotspot(), cursorImage);
+
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
+
+    // deletes the shell surfaces as well
+    qDeleteAll(surfaces);
+}
+
+void SceneQPainterTest::testTranslucentWindow()
+{
+    // this test verifies that a translucent window is blended with its opacity
+    KWin::Cursor::setPos(1000, 900);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> s(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss(Test::createXdgShellStableSurface(s.data()));
+    auto client = Test::renderAndWaitForShown(s.data(), QSize(200, 300), Qt::red);
+    QVERIFY(client);
+    client->move(QPoint(100, 100));
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    client->setOpacity(0.5);
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+
+    // the raster engine may round the blended pixels differently
+    const QImage *renderBuffer = scene->qpainterRenderBuffer();
+    const QRect geometry(QPoint(100, 100), QSize(200, 300));
+    for (const QPoint &p : {geometry.topLeft(), geometry.center(), geometry.bottomRight()}) {
+        const QRgb pixel = renderBuffer->pixel(p);
+        QVERIFY(qAbs(qRed(pixel) - 128) <= 1);
+        QCOMPARE(qGreen(pixel), 0);
+        QCOMPARE(qBlue(pixel), 0);
+    }
+    QCOMPARE(renderBuffer->pixel(geometry.topLeft() - QPoint(1, 1)), qRgb(0, 0, 0));
+}
+
 void SceneQPainterTest::testCompositorRestart_data()
 {
     QTest::addColumn<Test::XdgShellSurfaceType>("type");
@@ -0,0 +1,192 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "scripting/scripting_model.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xdgshellclient.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+using namespace KWin::ScriptingClientModel;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scripting_clientmodel_benchmark-0");
+
+class ClientModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testBatchedInsert();
+
+    void benchmarkPopulate_data();
+    void benchmarkPopulate();
+    void benchmarkReInit_data();
+    void benchmarkReInit();
+
+private:
+    void addData();
+    void createWindows(int count);
+    void walkModel(ClientModel *model);
+
+    QList<XdgShellClient *> m_clients;
+};
+
+void ClientModelBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::XdgShellClient *>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void ClientModelBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void ClientModelBenchmark::cleanup()
+{
+    m_clients.clear();
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(waylandServer()->clients().isEmpty());
+}
+
+void ClientModelBenchmark::addData()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+}
+
+void ClientModelBenchmark::createWindows(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        KWayland::Client::Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        KWayland::Client::XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        XdgShellClient *client = Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+        QVERIFY(client);
+        m_clients << client;
+    }
+}
+
+void ClientModelBenchmark::walkModel(ClientModel *model)
+{
+    // what a QML view does for every row it creates a delegate for
+    const int rows = model->rowCount();
+    for (int row = 0; row < rows; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        QVERIFY(index.isValid());
+        QVERIFY(!model->parent(index).isValid());
+        QVERIFY(model->data(index, ClientModel::ClientRole).value<AbstractClient *>());
+    }
+}
+
+void ClientModelBenchmark::testBatchedInsert()
+{
+    // including previously excluded Clients again announces them as a single range of rows
+    createWindows(10);
+    for (int i = 0; i < m_clients.count(); i += 2) {
+        m_clients.at(i)->minimize();
+    }
+    SimpleClientModel model;
+    model.setExclusions(ClientModel::MinimizedExclusion);
+    QCOMPARE(model.rowCount(), 5);
+
+    QSignalSpy rowsInsertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QVERIFY(rowsInsertedSpy.isValid());
+    model.setExclusions(ClientModel::NoExclusion);
+    QCOMPARE(model.rowCount(), 10);
+    QCOMPARE(rowsInsertedSpy.count(), 1);
+    QCOMPARE(rowsInsertedSpy.first().at(1).toInt(), 5);
+    QCOMPARE(rowsInsertedSpy.first().at(2).toInt(), 9);
+    walkModel(&model);
+
+    // removing a Client keeps the rows of the others consistent
+    QSignalSpy rowsRemovedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QVERIFY(rowsRemovedSpy.isValid());
+    model.setExclusions(ClientModel::MinimizedExclusion);
+    QCOMPARE(rowsRemovedSpy.count(), 5);
+    QCOMPARE(model.rowCount(), 5);
+    walkModel(&model);
+}
+
+void ClientModelBenchmark::benchmarkPopulate_data()
+{
+    addData();
+}
+
+void ClientModelBenchmark::benchmarkPopulate()
+{
+    QFETCH(int, count);
+    createWindows(count);
+
+    QBENCHMARK {
+        SimpleClientModel model;
+        QCOMPARE(model.rowCount(), count);
+        walkModel(&model);
+    }
+}
+
+void ClientModelBenchmark::benchmarkReInit_data()
+{
+    addData();
+}
+
+void ClientModelBenchmark::benchmarkReInit()
+{
+    QFETCH(int, count);
+    createWindows(count);
+    for (int i = 0; i < m_clients.count(); i += 2) {
+        m_clients.at(i)->minimize();
+    }
+
+    SimpleClientModel model;
+    QCOMPARE(model.rowCount(), count);
+    QBENCHMARK {
+        model.setExclusions(ClientModel::MinimizedExclusion);
+        model.setExclusions(ClientModel::NoExclusion);
+    }
+    QCOMPARE(model.rowCount(), count);
+    walkModel(&model);
+}
+
+WAYLANDTEST_MAIN(ClientModelBenchmark)
+#include "clientmodel_benchmark.moc"
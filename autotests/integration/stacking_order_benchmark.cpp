@@ -0,0 +1,182 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xdgshellclient.h"
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_stacking_order_benchmark-0");
+
+class StackingOrderBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void benchmarkRaise_data();
+    void benchmarkRaise();
+    void benchmarkLower_data();
+    void benchmarkLower();
+    void benchmarkRestack_data();
+    void benchmarkRestack();
+
+private:
+    void addData();
+    void createWindows(int count, bool dialogs);
+
+    QList<AbstractClient *> m_clients;
+};
+
+void StackingOrderBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::XdgShellClient *>();
+
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void StackingOrderBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void StackingOrderBenchmark::cleanup()
+{
+    m_clients.clear();
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(waylandServer()->clients().isEmpty());
+}
+
+void StackingOrderBenchmark::addData()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("dialogs");
+
+    QTest::newRow("100") << 100 << false;
+    QTest::newRow("500") << 500 << false;
+    QTest::newRow("1000") << 1000 << false;
+    QTest::newRow("100 with dialogs") << 100 << true;
+    QTest::newRow("500 with dialogs") << 500 << true;
+    QTest::newRow("1000 with dialogs") << 1000 << true;
+}
+
+void StackingOrderBenchmark::createWindows(int count, bool dialogs)
+{
+    // With dialogs, every main window gets a chain of two dialogs, so the constraints
+    // for transients have to be applied on every restack. Without them, every restack
+    // only moves a single window within the constrained stacking order.
+    KWayland::Client::XdgShellSurface *parent = nullptr;
+    for (int i = 0; i < count; ++i) {
+        KWayland::Client::Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        KWayland::Client::XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        const bool transient = dialogs && i % 3;
+        if (transient) {
+            shellSurface->setTransientFor(parent);
+        }
+        XdgShellClient *client = Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+        QVERIFY(client);
+        QCOMPARE(client->isTransient(), transient);
+        m_clients << client;
+        parent = shellSurface;
+    }
+    QCOMPARE(workspace()->stackingOrder().count(), count);
+}
+
+void StackingOrderBenchmark::benchmarkRaise_data()
+{
+    addData();
+}
+
+void StackingOrderBenchmark::benchmarkRaise()
+{
+    QFETCH(int, count);
+    QFETCH(bool, dialogs);
+    createWindows(count, dialogs);
+
+    int i = 0;
+    QBENCHMARK {
+        // raise a main window together with its dialogs, if it has any
+        workspace()->raiseClient(m_clients.at(i));
+        i = (i + 3) % (count - count % 3);
+    }
+}
+
+void StackingOrderBenchmark::benchmarkLower_data()
+{
+    addData();
+}
+
+void StackingOrderBenchmark::benchmarkLower()
+{
+    QFETCH(int, count);
+    QFETCH(bool, dialogs);
+    createWindows(count, dialogs);
+
+    int i = 0;
+    QBENCHMARK {
+        workspace()->lowerClient(m_clients.at(i));
+        i = (i + 3) % (count - count % 3);
+    }
+}
+
+void StackingOrderBenchmark::benchmarkRestack_data()
+{
+    addData();
+}
+
+void StackingOrderBenchmark::benchmarkRestack()
+{
+    QFETCH(int, count);
+    QFETCH(bool, dialogs);
+    createWindows(count, dialogs);
+
+    int i = 0;
+    QBENCHMARK {
+        // move a window below one in the middle of the stack
+        workspace()->restack(m_clients.at(i), m_clients.at(count / 2), true);
+        i = (i + 3) % (count - count % 3);
+    }
+}
+
+WAYLANDTEST_MAIN(StackingOrderBenchmark)
+#include "stacking_order_benchmark.moc"
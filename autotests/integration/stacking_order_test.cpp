@@ -61,6 +61,7 @@ private Q_SLOTS:
     void testKeepAbove();
     void testKeepBelow();
 
+    void testRestackWithinLayer();
 };
 
 void StackingOrderTest::initTestCase()
@@ -906,5 +907,71 @@ void StackingOrderTest::testKeepBelow()
     QCOMPARE(workspace()->stackingOrder(), (QList<Toplevel *>{clientB, clientA}));
 }
 
+void StackingOrderTest::testRestackWithinLayer()
+{
+    // This test verifies that raising, lowering and restacking windows without
+    // transients keeps other windows where the constraints put them.
+
+    auto createClient = [](const QColor &color,
+                           KWayland::Client::XdgShellSurface *parent = nullptr) -> XdgShellClient * {
+        KWayland::Client::Surface *surface = Test::createSurface(Test::waylandCompositor());
+        KWayland::Client::XdgShellSurface *shellSurface =
+            Test::createXdgShellStableSurface(surface, surface);
+        if (parent) {
+            shellSurface->setTransientFor(parent);
+        }
+        return Test::renderAndWaitForShown(surface, QSize(128, 128), color);
+    };
+
+    XdgShellClient *clientA = createClient(Qt::green);
+    QVERIFY(clientA);
+    XdgShellClient *clientB = createClient(Qt::green);
+    QVERIFY(clientB);
+
+    KWayland::Client::Surface *parentSurface = Test::createSurface(Test::waylandCompositor());
+    QVERIFY(parentSurface);
+    KWayland::Client::XdgShellSurface *parentShellSurface =
+        Test::createXdgShellStableSurface(parentSurface, parentSurface);
+    QVERIFY(parentShellSurface);
+    XdgShellClient *parent = Test::renderAndWaitForShown(parentSurface, QSize(256, 256), Qt::blue);
+    QVERIFY(parent);
+    XdgShellClient *transient = createClient(Qt::red, parentShellSurface);
+    QVERIFY(transient);
+    QVERIFY(transient->isTransient());
+
+    XdgShellClient *keptAbove = createClient(Qt::yellow);
+    QVERIFY(keptAbove);
+    {
+        StackingUpdatesBlocker blocker(workspace());
+        keptAbove->setKeepAbove(true);
+    }
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientA, clientB, parent, transient, keptAbove}));
+
+    // Raising the parent puts it above the transient in the unconstrained order,
+    // the transient has to stay above it nevertheless.
+    workspace()->raiseClient(parent);
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientA, clientB, parent, transient, keptAbove}));
+
+    // A raised window goes to the top of its layer.
+    workspace()->raiseClient(clientA);
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientB, parent, transient, clientA, keptAbove}));
+
+    // A lowered window goes to the bottom of its layer.
+    workspace()->lowerClient(clientA);
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientA, clientB, parent, transient, keptAbove}));
+    workspace()->lowerClient(keptAbove);
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientA, clientB, parent, transient, keptAbove}));
+
+    // Restacking below the transient puts the window below the transient's parent.
+    workspace()->restack(clientA, transient, true);
+    QCOMPARE(workspace()->stackingOrder(),
+             (QList<Toplevel *>{clientB, clientA, parent, transient, keptAbove}));
+}
+
 WAYLANDTEST_MAIN(StackingOrderTest)
 #include "stacking_order_test.moc"
@@ -53,6 +53,7 @@ private Q_SLOTS:
     void testFullscreenLayerWithActiveWaylandWindow();
     void testFocusInWithWaylandLastActiveWindow();
     void testX11WindowId();
+    void testX11WindowIndex();
     void testCaptionChanges();
     void testCaptionWmName();
     void testCaptionMultipleWindows();
@@ -406,6 +407,65 @@ void X11ClientTest::testX11WindowId()
     QCOMPARE(deletedUuid, uuid);
 }
 
+void X11ClientTest::testX11WindowIndex()
+{
+    // this test verifies that all windows of a client can be looked up through the window index
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> c(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(c.data()));
+    const QRect windowGeometry(0, 0, 100, 200);
+    xcb_window_t w = xcb_generate_id(c.data());
+    xcb_create_window(c.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                      windowGeometry.x(),
+                      windowGeometry.y(),
+                      windowGeometry.width(),
+                      windowGeometry.height(),
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+    xcb_size_hints_t hints;
+    memset(&hints, 0, sizeof(hints));
+    xcb_icccm_size_hints_set_position(&hints, 1, windowGeometry.x(), windowGeometry.y());
+    xcb_icccm_size_hints_set_size(&hints, 1, windowGeometry.width(), windowGeometry.height());
+    xcb_icccm_set_wm_normal_hints(c.data(), w, &hints);
+    xcb_map_window(c.data(), w);
+    xcb_flush(c.data());
+
+    QSignalSpy windowCreatedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(windowCreatedSpy.isValid());
+    QVERIFY(windowCreatedSpy.wait());
+    X11Client *client = windowCreatedSpy.first().first().value<X11Client *>();
+    QVERIFY(client);
+    QCOMPARE(client->window(), w);
+
+    QCOMPARE(workspace()->findX11Toplevel(client->window()), client);
+    QCOMPARE(workspace()->findX11Toplevel(client->wrapperId()), client);
+    QCOMPARE(workspace()->findX11Toplevel(client->frameId()), client);
+    QCOMPARE(workspace()->findClient(Predicate::WindowMatch, client->window()), client);
+    QCOMPARE(workspace()->findClient(Predicate::WrapperIdMatch, client->wrapperId()), client);
+    QCOMPARE(workspace()->findClient(Predicate::FrameIdMatch, client->frameId()), client);
+    // the predicate still has to match the kind of window
+    QVERIFY(!workspace()->findClient(Predicate::WindowMatch, client->frameId()));
+    QVERIFY(!workspace()->findClient(Predicate::FrameIdMatch, client->window()));
+    QVERIFY(!workspace()->findUnmanaged(client->window()));
+    if (client->inputId() != XCB_WINDOW_NONE) {
+        QCOMPARE(workspace()->findClient(Predicate::InputIdMatch, client->inputId()), client);
+    }
+
+    const xcb_window_t frame = client->frameId();
+    const xcb_window_t wrapper = client->wrapperId();
+
+    // and destroy the window again
+    xcb_unmap_window(c.data(), w);
+    xcb_flush(c.data());
+
+    QSignalSpy windowClosedSpy(client, &X11Client::windowClosed);
+    QVERIFY(windowClosedSpy.isValid());
+    QVERIFY(windowClosedSpy.wait());
+    QVERIFY(!workspace()->findX11Toplevel(w));
+    QVERIFY(!workspace()->findX11Toplevel(frame));
+    QVERIFY(!workspace()->findX11Toplevel(wrapper));
+    xcb_destroy_window(c.data(), w);
+    c.reset();
+}
+
 void X11ClientTest::testCaptionChanges()
 {
     // verifies that caption is updated correctly when the X11 window updates it
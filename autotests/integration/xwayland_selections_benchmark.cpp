@@ -0,0 +1,204 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "platform.h"
+#include "xdgshellclient.h"
+#include "screens.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "../../xwl/databridge.h"
+
+#include <KWayland/Server/datadevice_interface.h>
+
+#include <QProcess>
+#include <QProcessEnvironment>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_xwayland_selections_benchmark-0");
+
+class XwaylandSelectionsBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void benchmarkSync_data();
+    void benchmarkSync();
+
+private:
+    void sync(const QString &copyPlatform, const QString &pastePlatform, int size);
+
+    QProcess *m_copyProcess = nullptr;
+    QProcess *m_pasteProcess = nullptr;
+};
+
+void XwaylandSelectionsBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::XdgShellClient *>();
+    qRegisterMetaType<KWin::AbstractClient*>();
+    qRegisterMetaType<QProcess::ExitStatus>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+    // wait till the DataBridge sync data device is created
+    while (Xwl::DataBridge::self()->dataDeviceIface() == nullptr) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    QVERIFY(Xwl::DataBridge::self()->dataDeviceIface() != nullptr);
+}
+
+void XwaylandSelectionsBenchmark::cleanup()
+{
+    if (m_copyProcess) {
+        m_copyProcess->terminate();
+        QVERIFY(m_copyProcess->waitForFinished());
+        m_copyProcess = nullptr;
+    }
+    if (m_pasteProcess) {
+        m_pasteProcess->terminate();
+        QVERIFY(m_pasteProcess->waitForFinished());
+        m_pasteProcess = nullptr;
+    }
+}
+
+void XwaylandSelectionsBenchmark::benchmarkSync_data()
+{
+    QTest::addColumn<QString>("copyPlatform");
+    QTest::addColumn<QString>("pastePlatform");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("x11->wayland 1MB") << QStringLiteral("xcb") << QStringLiteral("wayland") << 1024 * 1024;
+    QTest::newRow("wayland->x11 1MB") << QStringLiteral("wayland") << QStringLiteral("xcb") << 1024 * 1024;
+    QTest::newRow("x11->wayland 50MB") << QStringLiteral("xcb") << QStringLiteral("wayland") << 50 * 1024 * 1024;
+    QTest::newRow("wayland->x11 50MB") << QStringLiteral("wayland") << QStringLiteral("xcb") << 50 * 1024 * 1024;
+}
+
+void XwaylandSelectionsBenchmark::benchmarkSync()
+{
+    // this test measures the throughput of large incremental clipboard transfers
+    QFETCH(QString, copyPlatform);
+    QFETCH(QString, pastePlatform);
+    QFETCH(int, size);
+    QBENCHMARK_ONCE {
+        sync(copyPlatform, pastePlatform, size);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+    }
+}
+
+void XwaylandSelectionsBenchmark::sync(const QString &copyPlatform, const QString &pastePlatform, int size)
+{
+    const QStringList arguments{QString::number(size)};
+    const QString copy = QFINDTESTDATA(QStringLiteral("copy"));
+    QVERIFY(!copy.isEmpty());
+    const QString paste = QFINDTESTDATA(QStringLiteral("paste"));
+    QVERIFY(!paste.isEmpty());
+
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    QSignalSpy shellClientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(shellClientAddedSpy.isValid());
+    QSignalSpy clipboardChangedSpy(Xwl::DataBridge::self()->dataDeviceIface(), &KWayland::Server::DataDeviceInterface::selectionChanged);
+    QVERIFY(clipboardChangedSpy.isValid());
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+
+    // start the copy process
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), copyPlatform);
+    environment.insert(QStringLiteral("WAYLAND_DISPLAY"), s_socketName);
+    m_copyProcess = new QProcess();
+    m_copyProcess->setProcessEnvironment(environment);
+    m_copyProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_copyProcess->setProgram(copy);
+    m_copyProcess->setArguments(arguments);
+    m_copyProcess->start();
+    QVERIFY(m_copyProcess->waitForStarted());
+
+    AbstractClient *copyClient = nullptr;
+    if (copyPlatform == QLatin1String("xcb")) {
+        QVERIFY(clientAddedSpy.wait());
+        copyClient = clientAddedSpy.first().first().value<AbstractClient*>();
+    } else {
+        QVERIFY(shellClientAddedSpy.wait());
+        copyClient = shellClientAddedSpy.first().first().value<AbstractClient*>();
+    }
+    QVERIFY(copyClient);
+    if (workspace()->activeClient() != copyClient) {
+        workspace()->activateClient(copyClient);
+    }
+    QCOMPARE(workspace()->activeClient(), copyClient);
+    if (copyPlatform == QLatin1String("xcb")) {
+        QVERIFY(clipboardChangedSpy.isEmpty());
+        QVERIFY(clipboardChangedSpy.wait());
+    } else {
+        // give the clipboard enough time to get updated before the paste process creates another window
+        QTest::qWait(250);
+    }
+
+    // start the paste process
+    m_pasteProcess = new QProcess();
+    QSignalSpy finishedSpy(m_pasteProcess, static_cast<void(QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished));
+    QVERIFY(finishedSpy.isValid());
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), pastePlatform);
+    m_pasteProcess->setProcessEnvironment(environment);
+    m_pasteProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_pasteProcess->setProgram(paste);
+    m_pasteProcess->setArguments(arguments);
+    m_pasteProcess->start();
+    QVERIFY(m_pasteProcess->waitForStarted());
+
+    AbstractClient *pasteClient = nullptr;
+    if (pastePlatform == QLatin1String("xcb")) {
+        QVERIFY(clientAddedSpy.wait());
+        pasteClient = clientAddedSpy.last().first().value<AbstractClient*>();
+    } else {
+        QVERIFY(shellClientAddedSpy.wait());
+        pasteClient = shellClientAddedSpy.last().first().value<AbstractClient*>();
+    }
+    QCOMPARE(clientAddedSpy.count(), 1);
+    QCOMPARE(shellClientAddedSpy.count(), 1);
+    QVERIFY(pasteClient);
+
+    if (workspace()->activeClient() != pasteClient) {
+        QSignalSpy clientActivatedSpy(workspace(), &Workspace::clientActivated);
+        QVERIFY(clientActivatedSpy.isValid());
+        workspace()->activateClient(pasteClient);
+        QVERIFY(clientActivatedSpy.wait());
+    }
+    QTRY_COMPARE(workspace()->activeClient(), pasteClient);
+    // large transfers take a while
+    QVERIFY(finishedSpy.wait(60000));
+    QCOMPARE(finishedSpy.first().first().toInt(), 0);
+    delete m_pasteProcess;
+    m_pasteProcess = nullptr;
+    delete m_copyProcess;
+    m_copyProcess = nullptr;
+}
+
+WAYLANDTEST_MAIN(XwaylandSelectionsBenchmark)
+#include "xwayland_selections_benchmark.moc"
@@ -36,6 +36,7 @@ private Q_SLOTS:
     void testInitMouseEvent();
     void testInitKeyEvent_data();
     void testInitKeyEvent();
+    void testKeyEventDeferredText();
     void testInitWheelEvent_data();
     void testInitWheelEvent();
     void testInitSwitchEvent_data();
@@ -117,6 +118,24 @@ void InputEventsTest::testInitKeyEvent()
     QCOMPARE(event.device(), &d);
 }
 
+void InputEventsTest::testKeyEventDeferredText()
+{
+    // this test verifies that a KeyEvent created without text only gets its text once set
+    libinput_device device;
+    Device d(&device);
+
+    KeyEvent event(QEvent::KeyPress, Qt::Key_Space, Qt::NoModifier, 200, 300, false, 400, &d);
+    QVERIFY(!event.isTextResolved());
+    QVERIFY(event.text().isEmpty());
+    QCOMPARE(event.nativeVirtualKey(), 300u);
+    QCOMPARE(event.timestamp(), 400ul);
+    QCOMPARE(event.device(), &d);
+
+    event.setText(QStringLiteral(" "));
+    QVERIFY(event.isTextResolved());
+    QCOMPARE(event.text(), QStringLiteral(" "));
+}
+
 void InputEventsTest::testInitWheelEvent_data()
 {
     QTest::addColumn<Qt::Orientation>("orientation");
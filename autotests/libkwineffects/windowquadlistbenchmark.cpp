@@ -0,0 +1,135 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include <kwineffects.h>
+#include <QTest>
+
+#ifndef GL_TRIANGLES
+#  define GL_TRIANGLES      0x0004
+#endif
+
+using namespace KWin;
+
+class WindowQuadListBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkMakeRegularGrid_data();
+    void benchmarkMakeRegularGrid();
+    void benchmarkMakeInterleavedArrays_data();
+    void benchmarkMakeInterleavedArrays();
+    void benchmarkSplitByType_data();
+    void benchmarkSplitByType();
+
+private:
+    void addGridRows();
+    WindowQuadList windowQuads() const;
+};
+
+static WindowQuad makeQuad(const QRectF &r, WindowQuadType type)
+{
+    WindowQuad quad(type);
+    quad[0] = WindowVertex(r.x(), r.y(), r.x(), r.y());
+    quad[1] = WindowVertex(r.x() + r.width(), r.y(), r.x() + r.width(), r.y());
+    quad[2] = WindowVertex(r.x() + r.width(), r.y() + r.height(), r.x() + r.width(), r.y() + r.height());
+    quad[3] = WindowVertex(r.x(), r.y() + r.height(), r.x(), r.y() + r.height());
+    return quad;
+}
+
+WindowQuadList WindowQuadListBenchmark::windowQuads() const
+{
+    // a decorated 1280x1024 window with a shadow, as built by the Scene
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(-20, -20, 1320, 20), WindowQuadShadow));
+    quads.append(makeQuad(QRectF(-20, 1054, 1320, 20), WindowQuadShadow));
+    quads.append(makeQuad(QRectF(0, 0, 1280, 30), WindowQuadDecoration));
+    quads.append(makeQuad(QRectF(0, 30, 1280, 1024), WindowQuadContents));
+    return quads;
+}
+
+void WindowQuadListBenchmark::addGridRows()
+{
+    // the tesselations WobblyWindowsEffect uses, 20 is the default
+    QTest::addColumn<int>("tesselation");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("20") << 20;
+    QTest::newRow("40") << 40;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid_data()
+{
+    addGridRows();
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid()
+{
+    QFETCH(int, tesselation);
+    const WindowQuadList quads = windowQuads();
+
+    QBENCHMARK {
+        const WindowQuadList grid = quads.makeRegularGrid(tesselation, tesselation);
+        Q_UNUSED(grid)
+    }
+}
+
+void WindowQuadListBenchmark::benchmarkMakeInterleavedArrays_data()
+{
+    addGridRows();
+}
+
+void WindowQuadListBenchmark::benchmarkMakeInterleavedArrays()
+{
+    QFETCH(int, tesselation);
+    const WindowQuadList grid = windowQuads().makeRegularGrid(tesselation, tesselation);
+    QVector<GLVertex2D> vertices(grid.count() * 6);
+
+    QBENCHMARK {
+        grid.makeInterleavedArrays(GL_TRIANGLES, vertices.data(), QMatrix4x4());
+    }
+}
+
+void WindowQuadListBenchmark::benchmarkSplitByType_data()
+{
+    addGridRows();
+}
+
+void WindowQuadListBenchmark::benchmarkSplitByType()
+{
+    // what the OpenGL scene does with the quads of every painted window
+    QFETCH(int, tesselation);
+    const WindowQuadList grid = windowQuads().makeRegularGrid(tesselation, tesselation);
+
+    QBENCHMARK {
+        WindowQuadList contents;
+        WindowQuadList decoration;
+        for (const WindowQuad &quad : grid) {
+            if (quad.type() == WindowQuadContents) {
+                contents.append(quad);
+            } else if (quad.type() == WindowQuadDecoration) {
+                decoration.append(quad);
+            }
+        }
+        QVERIFY(!contents.isEmpty());
+    }
+}
+
+QTEST_MAIN(WindowQuadListBenchmark)
+#include "windowquadlistbenchmark.moc"
@@ -35,6 +35,9 @@ public:
     bool hasActiveFullScreenEffect() const override {
         return false;
     }
+    bool hasFollowingPaintScreenEffects() const override {
+        return false;
+    }
     int activeScreen() const override {
         return 0;
     }
@@ -0,0 +1,157 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../effects/presentwindows/naturallayout.h"
+
+#include <QTest>
+
+using KWin::NaturalLayout;
+
+Q_DECLARE_METATYPE(NaturalLayout::Engine)
+
+static const QRect s_area(0, 0, 1920, 1080);
+
+// A reproducible desktop of mostly overlapping windows.
+static QVector<QRect> createWindows(int count)
+{
+    QVector<QRect> windows;
+    windows.reserve(count);
+    quint32 seed = 42;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 16) % quint32(bound));
+    };
+    for (int i = 0; i < count; ++i) {
+        const QSize size(300 + next(600), 200 + next(500));
+        windows << QRect(QPoint(next(s_area.width() - size.width()), next(s_area.height() - size.height())), size);
+    }
+    return windows;
+}
+
+static double coverage(const QVector<QRect> &targets)
+{
+    qint64 covered = 0;
+    for (const QRect &target : targets) {
+        covered += qint64(target.width()) * target.height();
+    }
+    return covered / double(qint64(s_area.width()) * s_area.height());
+}
+
+class NaturalLayoutTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNoOverlap_data();
+    void testNoOverlap();
+    void testQuality_data();
+    void testQuality();
+    void benchmarkLayout_data();
+    void benchmarkLayout();
+};
+
+void NaturalLayoutTest::testNoOverlap_data()
+{
+    QTest::addColumn<NaturalLayout::Engine>("engine");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("brute force/10") << NaturalLayout::BruteForce << 10;
+    QTest::newRow("brute force/50") << NaturalLayout::BruteForce << 50;
+    QTest::newRow("partitioned/10") << NaturalLayout::Partitioned << 10;
+    QTest::newRow("partitioned/50") << NaturalLayout::Partitioned << 50;
+    QTest::newRow("partitioned/200") << NaturalLayout::Partitioned << 200;
+}
+
+void NaturalLayoutTest::testNoOverlap()
+{
+    QFETCH(NaturalLayout::Engine, engine);
+    QFETCH(int, count);
+    const QVector<QRect> windows = createWindows(count);
+
+    NaturalLayout layout(s_area, 20, true, engine);
+    const QVector<QRect> targets = layout.layout(windows);
+    QCOMPARE(targets.count(), count);
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(targets.at(i).isValid());
+        // rounding while scaling may let neighbours touch, but never overlap
+        const QRect inner = targets.at(i).adjusted(1, 1, -1, -1);
+        for (int j = i + 1; j < count; ++j) {
+            QVERIFY2(!inner.intersects(targets.at(j).adjusted(1, 1, -1, -1)),
+                     qPrintable(QStringLiteral("%1 and %2 overlap").arg(i).arg(j)));
+        }
+    }
+}
+
+void NaturalLayoutTest::testQuality_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("25") << 25;
+    QTest::newRow("50") << 50;
+}
+
+void NaturalLayoutTest::testQuality()
+{
+    // the partitioned engine must not produce a noticeably worse layout than the brute force
+    QFETCH(int, count);
+    const QVector<QRect> windows = createWindows(count);
+
+    NaturalLayout bruteForce(s_area, 20, true, NaturalLayout::BruteForce);
+    const QVector<QRect> bruteForceTargets = bruteForce.layout(windows);
+    NaturalLayout partitioned(s_area, 20, true, NaturalLayout::Partitioned);
+    const QVector<QRect> partitionedTargets = partitioned.layout(windows);
+    QCOMPARE(bruteForceTargets.count(), count);
+    QCOMPARE(partitionedTargets.count(), count);
+
+    const double bruteForceCoverage = coverage(bruteForceTargets);
+    const double partitionedCoverage = coverage(partitionedTargets);
+    QVERIFY2(partitionedCoverage > 0.5 * bruteForceCoverage,
+             qPrintable(QStringLiteral("coverage %1 of the partitioned layout, %2 of the brute force layout")
+                        .arg(partitionedCoverage).arg(bruteForceCoverage)));
+}
+
+void NaturalLayoutTest::benchmarkLayout_data()
+{
+    QTest::addColumn<NaturalLayout::Engine>("engine");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("brute force/10") << NaturalLayout::BruteForce << 10;
+    QTest::newRow("brute force/50") << NaturalLayout::BruteForce << 50;
+    QTest::newRow("brute force/100") << NaturalLayout::BruteForce << 100;
+    QTest::newRow("partitioned/10") << NaturalLayout::Partitioned << 10;
+    QTest::newRow("partitioned/50") << NaturalLayout::Partitioned << 50;
+    QTest::newRow("partitioned/100") << NaturalLayout::Partitioned << 100;
+    QTest::newRow("partitioned/200") << NaturalLayout::Partitioned << 200;
+}
+
+void NaturalLayoutTest::benchmarkLayout()
+{
+    QFETCH(NaturalLayout::Engine, engine);
+    QFETCH(int, count);
+    const QVector<QRect> windows = createWindows(count);
+
+    QBENCHMARK {
+        NaturalLayout layout(s_area, 20, true, engine);
+        layout.layout(windows);
+    }
+}
+
+QTEST_GUILESS_MAIN(NaturalLayoutTest)
+#include "test_presentwindows_naturallayout.moc"
@@ -25,12 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "composite.h"
 
+#include "abstract_output.h"
 #include "dbusinterface.h"
 #include "x11client.h"
 #include "decorations/decoratedclient.h"
 #include "deleted.h"
 #include "effects.h"
 #include "internal_client.h"
+#include "outputframescheduler.h"
 #include "overlaywindow.h"
 #include "platform.h"
 #include "scene.h"
@@ -62,7 +64,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QQuickWindow>
 #include <QtConcurrentRun>
 #include <QTextStream>
-#include <QTimerEvent>
 
 #include <xcb/composite.h>
 #include <xcb/damage.h>
@@ -122,19 +123,11 @@ private:
     bool m_owning;
 };
 
-static inline qint64 milliToNano(int milli) { return qint64(milli) * 1000 * 1000; }
-static inline qint64 nanoToMilli(int nano) { return nano / (1000*1000); }
-
 Compositor::Compositor(QObject* workspace)
     : QObject(workspace)
     , m_state(State::Off)
     , m_selectionOwner(nullptr)
-    , vBlankInterval(0)
-    , fpsInterval(0)
-    , m_timeSinceLastVBlank(0)
     , m_scene(nullptr)
-    , m_bufferSwapPending(false)
-    , m_composeAtSwapCompletion(false)
 {
     connect(options, &Options::configChanged, this, &Compositor::configChanged);
     connect(options, &Options::animationSpeedChanged, this, &Compositor::configChanged);
@@ -336,18 +329,14 @@ void Compositor::startupWithWorkspace()
     Workspace::self()->markXStackingOrderAsDirty();
     Q_ASSERT(m_scene);
 
-    connect(workspace(), &Workspace::destroyed, this, [this] { compositeTimer.stop(); });
+    connect(workspace(), &Workspace::destroyed, this, [this] {
+        for (OutputFrameScheduler *scheduler : qAsConst(m_frameSchedulers)) {
+            scheduler->stop();
+        }
+    });
     //setupX11Support();
-    fpsInterval = options->maxFpsInterval();
-
-    if (m_scene->syncsToVBlank()) {
-        // If we do vsync, set the fps to the next multiple of the vblank rate.
-        vBlankInterval = milliToNano(1000) / currentRefreshRate();
-        fpsInterval = qMax((fpsInterval / vBlankInterval) * vBlankInterval, vBlankInterval);
-    } else {
-        // No vsync - DO NOT set "0", would cause div-by-zero segfaults.
-        vBlankInterval = milliToNano(1);
-    }
+    updateFrameSchedulers();
+    connect(screens(), &Screens::changed, this, &Compositor::updateFrameSchedulers, Qt::UniqueConnection);
 
     // Sets also the 'effects' pointer.
     kwinApp()->platform()->createEffectsHandler(this, m_scene);
@@ -387,14 +376,134 @@ void Compositor::startupWithWorkspace()
 
     // Render at least once.
     addRepaintFull();
-    performCompositing();
+    for (OutputFrameScheduler *scheduler : qAsConst(m_frameSchedulers)) {
+        performCompositing(scheduler);
+    }
     setupX11Support();
 }
 
+void Compositor::updateFrameSchedulers()
+{
+    if (!m_scene) {
+        return;
+    }
+
+    QVector<AbstractOutput *> outputs;
+    const Outputs enabledOutputs = kwinApp()->platform()->enabledOutputs();
+    if (m_scene->perScreenRendering() && !enabledOutputs.isEmpty()) {
+        for (AbstractOutput *output : enabledOutputs) {
+            outputs << output;
+        }
+    } else {
+        outputs << nullptr;
+    }
+
+    // Keep the schedulers of outputs which still exist, so that pending swaps
+    // and repaints survive unrelated output changes.
+    QVector<OutputFrameScheduler *> schedulers;
+    schedulers.reserve(outputs.count());
+    for (AbstractOutput *output : qAsConst(outputs)) {
+        const QRect geometry = output ? output->geometry() : QRect(QPoint(0, 0), screens()->size());
+        const int refreshRate = output ? output->refreshRate() : currentRefreshRate() * 1000;
+
+        auto it = std::find_if(m_frameSchedulers.begin(), m_frameSchedulers.end(),
+            [output](OutputFrameScheduler *scheduler) {
+                return scheduler->output() == output;
+            }
+        );
+        if (it != m_frameSchedulers.end()) {
+            OutputFrameScheduler *scheduler = *it;
+            m_frameSchedulers.erase(it);
+            scheduler->setGeometry(geometry);
+            if (scheduler->refreshRate() != refreshRate) {
+                scheduler->setRefreshRate(refreshRate);
+                scheduler->configure(m_scene->syncsToVBlank(), m_scene->blocksForRetrace(), options->maxFpsInterval());
+            }
+            schedulers << scheduler;
+            continue;
+        }
+
+        OutputFrameScheduler *scheduler = new OutputFrameScheduler(output, geometry, refreshRate, this);
+        scheduler->configure(m_scene->syncsToVBlank(), m_scene->blocksForRetrace(), options->maxFpsInterval());
+        connect(scheduler, &OutputFrameScheduler::frameRequested, this,
+            [this, scheduler] {
+                performCompositing(scheduler);
+            }
+        );
+        schedulers << scheduler;
+    }
+
+    // Whatever is left drives an output which is gone.
+    qDeleteAll(m_frameSchedulers);
+    m_frameSchedulers = schedulers;
+    addRepaintFull();
+}
+
+void Compositor::destroyFrameSchedulers()
+{
+    qDeleteAll(m_frameSchedulers);
+    m_frameSchedulers.clear();
+}
+
 void Compositor::scheduleRepaint()
 {
-    if (!compositeTimer.isActive())
-        setCompositeTimer();
+    if (m_state != State::On || m_collectRepaintsScheduled) {
+        return;
+    }
+    // Window repaints are collected once per event cycle, so that a burst of
+    // damage events does not walk all windows for every single event.
+    m_collectRepaintsScheduled = true;
+    QMetaObject::invokeMethod(this, &Compositor::collectWindowRepaints, Qt::QueuedConnection);
+}
+
+static void takeRepaints(Scene *scene, Toplevel *toplevel, QRegion *region)
+{
+    const QRegion repaints = toplevel->repaints();
+    if (!repaints.isEmpty()) {
+        *region += repaints;
+        toplevel->resetRepaints();
+        // the scene tells the effects about the damage of the window once it paints it
+        scene->addWindowRepaints(toplevel, repaints);
+    }
+}
+
+template <class T>
+static void takeRepaints(Scene *scene, const QList<T*> &windows, QRegion *region)
+{
+    for (T *t : windows) {
+        takeRepaints(scene, t, region);
+    }
+}
+
+void Compositor::collectWindowRepaints()
+{
+    m_collectRepaintsScheduled = false;
+    if (m_state != State::On || !Workspace::self()) {
+        return;
+    }
+    // Window repaints are in global coordinates and get moved to the frame schedulers
+    // of the outputs they intersect. The scene does not care whether a region is damaged
+    // because of a window or because of the workspace, the window gets painted anyway.
+    QRegion repaints;
+    takeRepaints(m_scene, Workspace::self()->clientList(), &repaints);
+    takeRepaints(m_scene, Workspace::self()->desktopList(), &repaints);
+    takeRepaints(m_scene, Workspace::self()->unmanagedList(), &repaints);
+    takeRepaints(m_scene, Workspace::self()->deletedList(), &repaints);
+    if (auto *server = waylandServer()) {
+        for (XdgShellClient *c : server->clients()) {
+            if (c->readyForPainting()) {
+                takeRepaints(m_scene, c, &repaints);
+            }
+        }
+    }
+    for (InternalClient *client : workspace()->internalClients()) {
+        if (client->isShown(true)) {
+            takeRepaints(m_scene, client, &repaints);
+        }
+    }
+    if (!repaints.isEmpty()) {
+        addRepaint(repaints);
+    }
 }
 
 void Compositor::stop()
@@ -456,10 +565,9 @@ void Compositor::stop()
         }
     }
 
+    destroyFrameSchedulers();
     delete m_scene;
     m_scene = nullptr;
-    compositeTimer.stop();
-    repaints_region = QRegion();
 
     m_state = State::Off;
     emit compositingToggled(false);
@@ -542,20 +650,12 @@ void Compositor::reinitialize()
 
 void Compositor::addRepaint(int x, int y, int w, int h)
 {
-    if (m_state != State::On) {
-        return;
-    }
-    repaints_region += QRegion(x, y, w, h);
-    scheduleRepaint();
+    addRepaint(QRegion(x, y, w, h));
 }
 
 void Compositor::addRepaint(const QRect& r)
 {
-    if (m_state != State::On) {
-        return;
-    }
-    repaints_region += r;
-    scheduleRepaint();
+    addRepaint(QRegion(r));
 }
 
 void Compositor::addRepaint(const QRegion& r)
@@ -563,8 +663,12 @@ void Compositor::addRepaint(const QRegion& r)
     if (m_state != State::On) {
         return;
     }
-    repaints_region += r;
-    scheduleRepaint();
+    const bool outputsEnabled = kwinApp()->platform()->areOutputsEnabled();
+    for (OutputFrameScheduler *scheduler : qAsConst(m_frameSchedulers)) {
+        if (scheduler->addRepaint(r) && outputsEnabled) {
+            scheduler->scheduleRepaint();
+        }
+    }
 }
 
 void Compositor::addRepaintFull()
@@ -572,53 +676,54 @@ void Compositor::addRepaintFull()
     if (m_state != State::On) {
         return;
     }
-    const QSize &s = screens()->size();
-    repaints_region = QRegion(0, 0, s.width(), s.height());
-    scheduleRepaint();
+    const bool outputsEnabled = kwinApp()->platform()->areOutputsEnabled();
+    for (OutputFrameScheduler *scheduler : qAsConst(m_frameSchedulers)) {
+        scheduler->addRepaintFull();
+        if (outputsEnabled) {
+            scheduler->scheduleRepaint();
+        }
+    }
 }
 
-void Compositor::timerEvent(QTimerEvent *te)
+static bool schedulerDrivesOutput(OutputFrameScheduler *scheduler, AbstractOutput *output)
 {
-    if (te->timerId() == compositeTimer.timerId()) {
-        performCompositing();
-    } else
-        QObject::timerEvent(te);
+    return !output || !scheduler->output() || scheduler->output() == output;
 }
 
-void Compositor::aboutToSwapBuffers()
+void Compositor::aboutToSwapBuffers(AbstractOutput *output)
 {
-    Q_ASSERT(!m_bufferSwapPending);
-
-    m_bufferSwapPending = true;
+    for (OutputFrameScheduler *scheduler : qAsConst(m_frameSchedulers)) {
+        if (schedulerDrivesOutput(scheduler, output)) {
+            scheduler->aboutToSwapBuffers();
+        }
+    }
 }
 
-void Compositor::bufferSwapComplete()
+void Compositor::bufferSwapComplete(AbstractOutput *output)
 {
-    Q_ASSERT(m_bufferSwapPending);
-    m_bufferSwapPending = false;
-
     emit bufferSwapCompleted();
 
-    if (m_composeAtSwapCompletion) {
-        m_composeAtSwapCompletion = false;
-        performCompositing();
+    const auto schedulers = m_frameSchedulers;
+    for (OutputFrameScheduler *scheduler : schedulers) {
+        if (schedulerDrivesOutput(scheduler, output) && scheduler->bufferSwapComplete()) {
+            performCompositing(scheduler);
+        }
     }
 }
 
-void Compositor::performCompositing()
+void Compositor::performCompositing(OutputFrameScheduler *scheduler)
 {
     // If a buffer swap is still pending, we return to the event loop and
     // continue processing events until the swap has completed.
-    if (m_bufferSwapPending) {
-        m_composeAtSwapCompletion = true;
-        compositeTimer.stop();
+    if (scheduler->isSwapPending()) {
+        scheduler->composeAtSwapCompletion();
         return;
     }
 
     // If outputs are disabled, we return to the event loop and
     // continue processing events until the outputs are enabled again
     if (!kwinApp()->platform()->areOutputsEnabled()) {
-        compositeTimer.stop();
+        scheduler->stop();
         return;
     }
 
@@ -662,14 +767,21 @@ void Compositor::performCompositing()
         win->getDamageRegionReply();
     }
 
-    if (repaints_region.isEmpty() && !windowRepaintsPending()) {
-        m_scene->idle();
-        m_timeSinceLastVBlank = fpsInterval - (options->vBlankTime() + 1); // means "start now"
+    // Distribute the window repaints, including the damage fetched above, to the outputs.
+    collectWindowRepaints();
+
+    if (!scheduler->hasRepaints()) {
+        scheduler->idle();
+        // Only reset the animation clock if no output is going to be painted anymore.
+        const bool allIdle = std::none_of(m_frameSchedulers.constBegin(), m_frameSchedulers.constEnd(),
+                                          [](OutputFrameScheduler *s) { return s->hasRepaints(); });
+        if (allIdle) {
+            m_scene->idle();
+        }
         // Note: It would seem here we should undo suspended unredirect, but when scenes need
         // it for some reason, e.g. transformations or translucency, the next pass that does not
         // need this anymore and paints normally will also reset the suspended unredirect.
         // Otherwise the window would not be painted normally anyway.
-        compositeTimer.stop();
         return;
     }
 
@@ -690,14 +802,13 @@ void Compositor::performCompositing()
         }
     }
 
-    QRegion repaints = repaints_region;
     // clear all repaints, so that post-pass can add repaints for the next repaint
-    repaints_region = QRegion();
+    const QRegion repaints = scheduler->takeRepaints();
 
     if (m_framesToTestForSafety > 0 && (m_scene->compositingType() & OpenGLCompositing)) {
         kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PreFrame);
     }
-    m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
+    scheduler->frameRendered(m_scene->paint(repaints, windows));
     if (m_framesToTestForSafety > 0) {
         if (m_scene->compositingType() & OpenGLCompositing) {
             kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PostFrame);
@@ -709,9 +820,18 @@ void Compositor::performCompositing()
     }
 
     if (waylandServer()) {
+        // Only throttle the clients shown on this output by its refresh rate. Windows
+        // outside of all outputs follow whichever output is painted.
+        const QRect outputGeometry = scheduler->geometry();
+        const QRect screenArea(QPoint(0, 0), screens()->size());
         const auto currentTime = static_cast<quint32>(m_monotonicClock.elapsed());
         for (Toplevel *win : qAsConst(windows)) {
-            if (auto surface = win->surface()) {
+            auto surface = win->surface();
+            if (!surface) {
+                continue;
+            }
+            const QRect visibleRect = win->visibleRect();
+            if (visibleRect.intersects(outputGeometry) || !visibleRect.intersects(screenArea)) {
                 surface->frameRendered(currentTime);
             }
         }
@@ -719,132 +839,17 @@ void Compositor::performCompositing()
 
     // Stop here to ensure *we* cause the next repaint schedule - not some effect
     // through m_scene->paint().
-    compositeTimer.stop();
+    scheduler->stop();
 
     // Trigger at least one more pass even if there would be nothing to paint, so that scene->idle()
     // is called the next time. If there would be nothing pending, it will not restart the timer and
     // scheduleRepaint() would restart it again somewhen later, called from functions that
     // would again add something pending.
-    if (m_bufferSwapPending && m_scene->syncsToVBlank()) {
-        m_composeAtSwapCompletion = true;
+    if (scheduler->isSwapPending() && m_scene->syncsToVBlank()) {
+        scheduler->composeAtSwapCompletion();
     } else {
-        scheduleRepaint();
-    }
-}
-
-template <class T>
-static bool repaintsPending(const QList<T*> &windows)
-{
-    return std::any_of(windows.begin(), windows.end(),
-                       [](T *t) { return !t->repaints().isEmpty(); });
-}
-
-bool Compositor::windowRepaintsPending() const
-{
-    if (repaintsPending(Workspace::self()->clientList())) {
-        return true;
-    }
-    if (repaintsPending(Workspace::self()->desktopList())) {
-        return true;
-    }
-    if (repaintsPending(Workspace::self()->unmanagedList())) {
-        return true;
-    }
-    if (repaintsPending(Workspace::self()->deletedList())) {
-        return true;
-    }
-    if (auto *server = waylandServer()) {
-        const auto &clients = server->clients();
-        auto test = [](XdgShellClient *c) {
-            return c->readyForPainting() && !c->repaints().isEmpty();
-        };
-        if (std::any_of(clients.begin(), clients.end(), test)) {
-            return true;
-        }
-    }
-    const auto &internalClients = workspace()->internalClients();
-    auto internalTest = [] (InternalClient *client) {
-        return client->isShown(true) && !client->repaints().isEmpty();
-    };
-    if (std::any_of(internalClients.begin(), internalClients.end(), internalTest)) {
-        return true;
-    }
-    return false;
-}
-
-void Compositor::setCompositeTimer()
-{
-    if (m_state != State::On) {
-        return;
-    }
-
-    // Don't start the timer if we're waiting for a swap event
-    if (m_bufferSwapPending && m_composeAtSwapCompletion)
-        return;
-
-    // Don't start the timer if all outputs are disabled
-    if (!kwinApp()->platform()->areOutputsEnabled()) {
-        return;
-    }
-
-    uint waitTime = 1;
-
-    if (m_scene->blocksForRetrace()) {
-
-        // TODO: make vBlankTime dynamic?!
-        // It's required because glXWaitVideoSync will *likely* block a full frame if one enters
-        // a retrace pass which can last a variable amount of time, depending on the actual screen
-        // Now, my ooold 19" CRT can do such retrace so that 2ms are entirely sufficient,
-        // while another ooold 15" TFT requires about 6ms
-
-        qint64 padding = m_timeSinceLastVBlank;
-        if (padding > fpsInterval) {
-            // We're at low repaints or spent more time in painting than the user wanted to wait
-            // for that frame. Align to next vblank:
-            padding = vBlankInterval - (padding % vBlankInterval);
-        } else {
-            // Align to the next maxFps tick:
-            // "remaining time of the first vsync" + "time for the other vsyncs of the frame"
-            padding = ((vBlankInterval - padding % vBlankInterval) +
-                       (fpsInterval / vBlankInterval - 1) * vBlankInterval);
-        }
-
-        if (padding < options->vBlankTime()) {
-            // We'll likely miss this frame so we add one:
-            waitTime = nanoToMilli(padding + vBlankInterval - options->vBlankTime());
-        } else {
-            waitTime = nanoToMilli(padding - options->vBlankTime());
-        }
-    }
-    else { // w/o blocking vsync we just jump to the next demanded tick
-        if (fpsInterval > m_timeSinceLastVBlank) {
-            waitTime = nanoToMilli(fpsInterval - m_timeSinceLastVBlank);
-            if (!waitTime) {
-                // Will ensure we don't block out the eventloop - the system's just not faster ...
-                waitTime = 1;
-            }
-        }
-        /* else if (m_scene->syncsToVBlank() && m_timeSinceLastVBlank - fpsInterval < (vBlankInterval<<1)) {
-            // NOTICE - "for later" ------------------------------------------------------------------
-            // It can happen that we push two frames within one refresh cycle.
-            // Swapping will then block even with triple buffering when the GPU does not discard but
-            // queues frames
-            // now here's the mean part: if we take that as "OMG, we're late - next frame ASAP",
-            // there'll immediately be 2 frames in the pipe, swapping will block, we think we're
-            // late ... ewww
-            // so instead we pad to the clock again and add 2ms safety to ensure the pipe is really
-            // free
-            // NOTICE: obviously m_timeSinceLastVBlank can be too big because we're too slow as well
-            // So if this code was enabled, we'd needlessly half the framerate once more (15 instead of 30)
-            waitTime = nanoToMilli(vBlankInterval - (m_timeSinceLastVBlank - fpsInterval)%vBlankInterval) + 2;
-        }*/
-        else {
-            // "0" would be sufficient here, but the compositor isn't the WMs only task.
-            waitTime = 1;
-        }
+        scheduler->scheduleRepaint();
     }
-    // Force 4fps minimum:
-    compositeTimer.start(qMin(waitTime, 250u), this);
 }
 
 bool Compositor::isActive()
@@ -999,13 +1004,13 @@ void X11Compositor::start()
     m_xrrRefreshRate = KWin::currentRefreshRate();
     startupWithWorkspace();
 }
-void X11Compositor::performCompositing()
+void X11Compositor::performCompositing(OutputFrameScheduler *scheduler)
 {
     if (scene()->usesOverlayWindow() && !isOverlayWindowVisible()) {
         // Return since nothing is visible.
         return;
     }
-    Compositor::performCompositing();
+    Compositor::performCompositing(scheduler);
 }
 
 bool X11Compositor::checkForOverlayWindow(WId w) const
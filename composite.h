@@ -25,12 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QElapsedTimer>
 #include <QTimer>
-#include <QBasicTimer>
 #include <QRegion>
+#include <QVector>
 
 namespace KWin
 {
+class AbstractOutput;
 class CompositorSelectionOwner;
+class OutputFrameScheduler;
 class Scene;
 class X11Client;
 
@@ -56,21 +58,30 @@ public:
     void addRepaintFull();
 
     /**
-     * Schedules a new repaint if no repaint is currently scheduled.
+     * Schedules a new repaint for all outputs with pending window repaints.
      */
     void scheduleRepaint();
 
     /**
-     * Notifies the compositor that SwapBuffers() is about to be called.
-     * Rendering of the next frame will be deferred until bufferSwapComplete()
-     * is called.
+     * Notifies the compositor that SwapBuffers() is about to be called for @p output.
+     * Rendering of the next frame on that output will be deferred until
+     * bufferSwapComplete() is called. If @p output is @c null all outputs are affected.
      */
-    void aboutToSwapBuffers();
+    void aboutToSwapBuffers(AbstractOutput *output = nullptr);
 
     /**
-     * Notifies the compositor that a pending buffer swap has completed.
+     * Notifies the compositor that a pending buffer swap of @p output has completed.
+     * If @p output is @c null the swap of all outputs has completed.
      */
-    void bufferSwapComplete();
+    void bufferSwapComplete(AbstractOutput *output = nullptr);
+
+    /**
+     * The frame schedulers driving the repaints, one per output if the Scene renders
+     * outputs individually, otherwise a single one covering all outputs.
+     */
+    QVector<OutputFrameScheduler *> frameSchedulers() const {
+        return m_frameSchedulers;
+    }
 
     /**
      * Toggles compositing, that is if the Compositor is suspended it will be resumed
@@ -118,7 +129,6 @@ Q_SIGNALS:
 
 protected:
     explicit Compositor(QObject *parent = nullptr);
-    void timerEvent(QTimerEvent *te) override;
 
     virtual void start() = 0;
     void stop();
@@ -132,7 +142,7 @@ protected:
      * Continues the startup after Scene And Workspace are created
      */
     void startupWithWorkspace();
-    virtual void performCompositing();
+    virtual void performCompositing(OutputFrameScheduler *scheduler);
 
     virtual void configChanged();
 
@@ -145,29 +155,27 @@ private:
 
     void setupX11Support();
 
-    void setCompositeTimer();
-    bool windowRepaintsPending() const;
+    /**
+     * Creates a scheduler for each added output and destroys the ones of removed outputs.
+     */
+    void updateFrameSchedulers();
+    void destroyFrameSchedulers();
+    void collectWindowRepaints();
 
     void releaseCompositorSelection();
     void deleteUnusedSupportProperties();
 
     State m_state;
 
-    QBasicTimer compositeTimer;
+    QVector<OutputFrameScheduler *> m_frameSchedulers;
+    bool m_collectRepaintsScheduled = false;
     CompositorSelectionOwner *m_selectionOwner;
     QTimer m_releaseSelectionTimer;
     QList<xcb_atom_t> m_unusedSupportProperties;
     QTimer m_unusedSupportPropertyTimer;
-    qint64 vBlankInterval, fpsInterval;
-    QRegion repaints_region;
-
-    qint64 m_timeSinceLastVBlank;
 
     Scene *m_scene;
 
-    bool m_bufferSwapPending;
-    bool m_composeAtSwapCompletion;
-
     int m_framesToTestForSafety = 3;
     QElapsedTimer m_monotonicClock;
 };
@@ -260,7 +268,7 @@ public:
 
 protected:
     void start() override;
-    void performCompositing() override;
+    void performCompositing(OutputFrameScheduler *scheduler) override;
 
 private:
     explicit X11Compositor(QObject *parent);
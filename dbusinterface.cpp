@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "composite.h"
 #include "debug_console.h"
 #include "main.h"
+#include "outputframescheduler.h"
 #include "placement.h"
 #include "platform.h"
 #include "kwinadaptor.h"
@@ -313,6 +314,24 @@ bool CompositorDBusInterface::platformRequiresCompositing() const
     return kwinApp()->platform()->requiresCompositing();
 }
 
+qlonglong CompositorDBusInterface::renderTime() const
+{
+    qint64 renderTime = 0;
+    for (OutputFrameScheduler *scheduler : m_compositor->frameSchedulers()) {
+        renderTime = qMax(renderTime, scheduler->lastRenderTime());
+    }
+    return renderTime / 1000;
+}
+
+qlonglong CompositorDBusInterface::predictedRenderTime() const
+{
+    qint64 renderTime = 0;
+    for (OutputFrameScheduler *scheduler : m_compositor->frameSchedulers()) {
+        renderTime = qMax(renderTime, scheduler->predictedRenderTime());
+    }
+    return renderTime / 1000;
+}
+
 void CompositorDBusInterface::resume()
 {
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
@@ -129,6 +129,15 @@ class CompositorDBusInterface : public QObject
      */
     Q_PROPERTY(QStringList supportedOpenGLPlatformInterfaces READ supportedOpenGLPlatformInterfaces)
     Q_PROPERTY(bool platformRequiresCompositing READ platformRequiresCompositing)
+    /**
+     * @brief The time in microseconds the slowest output needed to render its last frame.
+     */
+    Q_PROPERTY(qlonglong renderTime READ renderTime)
+    /**
+     * @brief The render time in microseconds predicted for the next frame of the slowest output.
+     * Frames are started this long, plus a small safety margin, before the vblank.
+     */
+    Q_PROPERTY(qlonglong predictedRenderTime READ predictedRenderTime)
 public:
     explicit CompositorDBusInterface(Compositor *parent);
     ~CompositorDBusInterface() override = default;
@@ -140,6 +149,8 @@ public:
     QString compositingType() const;
     QStringList supportedOpenGLPlatformInterfaces() const;
     bool platformRequiresCompositing() const;
+    qlonglong renderTime() const;
+    qlonglong predictedRenderTime() const;
 
 public Q_SLOTS:
     /**
@@ -48,6 +48,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMouseEvent>
 #include <QMetaProperty>
 #include <QMetaType>
+#include <QTimer>
 
 // xkb
 #include <xkbcommon/xkbcommon.h>
@@ -296,6 +297,8 @@ void DebugConsoleFilter::keyEvent(KeyEvent *event)
     text.append(tableRow(i18nc("Key according to Qt", "Qt::Key code"),
                          enumerator.valueToKey(event->key())));
     text.append(tableRow(i18nc("The translated code to an Xkb symbol", "Xkb symbol"), event->nativeVirtualKey()));
+    // spies see the event before the filters, which convert the keysym into text on demand
+    input()->keyboard()->resolveText(event);
     text.append(tableRow(i18nc("The translated code interpreted as text", "Utf8"), event->text()));
     text.append(tableRow(i18nc("The currently active modifiers", "Modifiers"), modifiersToString()));
 
@@ -597,6 +600,12 @@ DebugConsole::DebugConsole()
                 m_inputFilter.reset(new DebugConsoleFilter(m_ui->inputTextEdit));
                 input()->installInputEventSpy(m_inputFilter.data());
             }
+            if (index == 4 && m_textureUploadsTimer) {
+                updateTextureUploads();
+                m_textureUploadsTimer->start();
+            } else if (m_textureUploadsTimer) {
+                m_textureUploadsTimer->stop();
+            }
             if (index == 5) {
                 updateKeyboardTab();
                 connect(input(), &InputRedirection::keyStateChanged, this, &DebugConsole::updateKeyboardTab);
@@ -642,6 +651,26 @@ void DebugConsole::initGLTab()
 
     m_ui->platformExtensionsLabel->setText(extensionsString(Compositor::self()->scene()->openGLPlatformInterfaceExtensions()));
     m_ui->openGLExtensionsLabel->setText(extensionsString(openGLExtensions()));
+
+    // the counters change with every frame, refresh them while the tab is shown
+    m_textureUploadsTimer = new QTimer(this);
+    m_textureUploadsTimer->setInterval(1000);
+    connect(m_textureUploadsTimer, &QTimer::timeout, this, &DebugConsole::updateTextureUploads);
+}
+
+void DebugConsole::updateTextureUploads()
+{
+    const GLTextureUploadStatistics statistics = GLTexture::uploadStatistics();
+    const QLocale locale;
+    QString text = s_tableStart;
+    text.append(tableRow(i18n("Uploads"), statistics.uploads));
+    text.append(tableRow(i18n("Rectangles"), statistics.rects));
+    text.append(tableRow(i18n("Uploaded"), locale.formattedDataSize(qint64(statistics.bytes))));
+    text.append(tableRow(i18n("Converted"), locale.formattedDataSize(qint64(statistics.convertedBytes))));
+    text.append(tableRow(i18n("Streamed through pixel buffers"), locale.formattedDataSize(qint64(statistics.streamedBytes))));
+    text.append(tableRow(i18n("Submission time"), i18nc("duration in milliseconds", "%1 ms", statistics.time / 1000000)));
+    text.append(s_tableEnd);
+    m_ui->textureUploadsLabel->setText(text);
 }
 
 template <typename T>
@@ -36,6 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector>
 
 class QTextEdit;
+class QTimer;
 
 namespace Ui
 {
@@ -115,9 +116,11 @@ protected:
 private:
     void initGLTab();
     void updateKeyboardTab();
+    void updateTextureUploads();
 
     QScopedPointer<Ui::DebugConsole> m_ui;
     QScopedPointer<DebugConsoleFilter> m_inputFilter;
+    QTimer *m_textureUploadsTimer = nullptr;
 };
 
 class SurfaceTreeModel : public QAbstractItemModel
@@ -141,7 +141,7 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
     QDBusConnection dbus = QDBusConnection::sessionBus();
     dbus.registerObject(QStringLiteral("/Effects"), this);
     // init is important, otherwise causes crashes when quads are build before the first painting pass start
-    m_currentBuildQuadsIterator = m_activeEffects.constEnd();
+    m_currentBuildQuadsIterator = m_buildQuadsEffects.constEnd();
 
     Workspace *ws = Workspace::self();
     VirtualDesktopManager *vds = VirtualDesktopManager::self();
@@ -392,22 +392,28 @@ void EffectsHandlerImpl::reconfigure()
 // the idea is that effects call this function again which calls the next one
 void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData& data, int time)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->prePaintScreen(data, time);
-        --m_currentPaintScreenIterator;
+    if (m_currentPrePaintScreenIterator != m_prePaintScreenEffects.constEnd()) {
+        (*m_currentPrePaintScreenIterator++)->prePaintScreen(data, time);
+        --m_currentPrePaintScreenIterator;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintScreen(int mask, const QRegion &region, ScreenPaintData& data)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
+    if (m_currentPaintScreenIterator != m_paintScreenEffects.constEnd()) {
         (*m_currentPaintScreenIterator++)->paintScreen(mask, region, data);
         --m_currentPaintScreenIterator;
     } else
         m_scene->finalPaintScreen(mask, region, data);
 }
 
+bool EffectsHandlerImpl::hasFollowingPaintScreenEffects() const
+{
+    // the iterator already points to the effect after the one being called
+    return m_currentPaintScreenIterator != m_paintScreenEffects.constEnd();
+}
+
 void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, ScreenPaintData &data)
 {
     if (desktop < 1 || desktop > numberOfDesktops()) {
@@ -417,7 +423,7 @@ void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, Scr
     m_desktopRendering = true;
     // save the paint screen iterator
     EffectsIterator savedIterator = m_currentPaintScreenIterator;
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
+    m_currentPaintScreenIterator = m_paintScreenEffects.constBegin();
     effects->paintScreen(mask, region, data);
     // restore the saved iterator
     m_currentPaintScreenIterator = savedIterator;
@@ -426,25 +432,25 @@ void EffectsHandlerImpl::paintDesktop(int desktop, int mask, QRegion region, Scr
 
 void EffectsHandlerImpl::postPaintScreen()
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->postPaintScreen();
-        --m_currentPaintScreenIterator;
+    if (m_currentPostPaintScreenIterator != m_postPaintScreenEffects.constEnd()) {
+        (*m_currentPostPaintScreenIterator++)->postPaintScreen();
+        --m_currentPostPaintScreenIterator;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, time);
-        --m_currentPaintWindowIterator;
+    if (m_currentPrePaintWindowIterator != m_prePaintWindowEffects.constEnd()) {
+        (*m_currentPrePaintWindowIterator++)->prePaintWindow(w, data, time);
+        --m_currentPrePaintWindowIterator;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
+    if (m_currentPaintWindowIterator != m_paintWindowEffects.constEnd()) {
         (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
         --m_currentPaintWindowIterator;
     } else
@@ -453,7 +459,7 @@ void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &r
 
 void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &region, double opacity, double frameOpacity)
 {
-    if (m_currentPaintEffectFrameIterator != m_activeEffects.constEnd()) {
+    if (m_currentPaintEffectFrameIterator != m_paintEffectFrameEffects.constEnd()) {
         (*m_currentPaintEffectFrameIterator++)->paintEffectFrame(frame, region, opacity, frameOpacity);
         --m_currentPaintEffectFrameIterator;
     } else {
@@ -464,9 +470,9 @@ void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &reg
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+    if (m_currentPostPaintWindowIterator != m_postPaintWindowEffects.constEnd()) {
+        (*m_currentPostPaintWindowIterator++)->postPaintWindow(w);
+        --m_currentPostPaintWindowIterator;
     }
     // no special final code
 }
@@ -481,7 +487,7 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
+    if (m_currentDrawWindowIterator != m_drawWindowEffects.constEnd()) {
         (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
         --m_currentDrawWindowIterator;
     } else
@@ -492,14 +498,14 @@ void EffectsHandlerImpl::buildQuads(EffectWindow* w, WindowQuadList& quadList)
 {
     static bool initIterator = true;
     if (initIterator) {
-        m_currentBuildQuadsIterator = m_activeEffects.constBegin();
+        m_currentBuildQuadsIterator = m_buildQuadsEffects.constBegin();
         initIterator = false;
     }
-    if (m_currentBuildQuadsIterator != m_activeEffects.constEnd()) {
+    if (m_currentBuildQuadsIterator != m_buildQuadsEffects.constEnd()) {
         (*m_currentBuildQuadsIterator++)->buildQuads(w, quadList);
         --m_currentBuildQuadsIterator;
     }
-    if (m_currentBuildQuadsIterator == m_activeEffects.constBegin())
+    if (m_currentBuildQuadsIterator == m_buildQuadsEffects.constBegin())
         initIterator = true;
 }
 
@@ -518,20 +524,59 @@ bool EffectsHandlerImpl::decorationSupportsBlurBehind() const
     return Decoration::DecorationBridge::self()->needsBlur();
 }
 
+std::array<EffectsHandlerImpl::EffectsList *, 9> EffectsHandlerImpl::paintChains()
+{
+    return {
+        &m_prePaintScreenEffects,
+        &m_paintScreenEffects,
+        &m_postPaintScreenEffects,
+        &m_prePaintWindowEffects,
+        &m_paintWindowEffects,
+        &m_postPaintWindowEffects,
+        &m_drawWindowEffects,
+        &m_paintEffectFrameEffects,
+        &m_buildQuadsEffects
+    };
+}
+
 // start another painting pass
 void EffectsHandlerImpl::startPaint()
 {
-    m_activeEffects.clear();
-    m_activeEffects.reserve(loaded_effects.count());
+    const auto chains = paintChains();
+    for (EffectsList *chain : chains) {
+        chain->clear();
+    }
     for(QVector< KWin::EffectPair >::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
-        if (it->second->isActive()) {
-            m_activeEffects << it->second;
+        Effect *effect = it->second;
+        if (!effect->isActive()) {
+            continue;
+        }
+        // only put the effect into the chains of the hooks it reimplements, the
+        // default implementations just pass the call on to the next effect
+        const Effect::PaintHooks hooks = effect->paintHooks();
+        for (std::size_t i = 0; i < chains.size(); ++i) {
+            if (hooks & (1 << i)) {
+                chains[i]->append(effect);
+            }
         }
     }
-    m_currentDrawWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
-    m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
+    m_currentDrawWindowIterator = m_drawWindowEffects.constBegin();
+    m_currentPrePaintWindowIterator = m_prePaintWindowEffects.constBegin();
+    m_currentPaintWindowIterator = m_paintWindowEffects.constBegin();
+    m_currentPostPaintWindowIterator = m_postPaintWindowEffects.constBegin();
+    m_currentPrePaintScreenIterator = m_prePaintScreenEffects.constBegin();
+    m_currentPaintScreenIterator = m_paintScreenEffects.constBegin();
+    m_currentPostPaintScreenIterator = m_postPaintScreenEffects.constBegin();
+    m_currentPaintEffectFrameIterator = m_paintEffectFrameEffects.constBegin();
+}
+
+bool EffectsHandlerImpl::hasWindowPaintEffects(const EffectWindow *w) const
+{
+    auto paints = [w](const Effect *effect) {
+        return effect->paintsWindow(w);
+    };
+    return std::any_of(m_paintWindowEffects.constBegin(), m_paintWindowEffects.constEnd(), paints)
+        || std::any_of(m_drawWindowEffects.constBegin(), m_drawWindowEffects.constEnd(), paints);
 }
 
 void EffectsHandlerImpl::slotClientMaximized(KWin::AbstractClient *c, MaximizeMode maxMode)
@@ -1517,13 +1562,19 @@ void EffectsHandlerImpl::reloadEffect(Effect *effect)
 void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
-    m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    const auto chains = paintChains();
+    for (EffectsList *chain : chains) {
+        chain->clear();
+    }
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
         std::back_inserter(loaded_effects));
 
-    m_activeEffects.reserve(loaded_effects.count());
+    for (EffectsList *chain : chains) {
+        chain->reserve(loaded_effects.count());
+    }
 }
 
 QStringList EffectsHandlerImpl::activeEffects() const
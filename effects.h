@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHash>
 #include <Plasma/FrameSvg>
 
+#include <array>
 #include <memory>
 
 namespace Plasma {
@@ -86,6 +87,7 @@ public:
      * Special hook to perform a paintScreen but just with the windows on @p desktop.
      */
     void paintDesktop(int desktop, int mask, QRegion region, ScreenPaintData& data);
+    bool hasFollowingPaintScreenEffects() const override;
     void postPaintScreen() override;
     void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) override;
     void paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data) override;
@@ -212,6 +214,18 @@ public:
 
     // internal (used by kwin core or compositing code)
     void startPaint();
+    /**
+     * @returns Whether an effect paints something itself while painting or drawing @p w
+     * in the current frame.
+     * @see Effect::paintsWindow
+     */
+    bool hasWindowPaintEffects(const EffectWindow *w) const;
+    /**
+     * @returns Whether effects take part in painting the screen in the current frame.
+     */
+    bool hasPaintScreenEffects() const {
+        return !m_paintScreenEffects.isEmpty();
+    }
     void grabbedKeyboardEvent(QKeyEvent* e);
     bool hasKeyboardGrab() const;
     void desktopResized(const QSize &size);
@@ -357,11 +371,28 @@ private:
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
-    EffectsList m_activeEffects;
+    /**
+     * The paint chains in the order of the Effect::PaintHook bits.
+     */
+    std::array<EffectsList *, 9> paintChains();
+    // The active effects taking part in the individual paint chains, see Effect::paintHooks()
+    EffectsList m_prePaintScreenEffects;
+    EffectsList m_paintScreenEffects;
+    EffectsList m_postPaintScreenEffects;
+    EffectsList m_prePaintWindowEffects;
+    EffectsList m_paintWindowEffects;
+    EffectsList m_postPaintWindowEffects;
+    EffectsList m_drawWindowEffects;
+    EffectsList m_paintEffectFrameEffects;
+    EffectsList m_buildQuadsEffects;
     EffectsIterator m_currentDrawWindowIterator;
+    EffectsIterator m_currentPrePaintWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
+    EffectsIterator m_currentPostPaintWindowIterator;
     EffectsIterator m_currentPaintEffectFrameIterator;
+    EffectsIterator m_currentPrePaintScreenIterator;
     EffectsIterator m_currentPaintScreenIterator;
+    EffectsIterator m_currentPostPaintScreenIterator;
     EffectsIterator m_currentBuildQuadsIterator;
     typedef QHash< QByteArray, QList< Effect*> > PropertyEffectMap;
     PropertyEffectMap m_propertiesForEffects;
@@ -407,8 +407,9 @@ void ContrastEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, i
     m_paintedArea |= data.paint;
 }
 
-bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const
+bool ContrastEffect::paintsWindow(const EffectWindow *w) const
 {
+    // whether the window gets transformed is only known when drawing it, see shouldContrast()
     if (!shader || !shader->isValid())
         return false;
 
@@ -418,15 +419,23 @@ bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const Windo
     if (w->isDesktop())
         return false;
 
+    if (!w->hasAlpha())
+        return false;
+
+    return !contrastRegion(w).isEmpty();
+}
+
+bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const
+{
+    if (!paintsWindow(w))
+        return false;
+
     bool scaled = !qFuzzyCompare(data.xScale(), 1.0) && !qFuzzyCompare(data.yScale(), 1.0);
     bool translated = data.xTranslation() || data.yTranslation();
 
     if ((scaled || (translated || (mask & PAINT_WINDOW_TRANSFORMED))) && !w->data(WindowForceBackgroundContrastRole).toBool())
         return false;
 
-    if (!w->hasAlpha())
-        return false;
-
     return true;
 }
 
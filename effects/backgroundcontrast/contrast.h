@@ -57,6 +57,10 @@ public:
     void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, int time) override;
     void drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data) override;
     void paintEffectFrame(EffectFrame *frame, const QRegion &region, double opacity, double frameOpacity) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PrePaintWindowHook | DrawWindowHook | PaintEffectFrameHook;
+    }
+    bool paintsWindow(const EffectWindow *w) const override;
 
     bool provides(Feature feature) override;
 
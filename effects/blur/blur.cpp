@@ -109,6 +109,7 @@ bool BlurEffect::renderTargetsValid() const
 
 void BlurEffect::deleteFBOs()
 {
+    m_blurCache.clear();
     qDeleteAll(m_renderTargets);
 
     m_renderTargets.clear();
@@ -337,6 +338,7 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    m_blurCache.remove(w);
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -490,8 +492,79 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, int time)
     m_damagedArea = QRegion();
     m_paintedArea = QRegion();
     m_currentBlur = QRegion();
+    m_damagedBelow = QRegion();
+    m_windowDamage = QRegion();
+    m_blurredWindows.clear();
 
     effects->prePaintScreen(data, time);
+
+    m_screenDamage = data.paint;
+    m_blurCacheDamageApplied = false;
+
+    // transformed windows are not tracked by the window damage, the content
+    // underneath the blurred windows cannot be trusted
+    if (data.mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) {
+        const QRect screen = GLRenderTarget::virtualScreenGeometry();
+        for (auto it = m_blurCache.begin(); it != m_blurCache.end(); ++it) {
+            for (BlurCache &cache : *it) {
+                if (cache.screen == screen) {
+                    cache.valid = false;
+                }
+            }
+        }
+    }
+}
+
+void BlurEffect::postPaintScreen()
+{
+    // a blurred window which was not drawn still has to learn about the damage underneath it
+    invalidateDamagedBlurCaches();
+
+    effects->postPaintScreen();
+}
+
+BlurEffect::BlurCache *BlurEffect::blurCache(const EffectWindow *w, const QRect &screen)
+{
+    QVector<BlurCache> &caches = m_blurCache[w];
+    for (BlurCache &cache : caches) {
+        if (cache.screen == screen) {
+            return &cache;
+        }
+    }
+    caches.append(BlurCache());
+    caches.last().screen = screen;
+    return &caches.last();
+}
+
+void BlurEffect::invalidateBlurCache(const EffectWindow *w, const QRect &screen)
+{
+    auto it = m_blurCache.find(w);
+    if (it == m_blurCache.end()) {
+        return;
+    }
+    for (BlurCache &cache : *it) {
+        if (screen.isNull() || cache.screen == screen) {
+            cache.valid = false;
+        }
+    }
+}
+
+void BlurEffect::invalidateDamagedBlurCaches()
+{
+    if (m_blurCacheDamageApplied) {
+        return;
+    }
+    m_blurCacheDamageApplied = true;
+
+    // Whatever got repainted without being the damage of a window, e.g. the area a window
+    // moved away from, might have changed underneath every window.
+    const QRegion unknownDamage = m_screenDamage - m_windowDamage;
+    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    for (const BlurredWindow &blurred : qAsConst(m_blurredWindows)) {
+        if (!blurred.damagedBelow.isEmpty() || unknownDamage.intersects(blurred.area)) {
+            invalidateBlurCache(blurred.window, screen);
+        }
+    }
 }
 
 void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
@@ -501,6 +574,8 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     effects->prePaintWindow(w, data, time);
 
     if (!w->isPaintingEnabled()) {
+        // changes underneath the window are not tracked while it is not painted
+        invalidateBlurCache(w);
         return;
     }
     if (!m_shader || !m_shader->isValid()) {
@@ -530,6 +605,13 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     const QRegion blurArea = blurRegion(w).translated(w->pos()) & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // The cached blur is outdated if a window underneath the blurred area changed. The
+    // painted area can't tell, it always contains the complete repainted area of the frame.
+    // The changes of the windows above are only known once all windows are prepared.
+    if (!expandedBlur.isEmpty()) {
+        m_blurredWindows.append({w, expandedBlur, m_damagedBelow & expandedBlur});
+    }
+
     // if this window or a window underneath the blurred area is painted again we have to
     // blur everything
     if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
@@ -553,10 +635,16 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     // in contrast to m_damagedArea does m_paintedArea keep track of all repainted areas
     m_paintedArea -= data.clip;
     m_paintedArea |= data.paint;
+
+    // the changes of the window itself, the windows above only care about the visible ones
+    m_damagedBelow -= data.clip;
+    m_damagedBelow |= data.damage;
+    m_windowDamage |= data.damage;
 }
 
-bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
+bool BlurEffect::paintsWindow(const EffectWindow *w) const
 {
+    // whether the window gets transformed is only known when drawing it, see shouldBlur()
     if (!m_renderTargetsValid || !m_shader || !m_shader->isValid())
         return false;
 
@@ -566,18 +654,26 @@ bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintDa
     if (w->isDesktop())
         return false;
 
-    bool scaled = !qFuzzyCompare(data.xScale(), 1.0) && !qFuzzyCompare(data.yScale(), 1.0);
-    bool translated = data.xTranslation() || data.yTranslation();
-
-    if ((scaled || (translated || (mask & PAINT_WINDOW_TRANSFORMED))) && !w->data(WindowForceBlurRole).toBool())
-        return false;
-
     bool blurBehindDecos = effects->decorationsHaveAlpha() &&
                 effects->decorationSupportsBlurBehind();
 
     if (!w->hasAlpha() && w->opacity() >= 1.0 && !(blurBehindDecos && w->hasDecoration()))
         return false;
 
+    return !blurRegion(w).isEmpty();
+}
+
+bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
+{
+    if (!paintsWindow(w))
+        return false;
+
+    bool scaled = !qFuzzyCompare(data.xScale(), 1.0) && !qFuzzyCompare(data.yScale(), 1.0);
+    bool translated = data.xTranslation() || data.yTranslation();
+
+    if ((scaled || (translated || (mask & PAINT_WINDOW_TRANSFORMED))) && !w->data(WindowForceBlurRole).toBool())
+        return false;
+
     return true;
 }
 
@@ -622,8 +718,22 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
             shape = shape & region;
         }
 
+        // only the untransformed blur can be reused, a transformed one moves with the window
+        BlurCache *cache = nullptr;
+        if (!scaled && !translated && GLRenderTarget::blitSupported()) {
+            invalidateDamagedBlurCaches();
+            cache = blurCache(w, screen);
+            const QRegion blurShape = blurRegion(w).translated(w->pos()) & screen & ubrRegion;
+            if (cache->shape != blurShape) {
+                cache->shape = blurShape;
+                cache->valid = false;
+            }
+        } else {
+            invalidateBlurCache(w, screen);
+        }
+
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry());
+            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry(), cache);
         }
     }
 
@@ -631,6 +741,17 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
     effects->drawWindow(w, mask, region, data);
 }
 
+QString BlurEffect::debug(const QString &parameter) const
+{
+    if (parameter == QLatin1String("blurPasses")) {
+        return QString::number(m_blurPasses);
+    }
+    if (parameter == QLatin1String("cacheHits")) {
+        return QString::number(m_blurCacheHits);
+    }
+    return QString();
+}
+
 void BlurEffect::paintEffectFrame(EffectFrame *frame, const QRegion &region, double opacity, double frameOpacity)
 {
     const QRect screen = effects->virtualScreenGeometry();
@@ -671,14 +792,17 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture.setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
     const int xTranslate = -screen.x();
     const int yTranslate = effects->virtualScreenSize().height() - screen.height() - screen.y();
 
-    const QRegion expandedBlurRegion = expand(shape) & expand(screen);
+    // With a cache the complete blur shape is blurred, so that the following frames
+    // can reuse it even if they repaint a different part of it.
+    const QRegion blurShape = cache ? cache->shape : shape;
+    const QRegion expandedBlurRegion = expand(blurShape) & expand(screen);
 
     const bool useSRGB = m_renderTextures.first().internalFormat() == GL_SRGB8_ALPHA8;
 
@@ -692,37 +816,68 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
     const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
 
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
     int blurRectCount = expandedBlurRegion.rectCount() * 6;
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+    // The area of the half sized texture the last upsample pass renders to
+    QRect cacheRect;
+    if (cache) {
+        cacheRect = QRect(QPoint(destRect.x() / 2, destRect.y() / 2),
+                          QPoint((destRect.right() + 1) / 2, (destRect.bottom() + 1) / 2))
+                    & QRect(QPoint(0, 0), m_renderTextures[1].size());
+    }
+
+    if (cache && cache->valid && cache->rect == cacheRect) {
+        // Nothing changed underneath the window, restore the blurred background
+        ++m_blurCacheHits;
+        m_renderTargets[1]->blitFromRenderTarget(cache->renderTarget.data(), QRect(QPoint(0, 0), cacheRect.size()), cacheRect);
 
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
     } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        ++m_blurPasses;
+        GLRenderTarget::pushRenderTargets(m_renderTargetStack);
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            copyScreenSampleTexture(vbo, blurRectCount, blurShape.translated(xTranslate, yTranslate), screenProjection);
+        } else {
+            m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
         }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
-    }
+        downSampleTexture(vbo, blurRectCount);
+        upSampleTexture(vbo, blurRectCount);
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+        if (cache && !cacheRect.isEmpty()) {
+            // copy the texels unchanged
+            if (useSRGB) {
+                glDisable(GL_FRAMEBUFFER_SRGB);
+            }
+            storeBlurCache(cache, cacheRect);
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+        }
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
@@ -751,6 +906,23 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     vbo->unbindArrays();
 }
 
+void BlurEffect::storeBlurCache(BlurCache *cache, const QRect &rect)
+{
+    if (cache->renderTarget.isNull() || cache->texture.size() != rect.size()) {
+        cache->texture = GLTexture(m_renderTextures[1].internalFormat(), rect.size());
+        cache->texture.setFilter(GL_LINEAR);
+        cache->texture.setWrapMode(GL_CLAMP_TO_EDGE);
+        cache->renderTarget.reset(new GLRenderTarget(cache->texture));
+    }
+    if (!cache->renderTarget->valid()) {
+        cache->valid = false;
+        return;
+    }
+    cache->renderTarget->blitFromRenderTarget(m_renderTargets[1], rect);
+    cache->rect = rect;
+    cache->valid = true;
+}
+
 void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition)
 {
     glActiveTexture(GL_TEXTURE0);
@@ -25,6 +25,8 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QHash>
+#include <QSharedPointer>
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -57,9 +59,16 @@ public:
 
     void reconfigure(ReconfigureFlags flags) override;
     void prePaintScreen(ScreenPrePaintData &data, int time) override;
+    void postPaintScreen() override;
     void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) override;
     void drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data) override;
     void paintEffectFrame(EffectFrame *frame, const QRegion &region, double opacity, double frameOpacity) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | DrawWindowHook | PaintEffectFrameHook;
+    }
+    bool paintsWindow(const EffectWindow *w) const override;
+
+    QString debug(const QString &parameter) const override;
 
     bool provides(Feature feature) override;
 
@@ -76,6 +85,19 @@ public Q_SLOTS:
     void slotScreenGeometryChanged();
 
 private:
+    /**
+     * The blurred background of a window, a copy of the area of the half sized
+     * render texture which holds the result of the last upsample pass.
+     */
+    struct BlurCache {
+        QRect screen; // the output the background was blurred on
+        GLTexture texture;
+        QSharedPointer<GLRenderTarget> renderTarget;
+        QRegion shape; // the blurred region in screen coordinates
+        QRect rect; // the cached area of m_renderTextures[1]
+        bool valid = false;
+    };
+
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
     bool renderTargetsValid() const;
@@ -85,7 +107,11 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache = nullptr);
+    BlurCache *blurCache(const EffectWindow *w, const QRect &screen);
+    void storeBlurCache(BlurCache *cache, const QRect &rect);
+    void invalidateBlurCache(const EffectWindow *w, const QRect &screen = QRect());
+    void invalidateDamagedBlurCaches();
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
@@ -130,6 +156,23 @@ private:
 
     QVector <BlurValuesStruct> blurStrengthValues;
 
+    // the blurred backgrounds are reused as long as nothing underneath them gets repainted
+    QHash<const EffectWindow*, QVector<BlurCache>> m_blurCache;
+
+    // A blurred window of the current frame together with the damage of the windows below
+    struct BlurredWindow {
+        const EffectWindow *window;
+        QRegion area; // the expanded blur area
+        QRegion damagedBelow;
+    };
+    QVector<BlurredWindow> m_blurredWindows;
+    QRegion m_screenDamage; // the repainted area of the current frame
+    QRegion m_windowDamage; // the part of m_screenDamage caused by the windows themselves
+    QRegion m_damagedBelow; // the damage of the windows (from bottom to top)
+    bool m_blurCacheDamageApplied = true;
+    qint64 m_blurPasses = 0;
+    qint64 m_blurCacheHits = 0;
+
     QMap <EffectWindow*, QMetaObject::Connection> windowBlurChangedConnections;
     KWayland::Server::BlurManagerInterface *m_blurManager = nullptr;
 };
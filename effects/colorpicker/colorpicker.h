@@ -45,6 +45,9 @@ public:
     ~ColorPickerEffect() override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void postPaintScreen() override;
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook | PostPaintScreenHook;
+    }
     bool isActive() const override;
 
     int requestedEffectChainPosition() const override {
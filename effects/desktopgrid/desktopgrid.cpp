@@ -46,6 +46,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QQmlEngine>
 #include <QQuickItem>
 
+#include <kwinglutils.h>
+
 #include <KWayland/Server/surface_interface.h>
 
 #include <cmath>
@@ -94,6 +96,23 @@ DesktopGridEffect::DesktopGridEffect()
     connect(effects, &EffectsHandler::windowGeometryShapeChanged, this, &DesktopGridEffect::slotWindowGeometryShapeChanged);
     connect(effects, &EffectsHandler::numberScreensChanged, this, &DesktopGridEffect::setup);
 
+    // drop the cached renderings of the desktops a window is painted on whenever it changes
+    const auto invalidateWindow = [this](EffectWindow *w) {
+        invalidateRenderCache(w);
+    };
+    const auto invalidateAll = [this] {
+        m_renderCache.invalidateAll();
+    };
+    connect(effects, &EffectsHandler::windowDamaged, this, invalidateWindow);
+    connect(effects, &EffectsHandler::windowOpacityChanged, this, invalidateWindow);
+    connect(effects, &EffectsHandler::windowMinimized, this, invalidateWindow);
+    connect(effects, &EffectsHandler::windowUnminimized, this, invalidateWindow);
+    connect(effects, &EffectsHandler::windowShown, this, invalidateWindow);
+    connect(effects, &EffectsHandler::windowHidden, this, invalidateWindow);
+    connect(effects, &EffectsHandler::desktopPresenceChanged, this, invalidateAll);
+    connect(effects, &EffectsHandler::stackingOrderChanged, this, invalidateAll);
+    connect(effects, &EffectsHandler::virtualScreenGeometryChanged, this, invalidateAll);
+
     connect(effects, &EffectsHandler::screenAboutToLock, this, [this]() {
         setActive(false);
         if (keyboardGrab) {
@@ -111,6 +130,8 @@ DesktopGridEffect::~DesktopGridEffect()
     foreach (DesktopButtonsView *view, m_desktopButtonsViews)
         view->deleteLater();
     m_desktopButtonsViews.clear();
+    effects->makeOpenGLContextCurrent();
+    m_renderCache.clear();
 }
 
 void DesktopGridEffect::reconfigure(ReconfigureFlags)
@@ -136,6 +157,10 @@ void DesktopGridEffect::reconfigure(ReconfigureFlags)
     layoutMode = DesktopGridConfig::layoutMode();
     customLayoutRows = DesktopGridConfig::customLayoutRows();
     m_usePresentWindows = DesktopGridConfig::presentWindows();
+    m_useRenderCache = DesktopGridConfig::renderCache();
+    effects->makeOpenGLContextCurrent();
+    m_renderCache.setBudget(qint64(DesktopGridConfig::renderCacheMemory()) * 1024 * 1024,
+                            DesktopGridConfig::renderCacheResolution() / 100.0);
 
     // deactivate and activate all touch border
     const QVector<ElectricBorder> relevantBorders{ElectricLeft, ElectricTop, ElectricRight, ElectricBottom};
@@ -193,10 +218,25 @@ void DesktopGridEffect::paintScreen(int mask, const QRegion &region, ScreenPaint
         effects->paintScreen(mask, region, data);
         return;
     }
+    const bool useRenderCache = canUseRenderCache(data);
+    if (useRenderCache) {
+        // windows animated by other effects change without being damaged
+        for (EffectWindow *w : effects->stackingOrder()) {
+            if (w->isDeleted() || w->data(WindowAddedGrabRole).value<void *>() || w->data(WindowClosedGrabRole).value<void *>()) {
+                invalidateRenderCache(w);
+            }
+        }
+    }
     for (int desktop = 1; desktop <= effects->numberOfDesktops(); desktop++) {
-        ScreenPaintData d = data;
         paintingDesktop = desktop;
+        if (useRenderCache && paintCachedDesktop(desktop, data)) {
+            continue;
+        }
+        ScreenPaintData d = data;
         effects->paintScreen(mask, region, d);
+        if (useRenderCache) {
+            cacheDesktop(desktop);
+        }
     }
 
     // paint the add desktop button
@@ -256,6 +296,81 @@ void DesktopGridEffect::paintScreen(int mask, const QRegion &region, ScreenPaint
     }
 }
 
+bool DesktopGridEffect::canUseRenderCache(const ScreenPaintData &data) const
+{
+    if (!m_useRenderCache || !activated || timeline.currentValue() != 1.0 || windowMove) {
+        return false;
+    }
+    if (isUsingPresentWindows() && isMotionManagerMovingWindows()) {
+        return false;
+    }
+    // the cached renderings are drawn untransformed
+    if (data.xScale() != 1.0 || data.yScale() != 1.0 || !data.translation().isNull() || data.rotationAngle() != 0.0) {
+        return false;
+    }
+    // Effects later in the chain, e.g. the startup feedback or the screen edge glow, paint
+    // on top of the desktops. Their painting would be captured into the cache.
+    if (effects->hasFollowingPaintScreenEffects()) {
+        return false;
+    }
+    return DesktopRenderCache::supported();
+}
+
+QRect DesktopGridEffect::desktopGeometry(int desktop, int screen) const
+{
+    const QRect screenGeom = effects->clientArea(ScreenArea, screen, 0);
+    const QPointF topLeft = scalePos(screenGeom.topLeft(), desktop, screen);
+    const QPointF bottomRight = scalePos(screenGeom.topLeft() + QPoint(screenGeom.width(), screenGeom.height()), desktop, screen);
+    return QRectF(topLeft, bottomRight).toAlignedRect();
+}
+
+qreal DesktopGridEffect::desktopBrightness(int desktop) const
+{
+    return 1.0 - (0.3 * (1.0 - hoverTimeline[desktop - 1]->currentValue()));
+}
+
+bool DesktopGridEffect::paintCachedDesktop(int desktop, const ScreenPaintData &data)
+{
+    const QRect output = GLRenderTarget::virtualScreenGeometry();
+    const qreal brightness = desktopBrightness(desktop);
+
+    QVector<int> screens;
+    for (int screen = 0; screen < effects->numScreens(); screen++) {
+        const QRect geometry = desktopGeometry(desktop, screen);
+        if (!geometry.intersects(output)) {
+            continue;
+        }
+        if (!m_renderCache.isValid(desktop, screen, geometry, brightness)) {
+            return false;
+        }
+        screens.append(screen);
+    }
+
+    for (const int screen : qAsConst(screens)) {
+        m_renderCache.render(desktop, screen, data.projectionMatrix());
+    }
+    return true;
+}
+
+void DesktopGridEffect::cacheDesktop(int desktop)
+{
+    const QRect output = GLRenderTarget::virtualScreenGeometry();
+    const qreal brightness = desktopBrightness(desktop);
+    for (int screen = 0; screen < effects->numScreens(); screen++) {
+        const QRect geometry = desktopGeometry(desktop, screen);
+        if (output.contains(geometry)) {
+            m_renderCache.capture(desktop, screen, geometry, brightness);
+        }
+    }
+}
+
+void DesktopGridEffect::invalidateRenderCache(const EffectWindow *w)
+{
+    foreach (const int i, desktopList(w)) {
+        m_renderCache.invalidate(i + 1);
+    }
+}
+
 void DesktopGridEffect::postPaintScreen()
 {
     if (activated ? timeline.currentValue() != 1 : timeline.currentValue() != 0)
@@ -331,7 +446,7 @@ void DesktopGridEffect::paintWindow(EffectWindow* w, int mask, QRegion region, W
         qreal xScale = data.xScale();
         qreal yScale = data.yScale();
 
-        data.multiplyBrightness(1.0 - (0.3 * (1.0 - hoverTimeline[paintingDesktop - 1]->currentValue())));
+        data.multiplyBrightness(desktopBrightness(paintingDesktop));
 
         for (int screen = 0; screen < effects->numScreens(); screen++) {
             QRect screenGeom = effects->clientArea(ScreenArea, screen, 0);
@@ -430,6 +545,7 @@ void DesktopGridEffect::slotWindowAdded(EffectWindow* w)
 
 void DesktopGridEffect::slotWindowClosed(EffectWindow* w)
 {
+    invalidateRenderCache(w);
     if (!activated && timeline.currentValue() == 0)
         return;
     if (w == windowMove) {
@@ -448,6 +564,7 @@ void DesktopGridEffect::slotWindowClosed(EffectWindow* w)
 
 void DesktopGridEffect::slotWindowDeleted(EffectWindow* w)
 {
+    invalidateRenderCache(w);
     if (w == windowMove)
         windowMove = nullptr;
     foreach (DesktopButtonsView *view, m_desktopButtonsViews) {
@@ -467,6 +584,7 @@ void DesktopGridEffect::slotWindowDeleted(EffectWindow* w)
 void DesktopGridEffect::slotWindowGeometryShapeChanged(EffectWindow* w, const QRect& old)
 {
     Q_UNUSED(old)
+    invalidateRenderCache(w);
     if (!activated)
         return;
     if (w == windowMove && wasWindowMove)
@@ -1086,6 +1204,7 @@ void DesktopGridEffect::setup()
         effects->setActiveFullScreenEffect(this);
     }
     setHighlightedDesktop(effects->currentDesktop());
+    m_renderCache.invalidateAll();
 
     // Soft highlighting
     qDeleteAll(hoverTimeline);
@@ -1230,6 +1349,7 @@ void DesktopGridEffect::finish()
     keyboardGrab = false;
     effects->stopMouseInterception(this);
     effects->setActiveFullScreenEffect(nullptr);
+    m_renderCache.clear();
     if (isUsingPresentWindows()) {
         while (!m_managers.isEmpty()) {
             m_managers.first().unmanageAll();
@@ -1300,6 +1420,7 @@ void DesktopGridEffect::slotRemoveDesktop()
 
 void DesktopGridEffect::slotNumberDesktopsChanged(uint old)
 {
+    m_renderCache.invalidateAll();
     if (!activated)
         return;
     const uint desktop = effects->numberOfDesktops();
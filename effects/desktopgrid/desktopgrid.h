@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_DESKTOPGRID_H
 #define KWIN_DESKTOPGRID_H
 
+#include "desktoprendercache.h"
+
 #include <kwineffects.h>
 #include <QObject>
 #include <QTimeLine>
@@ -74,6 +76,9 @@ public:
     void postPaintScreen() override;
     void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) override;
     void paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook;
+    }
     void windowInputMouseEvent(QEvent* e) override;
     void grabbedKeyboardEvent(QKeyEvent* e) override;
     bool borderActivated(ElectricBorder border) override;
@@ -139,6 +144,12 @@ private:
     void desktopsAdded(int old);
     void desktopsRemoved(int old);
     QVector<int> desktopList(const EffectWindow *w) const;
+    bool canUseRenderCache(const ScreenPaintData &data) const;
+    QRect desktopGeometry(int desktop, int screen) const;
+    qreal desktopBrightness(int desktop) const;
+    bool paintCachedDesktop(int desktop, const ScreenPaintData &data);
+    void cacheDesktop(int desktop);
+    void invalidateRenderCache(const EffectWindow *w);
 
     QList<ElectricBorder> borderActivate;
     int zoomDuration;
@@ -186,6 +197,8 @@ private:
 
     QAction *m_activateAction;
 
+    DesktopRenderCache m_renderCache;
+    bool m_useRenderCache = false;
 };
 
 } // namespace
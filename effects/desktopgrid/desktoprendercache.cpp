@@ -0,0 +1,151 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "desktoprendercache.h"
+
+#include <kwineffects.h>
+#include <kwinglutils.h>
+
+namespace KWin
+{
+
+static qint64 textureBytes(const GLTexture *texture)
+{
+    return qint64(texture->width()) * texture->height() * 4;
+}
+
+DesktopRenderCache::DesktopRenderCache()
+{
+}
+
+DesktopRenderCache::~DesktopRenderCache()
+{
+    clear();
+}
+
+bool DesktopRenderCache::supported()
+{
+    return effects->isOpenGLCompositing() && GLRenderTarget::supported() && GLRenderTarget::blitSupported();
+}
+
+void DesktopRenderCache::setBudget(qint64 memoryLimit, qreal resolution)
+{
+    if (m_memoryLimit == memoryLimit && qFuzzyCompare(m_resolution, resolution)) {
+        return;
+    }
+    clear();
+    m_memoryLimit = memoryLimit;
+    m_resolution = resolution;
+}
+
+bool DesktopRenderCache::isValid(int desktop, int screen, const QRect &geometry, qreal brightness) const
+{
+    const auto it = m_entries.constFind(qMakePair(desktop, screen));
+    if (it == m_entries.constEnd() || !it->valid) {
+        return false;
+    }
+    return it->geometry == geometry && qFuzzyCompare(it->brightness, brightness);
+}
+
+void DesktopRenderCache::capture(int desktop, int screen, const QRect &geometry, qreal brightness)
+{
+    // the content is read back from the default framebuffer of the output being painted
+    if (GLRenderTarget::isRenderTargetBound() || !GLRenderTarget::virtualScreenGeometry().contains(geometry)) {
+        return;
+    }
+
+    Entry &entry = m_entries[qMakePair(desktop, screen)];
+    entry.valid = false;
+
+    const QSize size = (QSizeF(geometry.size()) * m_resolution).toSize().expandedTo(QSize(1, 1));
+    if (!entry.texture || entry.texture->size() != size) {
+        release(entry);
+        if (m_memoryUsage + qint64(size.width()) * size.height() * 4 > m_memoryLimit) {
+            return;
+        }
+        entry.texture = new GLTexture(GL_RGBA8, size);
+        entry.texture->setFilter(GL_LINEAR);
+        entry.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        entry.texture->setYInverted(false);
+        entry.renderTarget = new GLRenderTarget(*entry.texture);
+        m_memoryUsage += textureBytes(entry.texture);
+    }
+
+    entry.renderTarget->blitFromFramebuffer(geometry, QRect(), size == geometry.size() ? GL_NEAREST : GL_LINEAR);
+    entry.geometry = geometry;
+    entry.brightness = brightness;
+    entry.valid = true;
+}
+
+void DesktopRenderCache::render(int desktop, int screen, const QMatrix4x4 &projection) const
+{
+    const auto it = m_entries.constFind(qMakePair(desktop, screen));
+    if (it == m_entries.constEnd() || !it->valid) {
+        return;
+    }
+
+    QMatrix4x4 mvp = projection;
+    mvp.translate(it->geometry.x(), it->geometry.y());
+
+    ShaderBinder binder(ShaderTrait::MapTexture);
+    binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    it->texture->bind();
+    it->texture->render(infiniteRegion(), it->geometry);
+    it->texture->unbind();
+}
+
+void DesktopRenderCache::invalidate(int desktop)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it.key().first == desktop) {
+            it->valid = false;
+        }
+    }
+}
+
+void DesktopRenderCache::invalidateAll()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        it->valid = false;
+    }
+}
+
+void DesktopRenderCache::clear()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        release(*it);
+    }
+    m_entries.clear();
+}
+
+void DesktopRenderCache::release(Entry &entry)
+{
+    if (entry.texture) {
+        m_memoryUsage -= textureBytes(entry.texture);
+    }
+    delete entry.renderTarget;
+    delete entry.texture;
+    entry.renderTarget = nullptr;
+    entry.texture = nullptr;
+    entry.valid = false;
+}
+
+} // namespace
@@ -0,0 +1,101 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_DESKTOPRENDERCACHE_H
+#define KWIN_DESKTOPRENDERCACHE_H
+
+#include <QHash>
+#include <QPair>
+#include <QRect>
+
+class QMatrix4x4;
+
+namespace KWin
+{
+
+class GLRenderTarget;
+class GLTexture;
+
+/**
+ * Keeps the rendering of a virtual desktop on a screen in an offscreen texture, so that a
+ * desktop which did not change can be drawn as a single textured quad instead of passing its
+ * whole window stack through the effect chain again.
+ *
+ * The content is copied from the framebuffer right after the desktop got painted, which makes
+ * the cached rendering pixel identical to a regular one.
+ */
+class DesktopRenderCache
+{
+public:
+    DesktopRenderCache();
+    ~DesktopRenderCache();
+
+    static bool supported();
+
+    /**
+     * @param memoryLimit The maximum size of all cached textures in bytes
+     * @param resolution The scale of the cached textures relative to the painted geometry
+     */
+    void setBudget(qint64 memoryLimit, qreal resolution);
+    /**
+     * The size of all cached textures in bytes.
+     */
+    qint64 memoryUsage() const {
+        return m_memoryUsage;
+    }
+
+    /**
+     * Whether @p desktop on @p screen has been cached at @p geometry with @p brightness applied.
+     */
+    bool isValid(int desktop, int screen, const QRect &geometry, qreal brightness) const;
+    /**
+     * Copies @p geometry of the framebuffer into the cache of @p desktop on @p screen. Nothing is
+     * cached if the geometry is not fully inside the output being painted or the budget is used up.
+     */
+    void capture(int desktop, int screen, const QRect &geometry, qreal brightness);
+    void render(int desktop, int screen, const QMatrix4x4 &projection) const;
+
+    void invalidate(int desktop);
+    void invalidateAll();
+    /**
+     * Releases all textures.
+     */
+    void clear();
+
+private:
+    struct Entry {
+        GLTexture *texture = nullptr;
+        GLRenderTarget *renderTarget = nullptr;
+        QRect geometry;
+        qreal brightness = 1.0;
+        bool valid = false;
+    };
+    void release(Entry &entry);
+
+    QHash<QPair<int, int>, Entry> m_entries;
+    qint64 m_memoryLimit = 0;
+    qint64 m_memoryUsage = 0;
+    qreal m_resolution = 1.0;
+};
+
+} // namespace
+
+#endif
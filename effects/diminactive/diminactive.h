@@ -48,6 +48,9 @@ public:
     void prePaintScreen(ScreenPrePaintData &data, int time) override;
     void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override;
     void postPaintScreen() override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PostPaintScreenHook | PaintWindowHook;
+    }
 
     int requestedEffectChainPosition() const override;
     bool isActive() const override;
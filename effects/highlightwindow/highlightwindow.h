@@ -36,6 +36,9 @@ public:
 
     void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) override;
     void paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintWindowHook | PaintWindowHook;
+    }
     bool isActive() const override;
 
     int requestedEffectChainPosition() const override {
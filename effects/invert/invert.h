@@ -42,6 +42,9 @@ public:
 
     void drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data) override;
     void paintEffectFrame(KWin::EffectFrame* frame, const QRegion &region, double opacity, double frameOpacity) override;
+    PaintHooks paintHooks() const override {
+        return DrawWindowHook | PaintEffectFrameHook;
+    }
     bool isActive() const override;
     bool provides(Feature) override;
 
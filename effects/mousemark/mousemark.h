@@ -41,6 +41,9 @@ public:
     ~MouseMarkEffect() override;
     void reconfigure(ReconfigureFlags) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData& data) override;
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook;
+    }
     bool isActive() const override;
 
     // for properties
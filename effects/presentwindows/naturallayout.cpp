@@ -0,0 +1,438 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2007 Rivo Laks <rivolaks@hot.ee>
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "naturallayout.h"
+
+#include <QHash>
+#include <QRegion>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KWin
+{
+
+// Windows closer than this to each other are considered to be overlapping.
+static const int s_spacing = 5;
+// The partitioned engine gives up after this many iterations.
+static const int s_maxIterations = 500;
+// The push of the partitioned engine grows by the accuracy every this many iterations.
+static const int s_stepGrowthInterval = 50;
+
+static inline QRect spaced(const QRect &rect)
+{
+    return rect.adjusted(-s_spacing, -s_spacing, s_spacing, s_spacing);
+}
+
+static inline int heightForWidth(const QRect &geometry, int width)
+{
+    return int((width / double(geometry.width())) * geometry.height());
+}
+
+namespace
+{
+
+/**
+ * A sparse grid of window indices to find the windows near a rectangle.
+ */
+class LayoutGrid
+{
+public:
+    LayoutGrid(int cellSize, int count)
+        : m_cellSize(qMax(cellSize, 1))
+        , m_stamps(count, 0)
+    {
+    }
+
+    void insert(int id, const QRect &rect)
+    {
+        const QRect range = cellRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                m_cells[key(x, y)].append(id);
+            }
+        }
+    }
+
+    void remove(int id, const QRect &rect)
+    {
+        const QRect range = cellRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                auto it = m_cells.find(key(x, y));
+                if (it != m_cells.end()) {
+                    it->removeOne(id);
+                }
+            }
+        }
+    }
+
+    /**
+     * The windows sharing a cell with @p rect, in ascending order.
+     */
+    const QVector<int> &near(const QRect &rect)
+    {
+        m_found.clear();
+        ++m_stamp;
+        const QRect range = cellRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const auto it = m_cells.constFind(key(x, y));
+                if (it == m_cells.constEnd()) {
+                    continue;
+                }
+                for (int id : *it) {
+                    if (m_stamps[id] != m_stamp) {
+                        m_stamps[id] = m_stamp;
+                        m_found.append(id);
+                    }
+                }
+            }
+        }
+        std::sort(m_found.begin(), m_found.end());
+        return m_found;
+    }
+
+private:
+    int cell(int coordinate) const
+    {
+        return int(std::floor(coordinate / double(m_cellSize)));
+    }
+    QRect cellRange(const QRect &rect) const
+    {
+        return QRect(QPoint(cell(rect.left()), cell(rect.top())), QPoint(cell(rect.right()), cell(rect.bottom())));
+    }
+    static quint64 key(int x, int y)
+    {
+        return (quint64(quint32(x)) << 32) | quint32(y);
+    }
+
+    int m_cellSize;
+    QHash<quint64, QVector<int>> m_cells;
+    QVector<quint32> m_stamps;
+    quint32 m_stamp = 0;
+    QVector<int> m_found;
+};
+
+}
+
+NaturalLayout::NaturalLayout(const QRect &area, int accuracy, bool fillGaps, Engine engine)
+    : m_area(area)
+    , m_accuracy(accuracy)
+    , m_fillGaps(fillGaps)
+    , m_engine(engine)
+{
+}
+
+QVector<QRect> NaturalLayout::layout(const QVector<QRect> &geometries)
+{
+    m_iterations = 0;
+    if (geometries.isEmpty()) {
+        return QVector<QRect>();
+    }
+
+    QVector<QRect> targets = geometries;
+    QRect bounds = m_area;
+    for (const QRect &geometry : geometries) {
+        bounds = bounds.united(geometry);
+    }
+
+    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations.
+    if (m_engine == BruteForce) {
+        bool overlap;
+        do {
+            overlap = pushApart(targets, bounds);
+            ++m_iterations;
+        } while (overlap);
+    } else {
+        bool overlap = true;
+        while (overlap) {
+            if (m_iterations == s_maxIterations) {
+                return QVector<QRect>();
+            }
+            // the longer it takes the harder the windows get pushed
+            const int step = m_accuracy * (1 + m_iterations / s_stepGrowthInterval);
+            overlap = pushApartPartitioned(targets, bounds, step);
+            ++m_iterations;
+        }
+    }
+
+    // Work out scaling by getting the most top-left and most bottom-right window coords.
+    // The 20's and 10's are so that the windows don't touch the edge of the screen.
+    const QRect &area = m_area;
+    double scale;
+    if (bounds == area)
+        scale = 1.0; // Don't add borders to the screen
+    else if (area.width() / double(bounds.width()) < area.height() / double(bounds.height()))
+        scale = (area.width() - 20) / double(bounds.width());
+    else
+        scale = (area.height() - 20) / double(bounds.height());
+    // Make bounding rect fill the screen size for later steps
+    bounds = QRect(
+                 bounds.x() - (area.width() - 20 - bounds.width() * scale) / 2 - 10 / scale,
+                 bounds.y() - (area.height() - 20 - bounds.height() * scale) / 2 - 10 / scale,
+                 area.width() / scale,
+                 area.height() / scale
+             );
+
+    // Move all windows back onto the screen and set their scale
+    for (QRect &target : targets) {
+        target.setRect((target.x() - bounds.x()) * scale + area.x(),
+                       (target.y() - bounds.y()) * scale + area.y(),
+                       target.width() * scale,
+                       target.height() * scale
+                       );
+    }
+
+    if (m_fillGaps) {
+        fillGaps(geometries, targets, scale);
+    }
+    return targets;
+}
+
+bool NaturalLayout::pushApart(QVector<QRect> &targets, QRect &bounds)
+{
+    bool overlap = false;
+    for (int w = 0; w < targets.count(); ++w) {
+        for (int e = 0; e < targets.count(); ++e) {
+            if (w == e)
+                continue;
+            if (spaced(targets[w]).intersects(spaced(targets[e]))) {
+                overlap = true;
+                push(targets, bounds, w, e, m_accuracy);
+            }
+        }
+    }
+    return overlap;
+}
+
+bool NaturalLayout::pushApartPartitioned(QVector<QRect> &targets, QRect &bounds, int step)
+{
+    // Cells of about the size of an average window, so that a window only has a few neighbours.
+    qint64 extent = 0;
+    for (const QRect &target : targets) {
+        extent += qMax(target.width(), target.height());
+    }
+    LayoutGrid grid(qMax(64, int(extent / targets.count())) + 2 * s_spacing, targets.count());
+    for (int w = 0; w < targets.count(); ++w) {
+        grid.insert(w, spaced(targets[w]));
+    }
+
+    // Windows pushed during this iteration are only found at their old position, which is
+    // fine: an iteration which does not find any overlap did not move anything either.
+    bool overlap = false;
+    for (int w = 0; w < targets.count(); ++w) {
+        const QVector<int> near = grid.near(spaced(targets[w]));
+        for (int e : near) {
+            if (w == e)
+                continue;
+            if (spaced(targets[w]).intersects(spaced(targets[e]))) {
+                overlap = true;
+                push(targets, bounds, w, e, step);
+            }
+        }
+    }
+    return overlap;
+}
+
+void NaturalLayout::push(QVector<QRect> &targets, QRect &bounds, int w, int e, int step) const
+{
+    QRect *target_w = &targets[w];
+    QRect *target_e = &targets[e];
+
+    // Determine pushing direction
+    QPoint diff(target_e->center() - target_w->center());
+    // Prevent dividing by zero and non-movement
+    if (diff.x() == 0 && diff.y() == 0)
+        diff.setX(1);
+    // Approximate a vector of between 10px and 20px in magnitude in the same direction
+    diff *= step / double(diff.manhattanLength());
+    // Move both windows apart
+    target_w->translate(-diff);
+    target_e->translate(diff);
+
+    // Try to keep the bounding rect the same aspect as the screen so that more
+    // screen real estate is utilised. We do this by splitting the screen into nine
+    // equal sections, if the window center is in any of the corner sections pull the
+    // window towards the outer corner. If it is in any of the other edge sections
+    // alternate between each corner on that edge. We don't want to determine it
+    // randomly as it will not produce consistant locations when using the filter.
+    // Only move one window so we don't cause large amounts of unnecessary zooming
+    // in some situations. We need to do this even when expanding later just in case
+    // all windows are the same size.
+    // (We are using an old bounding rect for this, hopefully it doesn't matter)
+    // The position in the list is used as a preferred direction for windows in the
+    // middle of an edge.
+    const int direction = w % 4;
+    int xSection = (target_w->x() - bounds.x()) / (bounds.width() / 3);
+    int ySection = (target_w->y() - bounds.y()) / (bounds.height() / 3);
+    diff = QPoint(0, 0);
+    if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+        if (xSection == 1)
+            xSection = (direction / 2 ? 2 : 0);
+        if (ySection == 1)
+            ySection = (direction % 2 ? 2 : 0);
+    }
+    if (xSection == 0 && ySection == 0)
+        diff = QPoint(bounds.topLeft() - target_w->center());
+    if (xSection == 2 && ySection == 0)
+        diff = QPoint(bounds.topRight() - target_w->center());
+    if (xSection == 2 && ySection == 2)
+        diff = QPoint(bounds.bottomRight() - target_w->center());
+    if (xSection == 0 && ySection == 2)
+        diff = QPoint(bounds.bottomLeft() - target_w->center());
+    if (diff.x() != 0 || diff.y() != 0) {
+        diff *= step / double(diff.manhattanLength());
+        target_w->translate(diff);
+    }
+
+    // Update bounding rect
+    bounds = bounds.united(*target_w);
+    bounds = bounds.united(*target_e);
+}
+
+void NaturalLayout::fillGaps(const QVector<QRect> &geometries, QVector<QRect> &targets, double scale) const
+{
+    const QRect &area = m_area;
+    // Don't expand onto or over the border
+    QRegion borderRegion(area.adjusted(-200, -200, 200, 200));
+    borderRegion ^= area.adjusted(10 / scale, 10 / scale, -10 / scale, -10 / scale);
+
+    const bool partitioned = m_engine == Partitioned;
+    LayoutGrid grid(qMax(64, area.width() / 8), targets.count());
+    if (partitioned) {
+        for (int w = 0; w < targets.count(); ++w) {
+            grid.insert(w, spaced(targets[w]));
+        }
+    }
+    auto isOverlappingAny = [&](int w) {
+        const QRect &target = targets[w];
+        if (borderRegion.intersects(target))
+            return true;
+        if (partitioned) {
+            for (int e : grid.near(spaced(target))) {
+                if (e != w && spaced(target).intersects(spaced(targets[e])))
+                    return true;
+            }
+            return false;
+        }
+        for (int e = 0; e < targets.count(); ++e) {
+            if (e != w && spaced(target).intersects(spaced(targets[e])))
+                return true;
+        }
+        return false;
+    };
+    // Moves the target of w to rect unless that causes an overlap
+    auto tryTarget = [&](int w, const QRect &rect) {
+        const QRect oldRect = targets[w];
+        targets[w] = rect;
+        if (isOverlappingAny(w)) {
+            targets[w] = oldRect;
+            return false;
+        }
+        if (partitioned) {
+            grid.remove(w, spaced(oldRect));
+            grid.insert(w, spaced(rect));
+        }
+        return true;
+    };
+
+    bool moved;
+    do {
+        moved = false;
+        for (int w = 0; w < targets.count(); ++w) {
+            const QRect &geometry = geometries[w];
+            const QRect &target = targets[w];
+            // This may cause some slight distortion if the windows are enlarged a large amount
+            int widthDiff = m_accuracy;
+            int heightDiff = heightForWidth(geometry, target.width() + widthDiff) - target.height();
+            int xDiff = widthDiff / 2;  // Also move a bit in the direction of the enlarge, allows the
+            int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
+
+            // heightDiff (and yDiff) will be re-computed after each successful enlargement attempt
+            // so that the error introduced in the window's aspect ratio is minimized
+
+            // Attempt enlarging to the top-right
+            if (tryTarget(w, QRect(target.x() + xDiff,
+                                   target.y() - yDiff - heightDiff,
+                                   target.width() + widthDiff,
+                                   target.height() + heightDiff))) {
+                moved = true;
+                heightDiff = heightForWidth(geometry, target.width() + widthDiff) - target.height();
+                yDiff = heightDiff / 2;
+            }
+
+            // Attempt enlarging to the bottom-right
+            if (tryTarget(w, QRect(target.x() + xDiff,
+                                   target.y() + yDiff,
+                                   target.width() + widthDiff,
+                                   target.height() + heightDiff))) {
+                moved = true;
+                heightDiff = heightForWidth(geometry, target.width() + widthDiff) - target.height();
+                yDiff = heightDiff / 2;
+            }
+
+            // Attempt enlarging to the bottom-left
+            if (tryTarget(w, QRect(target.x() - xDiff - widthDiff,
+                                   target.y() + yDiff,
+                                   target.width() + widthDiff,
+                                   target.height() + heightDiff))) {
+                moved = true;
+                heightDiff = heightForWidth(geometry, target.width() + widthDiff) - target.height();
+                yDiff = heightDiff / 2;
+            }
+
+            // Attempt enlarging to the top-left
+            if (tryTarget(w, QRect(target.x() - xDiff - widthDiff,
+                                   target.y() - yDiff - heightDiff,
+                                   target.width() + widthDiff,
+                                   target.height() + heightDiff))) {
+                moved = true;
+            }
+        }
+    } while (moved);
+
+    // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
+    // We can't add this to the loop above as it would cause a never-ending loop so we have to make
+    // do with the less-than-optimal space usage with using this method.
+    for (int w = 0; w < targets.count(); ++w) {
+        const QRect &geometry = geometries[w];
+        QRect &target = targets[w];
+        double scale = target.width() / double(geometry.width());
+        if (scale > 2.0 || (scale > 1.0 && (geometry.width() > 300 || geometry.height() > 300))) {
+            scale = (geometry.width() > 300 || geometry.height() > 300) ? 1.0 : 2.0;
+            target.setRect(
+                           target.center().x() - int(geometry.width() * scale) / 2,
+                           target.center().y() - int(geometry.height() * scale) / 2,
+                           geometry.width() * scale,
+                           geometry.height() * scale);
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,95 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2007 Rivo Laks <rivolaks@hot.ee>
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_PRESENTWINDOWS_NATURALLAYOUT_H
+#define KWIN_PRESENTWINDOWS_NATURALLAYOUT_H
+
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The "natural" layout of the PresentWindows effect.
+ *
+ * Starting from their current geometries, overlapping windows are pushed apart until no two
+ * windows overlap any more. The result is scaled to fit into the area and optionally the windows
+ * are enlarged into the gaps which are left.
+ *
+ * The layout only works on rectangles and does not touch any EffectWindow, so it can be computed
+ * on a worker thread.
+ */
+class NaturalLayout
+{
+public:
+    enum Engine {
+        /**
+         * Every pair of windows is tested in every iteration until nothing overlaps any more.
+         */
+        BruteForce,
+        /**
+         * Windows are only tested against the windows in neighbouring cells of a grid. The push
+         * grows with the number of iterations and the number of iterations is bounded.
+         */
+        Partitioned
+    };
+
+    NaturalLayout(const QRect &area, int accuracy, bool fillGaps, Engine engine = Partitioned);
+
+    /**
+     * Lays out windows with the given @p geometries. The order of the geometries has to be
+     * stable, it decides in which direction windows at the edges are pulled.
+     *
+     * @returns the target geometries in the order of @p geometries, or an empty list if the
+     * layout did not converge within the bounds of the engine
+     */
+    QVector<QRect> layout(const QVector<QRect> &geometries);
+
+    /**
+     * The number of push iterations the last layout() needed.
+     */
+    int iterations() const {
+        return m_iterations;
+    }
+
+private:
+    bool pushApart(QVector<QRect> &targets, QRect &bounds);
+    bool pushApartPartitioned(QVector<QRect> &targets, QRect &bounds, int step);
+    void push(QVector<QRect> &targets, QRect &bounds, int w, int e, int step) const;
+    void fillGaps(const QVector<QRect> &geometries, QVector<QRect> &targets, double scale) const;
+
+    QRect m_area;
+    int m_accuracy;
+    bool m_fillGaps;
+    Engine m_engine;
+    int m_iterations = 0;
+};
+
+} // namespace
+
+#endif
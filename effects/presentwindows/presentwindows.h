@@ -104,6 +104,9 @@ public:
     // Window painting
     void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, int time) override;
     void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook;
+    }
 
     // User interaction
     bool borderActivated(ElectricBorder border) override;
@@ -238,7 +241,8 @@ protected:
     inline int heightForWidth(EffectWindow *w, int width) {
         return int((width / double(w->width())) * w->height());
     }
-    bool isOverlappingAny(EffectWindow *w, const QHash<EffectWindow*, QRect> &targets, const QRegion &border);
+    void startNaturalLayout(const EffectWindowList &windowlist, int screen, const QRect &area,
+                            const QVector<QRect> &geometries);
 
     // Filter box
     void updateFilterFrame();
@@ -270,9 +274,14 @@ private:
     bool m_doNotCloseWindows;
     int m_accuracy;
     bool m_fillGaps;
+    bool m_asyncLayout;
     double m_fadeDuration;
     bool m_showPanel;
 
+    // Natural layouts computed on a worker thread, the latest request per screen
+    QHash<int, quint64> m_pendingLayouts;
+    quint64 m_layoutSerial = 0;
+
     // Activation
     bool m_activated;
     bool m_ignoreMinimized;
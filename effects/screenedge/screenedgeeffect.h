@@ -38,6 +38,9 @@ public:
     ~ScreenEdgeEffect() override;
     void prePaintScreen(ScreenPrePaintData &data, int time) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook;
+    }
     bool isActive() const override;
 
     int requestedEffectChainPosition() const override {
@@ -52,6 +52,9 @@ public:
 
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void postPaintScreen() override;
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook | PostPaintScreenHook;
+    }
     bool isActive() const override;
 
     int requestedEffectChainPosition() const override {
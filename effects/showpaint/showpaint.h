@@ -35,6 +35,9 @@ public:
 
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override;
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook | PaintWindowHook;
+    }
 
     bool isActive() const override;
 
@@ -40,6 +40,9 @@ public:
     void prePaintScreen(ScreenPrePaintData &data, int time) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void postPaintScreen() override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook;
+    }
 
     bool isActive() const override;
 
@@ -48,6 +48,9 @@ public:
     void reconfigure(ReconfigureFlags) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData& data) override;
     void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override;
+    PaintHooks paintHooks() const override {
+        return PaintScreenHook | PaintWindowHook;
+    }
 
     // for properties
     int configuredMaxWidth() const {
@@ -46,6 +46,9 @@ public:
     void prePaintScreen(KWin::ScreenPrePaintData &data, int time) override;
     void prePaintWindow(KWin::EffectWindow* w, KWin::WindowPrePaintData& data, int time) override;
     void drawWindow(KWin::EffectWindow* w, int mask, const QRegion& region, KWin::WindowPaintData& data) override;
+    PaintHooks paintHooks() const override {
+        return PrePaintScreenHook | PrePaintWindowHook | DrawWindowHook;
+    }
 
 private:
     KWin::GLShader *m_ubrShader = nullptr;
@@ -257,20 +257,11 @@ bool Workspace::workspaceEvent(xcb_generic_event_t *e)
     };
 
     const xcb_window_t eventWindow = findEventWindow(e);
-    if (eventWindow != XCB_WINDOW_NONE) {
-        if (X11Client *c = findClient(Predicate::WindowMatch, eventWindow)) {
+    if (Toplevel *t = findX11Toplevel(eventWindow)) {
+        if (X11Client *c = qobject_cast<X11Client *>(t)) {
             if (c->windowEvent(e))
                 return true;
-        } else if (X11Client *c = findClient(Predicate::WrapperIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (X11Client *c = findClient(Predicate::FrameIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (X11Client *c = findClient(Predicate::InputIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (Unmanaged* c = findUnmanaged(eventWindow)) {
+        } else if (Unmanaged* c = qobject_cast<Unmanaged *>(t)) {
             if (c->windowEvent(e))
                 return true;
         }
@@ -248,6 +248,22 @@ bool processShortcut(Qt::KeyboardModifiers mods, T key, U &shortcuts)
     return true;
 }
 
+void GlobalShortcutsManager::setKGlobalAccelInterface(KGlobalAccelInterface *interface)
+{
+    m_kglobalAccelInterface = interface;
+    m_kglobalAccelKeys.clear();
+    m_checkKeyPressedMethod = QMetaMethod();
+    if (interface) {
+        const QMetaObject *metaObject = interface->metaObject();
+        m_checkKeyPressedMethod = metaObject->method(metaObject->indexOfMethod("checkKeyPressed(int)"));
+    }
+}
+
+void GlobalShortcutsManager::setKGlobalAccelKeys(const QSet<int> &keys)
+{
+    m_kglobalAccelKeys = keys;
+}
+
 bool GlobalShortcutsManager::processKey(Qt::KeyboardModifiers mods, int keyQt)
 {
     if (m_kglobalAccelInterface) {
@@ -255,12 +271,15 @@ bool GlobalShortcutsManager::processKey(Qt::KeyboardModifiers mods, int keyQt)
             return false;
         }
         auto check = [this] (Qt::KeyboardModifiers mods, int keyQt) {
+            const int key = int(mods) | keyQt;
+            if (!m_kglobalAccelKeys.contains(key)) {
+                return false;
+            }
             bool retVal = false;
-            QMetaObject::invokeMethod(m_kglobalAccelInterface,
-                                        "checkKeyPressed",
-                                        Qt::DirectConnection,
-                                        Q_RETURN_ARG(bool, retVal),
-                                        Q_ARG(int, int(mods) | keyQt));
+            m_checkKeyPressedMethod.invoke(m_kglobalAccelInterface,
+                                           Qt::DirectConnection,
+                                           Q_RETURN_ARG(bool, retVal),
+                                           Q_ARG(int, key));
             return retVal;
         };
         if (check(mods, keyQt)) {
@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwinglobals.h>
 // Qt
 #include <QKeySequence>
+#include <QMetaMethod>
+#include <QSet>
 
 class QAction;
 class KGlobalAccelD;
@@ -102,9 +104,17 @@ public:
     void processSwipeCancel();
     void processSwipeEnd();
 
-    void setKGlobalAccelInterface(KGlobalAccelInterface *interface) {
-        m_kglobalAccelInterface = interface;
-    }
+    void setKGlobalAccelInterface(KGlobalAccelInterface *interface);
+    /**
+     * @brief Sets the key combinations kglobalaccel holds a grab on.
+     *
+     * The kglobalaccel plugin pushes the combinations whenever a shortcut gets registered or
+     * unregistered, so that processKey() only has to call into kglobalaccel for a key press
+     * that can match a shortcut.
+     *
+     * @param keys The grabbed keys, each one a Qt::Key combined with its Qt::KeyboardModifiers
+     */
+    void setKGlobalAccelKeys(const QSet<int> &keys);
 
 private:
     void objectDeleted(QObject *object);
@@ -113,6 +123,8 @@ private:
     QHash<Qt::KeyboardModifiers, QHash<SwipeDirection, GlobalShortcut*> > m_swipeShortcuts;
     KGlobalAccelD *m_kglobalAccel = nullptr;
     KGlobalAccelInterface *m_kglobalAccelInterface = nullptr;
+    QMetaMethod m_checkKeyPressedMethod;
+    QSet<int> m_kglobalAccelKeys;
     GestureRecognizer *m_gestureRecognizer;
 };
 
@@ -229,6 +229,11 @@ void InputEventFilter::passToWaylandServer(QKeyEvent *event)
     }
 }
 
+void InputEventFilter::resolveText(QKeyEvent *event)
+{
+    input()->keyboard()->resolveText(static_cast<KeyEvent *>(event));
+}
+
 class VirtualTerminalFilter : public InputEventFilter {
 public:
     bool keyEvent(QKeyEvent *event) override {
@@ -304,6 +309,7 @@ public:
         // if event is set to accepted it means a whitelisted shortcut was triggered
         // in that case we filter it out and don't process it further
         event->setAccepted(false);
+        resolveText(event);
         QCoreApplication::sendEvent(ScreenLocker::KSldApp::self(), event);
         if (event->isAccepted()) {
             return true;
@@ -458,6 +464,7 @@ public:
         }
         waylandServer()->seat()->setFocusedKeyboardSurface(nullptr);
         passToWaylandServer(event);
+        resolveText(event);
         static_cast< EffectsHandlerImpl* >(effects)->grabbedKeyboardEvent(event);
         return true;
     }
@@ -947,6 +954,7 @@ class InternalWindowEventFilter : public InputEventFilter {
             // workaround for QTBUG-62102
             key = Qt::Key_Meta;
         }
+        resolveText(event);
         QKeyEvent internalEvent(event->type(), key,
                                 event->modifiers(), event->nativeScanCode(), event->nativeVirtualKey(),
                                 event->nativeModifiers(), event->text());
@@ -2308,6 +2316,11 @@ void InputRedirection::registerGlobalAccel(KGlobalAccelInterface *interface)
     m_shortcuts->setKGlobalAccelInterface(interface);
 }
 
+void InputRedirection::registerGlobalAccelKeys(const QSet<int> &keys)
+{
+    m_shortcuts->setKGlobalAccelKeys(keys);
+}
+
 void InputRedirection::warpPointer(const QPointF &pos)
 {
     m_pointer->warp(pos);
@@ -132,6 +132,10 @@ public:
     void registerAxisShortcut(Qt::KeyboardModifiers modifiers, PointerAxisDirection axis, QAction *action);
     void registerTouchpadSwipeShortcut(SwipeDirection direction, QAction *action);
     void registerGlobalAccel(KGlobalAccelInterface *interface);
+    /**
+     * Updates the key combinations the registered KGlobalAccelInterface holds a grab on.
+     */
+    void registerGlobalAccelKeys(const QSet<int> &keys);
 
     /**
      * @internal
@@ -396,6 +400,11 @@ public:
 
 protected:
     void passToWaylandServer(QKeyEvent *event);
+    /**
+     * Converts the keysym of @p event into its text, unless that already happened. Has to be
+     * called before handing the event to anything which uses QKeyEvent::text().
+     */
+    void resolveText(QKeyEvent *event);
 };
 
 class UKUI_KWIN_EXPORT InputDeviceHandler : public QObject
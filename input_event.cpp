@@ -52,6 +52,16 @@ KeyEvent::KeyEvent(QEvent::Type type, Qt::Key key, Qt::KeyboardModifiers modifie
                    const QString &text, bool autorepeat, quint32 timestamp, LibInput::Device *device)
          : QKeyEvent(type, key, modifiers, code, keysym, 0, text, autorepeat)
          , m_device(device)
+         , m_textResolved(true)
+{
+    setTimestamp(timestamp);
+}
+
+KeyEvent::KeyEvent(QEvent::Type type, Qt::Key key, Qt::KeyboardModifiers modifiers, quint32 code, quint32 keysym,
+                   bool autorepeat, quint32 timestamp, LibInput::Device *device)
+         : QKeyEvent(type, key, modifiers, code, keysym, 0, QString(), autorepeat)
+         , m_device(device)
+         , m_textResolved(false)
 {
     setTimestamp(timestamp);
 }
@@ -131,6 +131,12 @@ class KeyEvent : public QKeyEvent
 public:
     explicit KeyEvent(QEvent::Type type, Qt::Key key, Qt::KeyboardModifiers modifiers, quint32 code, quint32 keysym,
                       const QString &text, bool autorepeat, quint32 timestamp, LibInput::Device *device);
+    /**
+     * Creates a KeyEvent without text. Converting the keysym into text is deferred until a
+     * filter or spy needs it, see KeyboardInputRedirection::resolveText.
+     */
+    explicit KeyEvent(QEvent::Type type, Qt::Key key, Qt::KeyboardModifiers modifiers, quint32 code, quint32 keysym,
+                      bool autorepeat, quint32 timestamp, LibInput::Device *device);
 
     LibInput::Device *device() const {
         return m_device;
@@ -144,9 +150,19 @@ public:
         m_modifiersRelevantForShortcuts = mods;
     }
 
+    bool isTextResolved() const {
+        return m_textResolved;
+    }
+
+    void setText(const QString &text) {
+        txt = text;
+        m_textResolved = true;
+    }
+
 private:
     LibInput::Device *m_device;
     Qt::KeyboardModifiers m_modifiersRelevantForShortcuts = Qt::KeyboardModifiers();
+    bool m_textResolved;
 };
 
 class SwitchEvent : public QInputEvent
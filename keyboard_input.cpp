@@ -218,7 +218,6 @@ void KeyboardInputRedirection::processKey(uint32_t key, InputRedirection::Keyboa
                    m_xkb->modifiers(),
                    key,
                    keySym,
-                   m_xkb->toString(keySym),
                    autoRepeat,
                    time,
                    device);
@@ -244,6 +243,14 @@ void KeyboardInputRedirection::processModifiers(uint32_t modsDepressed, uint32_t
     m_keyboardLayout->checkLayoutChange();
 }
 
+void KeyboardInputRedirection::resolveText(KeyEvent *event) const
+{
+    if (event->isTextResolved()) {
+        return;
+    }
+    event->setText(m_xkb->toString(event->nativeVirtualKey()));
+}
+
 void KeyboardInputRedirection::processKeymapChange(int fd, uint32_t size)
 {
     if (!m_inited) {
@@ -50,6 +50,7 @@ namespace KWin
 {
 
 class InputRedirection;
+class KeyEvent;
 class KeyboardLayout;
 class ModifiersChangedSpy;
 class Toplevel;
@@ -92,6 +93,11 @@ public:
     Qt::KeyboardModifiers modifiersRelevantForGlobalShortcuts() const {
         return m_xkb->modifiersRelevantForGlobalShortcuts();
     }
+    /**
+     * Converts the keysym of @p event into its text, unless that already happened. Has to be
+     * called before anything uses QKeyEvent::text() of an event created by processKey.
+     */
+    void resolveText(KeyEvent *event) const;
 
 Q_SIGNALS:
     void ledsChanged(KWin::Xkb::LEDs);
@@ -97,6 +97,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "wayland_server.h"
 #include "internal_client.h"
 
+#include <algorithm>
+
 #include <QDebug>
 
 namespace KWin
@@ -119,7 +121,12 @@ void Workspace::updateStackingOrder(bool propagate_new_clients)
             blocked_propagating_new_clients = true;
         return;
     }
-    QList<Toplevel *> new_stacking_order = constrainedStackingOrder();
+    QList<Toplevel *> new_stacking_order = stacking_order;
+    if (!moveRestackedClient(new_stacking_order)) {
+        new_stacking_order = constrainedStackingOrder();
+    }
+    m_restackedClient = nullptr;
+    m_restackCount = 0;
     bool changed = (force_restacking || new_stacking_order != stacking_order);
     force_restacking = false;
     stacking_order = new_stacking_order;
@@ -314,10 +321,12 @@ void Workspace::lowerClient(AbstractClient* c, bool nogroup)
 
     c->cancelAutoRaise();
 
+    const bool batched = block_stacking_updates > 0;
     StackingUpdatesBlocker blocker(this);
 
     unconstrained_stacking_order.removeAll(c);
     unconstrained_stacking_order.prepend(c);
+    recordRestack(c, batched);
     if (!nogroup && c->isTransient()) {
         // lower also all windows in the group, in their reversed stacking order
         QList<X11Client *> wins;
@@ -373,6 +382,7 @@ void Workspace::raiseClient(AbstractClient* c, bool nogroup)
 
     c->cancelAutoRaise();
 
+    const bool batched = block_stacking_updates > 0;
     StackingUpdatesBlocker blocker(this);
 
     if (!nogroup && c->isTransient()) {
@@ -386,6 +396,7 @@ void Workspace::raiseClient(AbstractClient* c, bool nogroup)
 
     unconstrained_stacking_order.removeAll(c);
     unconstrained_stacking_order.append(c);
+    recordRestack(c, batched);
 
     if (!c->isSpecialWindow()) {
         most_recently_raised = c;
@@ -461,6 +472,7 @@ void Workspace::restack(AbstractClient* c, AbstractClient* under, bool force)
     if (under) {
         unconstrained_stacking_order.removeAll(c);
         unconstrained_stacking_order.insert(unconstrained_stacking_order.indexOf(under), c);
+        recordRestack(c, block_stacking_updates > 0);
     }
 
     Q_ASSERT(unconstrained_stacking_order.contains(c));
@@ -498,12 +510,89 @@ void Workspace::restoreSessionStackingOrder(X11Client *c)
     unconstrained_stacking_order.append(c);
 }
 
+/**
+ * Remembers that \a c was moved in the unconstrained stacking order. If it is the only
+ * change until the next stacking update and was not made while updates were \a batched
+ * with other changes, updateStackingOrder() can move the window in the constrained
+ * order instead of rebuilding it.
+ */
+void Workspace::recordRestack(AbstractClient *c, bool batched)
+{
+    ++m_restackCount;
+    m_restackedClient = batched ? nullptr : c;
+}
+
+/**
+ * Applies the recorded move of a single window to the constrained stacking order
+ * \a stacking. This is only done if the window takes no part in keeping transients
+ * above their main windows and is alone in its window group, so the move changes
+ * neither its layer nor the layer of any other window. The window is put below the
+ * first window that is above it in the layered unconstrained order, transients that
+ * have been moved above their main windows keep their places.
+ *
+ * Returns \c false if the constrained stacking order has to be rebuilt.
+ */
+bool Workspace::moveRestackedClient(QList<Toplevel *> &stacking) const
+{
+    AbstractClient *c = m_restackedClient;
+    if (!c || m_restackCount != 1 || stacking.size() != unconstrained_stacking_order.size()) {
+        return false;
+    }
+    if (c->isTransient() || !c->transients().isEmpty()) {
+        return false;
+    }
+    if (qobject_cast<X11Client *>(c) && (!c->group() || c->group()->members().count() > 1)) {
+        return false;
+    }
+    for (const Deleted *transient : deleted) {
+        if (transient->wasTransientFor(c)) {
+            return false;
+        }
+    }
+    const Layer layer = c->layer();
+    if (m_stackingLayers.value(c, UnknownLayer) != layer) {
+        return false;
+    }
+
+    const int index = unconstrained_stacking_order.indexOf(c);
+    if (index == -1 || !stacking.removeOne(c)) {
+        return false;
+    }
+    // Windows of the same layer that are above the moved window. Nothing is above
+    // a raised window and everything is above a lowered window.
+    const bool lowered = index == 0;
+    QSet<Toplevel *> above;
+    if (!lowered) {
+        above.reserve(unconstrained_stacking_order.size() - index - 1);
+        for (int i = index + 1; i < unconstrained_stacking_order.size(); ++i) {
+            above.insert(unconstrained_stacking_order.at(i));
+        }
+    }
+    int position = stacking.size();
+    for (int i = 0; i < stacking.size(); ++i) {
+        Toplevel *window = stacking.at(i);
+        const Layer windowLayer = m_stackingLayers.value(window, UnknownLayer);
+        if (windowLayer == UnknownLayer) {
+            return false;
+        }
+        if (windowLayer > layer || (windowLayer == layer && (lowered || above.contains(window)))) {
+            position = i;
+            break;
+        }
+    }
+    stacking.insert(position, c);
+    return true;
+}
+
 /**
  * Returns a stacking order based upon \a list that fulfills certain contained.
+ * The layer each window ended up in is remembered for moveRestackedClient().
  */
 QList<Toplevel *> Workspace::constrainedStackingOrder()
 {
     QList<Toplevel *> layer[ NumLayers ];
+    m_stackingLayers.clear();
+    m_stackingLayers.reserve(unconstrained_stacking_order.size());
 
     // build the order from layers
     QVector< QMap<Group*, Layer> > minimum_layer(screens()->count());
@@ -525,13 +614,49 @@ QList<Toplevel *> Workspace::constrainedStackingOrder()
             minimum_layer[screen].insertMulti(c->group(), l);
         }
         layer[ l ].append(*it);
+        m_stackingLayers.insert(*it, l);
     }
     QList<Toplevel *> stacking;
     for (int lay = FirstLayer; lay < NumLayers; ++lay) {
         stacking += layer[lay];
     }
     // now keep transients above their mainwindows
-    // TODO this could(?) use some optimization
+    // Instead of searching the whole stacking order for the main windows of every transient,
+    // the positions of all windows are tracked, so only the (few) main windows of a transient
+    // have to be looked at. Positions are updated only for the range a transient is moved across.
+    QHash<Toplevel *, int> positions;
+    positions.reserve(stacking.size());
+    for (int i = 0; i < stacking.size(); ++i) {
+        positions.insert(stacking.at(i), i);
+    }
+    // Deleted transients indexed by the windows they were transient for.
+    QHash<Toplevel *, QVector<Deleted *>> deletedTransients;
+    for (Deleted *deleted : deletedList()) {
+        const auto mainWindows = deleted->mainWindows();
+        for (Toplevel *mainWindow : mainWindows) {
+            deletedTransients[mainWindow].append(deleted);
+        }
+    }
+    // All direct and indirect main windows of a transient, resolved once per transient.
+    QHash<AbstractClient *, QVector<AbstractClient *>> leads;
+    auto leadsOf = [&leads](AbstractClient *client) -> const QVector<AbstractClient *> & {
+        auto it = leads.find(client);
+        if (it == leads.end()) {
+            QVector<AbstractClient *> result;
+            QList<AbstractClient *> pending = client->mainClients();
+            while (!pending.isEmpty()) {
+                AbstractClient *lead = pending.takeLast();
+                if (lead == client || result.contains(lead)) {
+                    continue;
+                }
+                result.append(lead);
+                pending += lead->mainClients();
+            }
+            it = leads.insert(client, result);
+        }
+        return *it;
+    };
+
     for (int i = stacking.size() - 1; i >= 0;) {
         // Index of the main window for the current transient window.
         int i2 = -1;
@@ -547,18 +672,13 @@ QList<Toplevel *> Workspace::constrainedStackingOrder()
                 --i;
                 continue;
             }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                auto *c2 = qobject_cast<AbstractClient *>(stacking[i2]);
-                if (!c2) {
-                    continue;
-                }
-                if (c2 == client) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
-                }
-                if (c2->hasTransient(client, true)
-                        && keepTransientAbove(c2, client)) {
-                    break;
+            // Main windows below the transient don't cause a reorder.
+            for (AbstractClient *lead : leadsOf(client)) {
+                const int position = positions.value(lead, -1);
+                if (position > i && position > i2
+                        && lead->hasTransient(client, true)
+                        && keepTransientAbove(lead, client)) {
+                    i2 = position;
                 }
             }
 
@@ -566,34 +686,24 @@ QList<Toplevel *> Workspace::constrainedStackingOrder()
 
             // If the current transient doesn't have any "alive" transients, check
             // whether it has deleted transients that have to be raised.
-            const bool searchForDeletedTransients = !hasTransients
-                && !deletedList().isEmpty();
-            if (searchForDeletedTransients) {
-                for (int j = i + 1; j < stacking.count(); ++j) {
-                    auto *deleted = qobject_cast<Deleted *>(stacking[j]);
-                    if (!deleted) {
-                        continue;
-                    }
-                    if (deleted->wasTransientFor(client)) {
-                        hasTransients = true;
-                        break;
-                    }
-                }
+            if (!hasTransients) {
+                const auto deleted = deletedTransients.value(client);
+                hasTransients = std::any_of(deleted.constBegin(), deleted.constEnd(),
+                    [&positions, i](Deleted *transient) {
+                        return positions.value(transient, -1) > i;
+                    });
             }
         } else if (auto *deleted = qobject_cast<Deleted *>(stacking[i])) {
             if (!deleted->wasTransient()) {
                 --i;
                 continue;
             }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                Toplevel *c2 = stacking[i2];
-                if (c2 == deleted) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
-                }
-                if (deleted->wasTransientFor(c2)
-                        && keepDeletedTransientAbove(c2, deleted)) {
-                    break;
+            const auto mainWindows = deleted->mainWindows();
+            for (Toplevel *mainWindow : mainWindows) {
+                const int position = positions.value(mainWindow, -1);
+                if (position > i && position > i2
+                        && keepDeletedTransientAbove(mainWindow, deleted)) {
+                    i2 = position;
                 }
             }
             hasTransients = !deleted->transients().isEmpty();
@@ -604,16 +714,18 @@ QList<Toplevel *> Workspace::constrainedStackingOrder()
             continue;
         }
 
-        Toplevel *current = stacking[i];
-
-        stacking.removeAt(i);
-        --i; // move onto the next item (for next for () iteration)
-        --i2; // adjust index of the mainwindow after the remove above
-        if (hasTransients) {  // this one now can be possibly above its transients,
-            i = i2; // so go again higher in the stack order and possibly move those transients again
+        // Put the transient on top of its main window, the windows in between move down by one.
+        stacking.move(i, i2);
+        for (int j = i; j <= i2; ++j) {
+            positions[stacking.at(j)] = j;
+        }
+        if (hasTransients) {
+            // this one now can be possibly above its transients,
+            // so go again higher in the stack order and possibly move those transients again
+            i = i2 - 1;
+        } else {
+            --i; // move onto the next item
         }
-        ++i2; // insert after (on top of) the mainwindow, it's ok if it2 is now stacking.end()
-        stacking.insert(i2, current);
     }
     return stacking;
 }
@@ -92,6 +92,11 @@ bool AnimationEffect::isActive() const
     return !d->m_animations.isEmpty();
 }
 
+Effect::PaintHooks AnimationEffect::paintHooks() const
+{
+    return PrePaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook;
+}
+
 
 #define RELATIVE_XY(_FIELD_) const bool relative[2] = { static_cast<bool>(metaData(Relative##_FIELD_##X, meta)), \
                                                         static_cast<bool>(metaData(Relative##_FIELD_##Y, meta)) }
@@ -180,6 +180,7 @@ public:
     ~AnimationEffect() override;
 
     bool isActive() const override;
+    PaintHooks paintHooks() const override;
 
     /**
      * Gets stored metadata.
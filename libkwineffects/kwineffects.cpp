@@ -611,6 +611,17 @@ bool Effect::isActive() const
     return true;
 }
 
+Effect::PaintHooks Effect::paintHooks() const
+{
+    return AllPaintHooks;
+}
+
+bool Effect::paintsWindow(const EffectWindow *w) const
+{
+    Q_UNUSED(w)
+    return true;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -938,6 +949,7 @@ bool WindowQuad::smoothNeeded() const
 WindowQuadList WindowQuadList::splitAtX(double x) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2);
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -970,6 +982,7 @@ WindowQuadList WindowQuadList::splitAtX(double x) const
 WindowQuadList WindowQuadList::splitAtY(double y) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2);
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -1022,6 +1035,9 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
     }
 
     WindowQuadList ret;
+    // usually the quads don't overlap, so the grid covering the bounding rectangle
+    // is a good estimate and most of the times a single allocation is needed
+    ret.reserve(qMax(count(), qCeil((right - left) / maxQuadSize) * qCeil((bottom - top) / maxQuadSize)));
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -1082,6 +1098,7 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    ret.reserve(qMax(count(), xSubdivisions * ySubdivisions));
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
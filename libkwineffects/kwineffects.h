@@ -194,7 +194,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 229
+#define KWIN_EFFECT_API_VERSION_MINOR 234
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -375,6 +375,24 @@ public:
         HighlightWindows
     };
 
+    /**
+     * Flags describing the paint hooks an Effect reimplements.
+     * @see paintHooks
+     */
+    enum PaintHook {
+        PrePaintScreenHook   = 1 << 0,
+        PaintScreenHook      = 1 << 1,
+        PostPaintScreenHook  = 1 << 2,
+        PrePaintWindowHook   = 1 << 3,
+        PaintWindowHook      = 1 << 4,
+        PostPaintWindowHook  = 1 << 5,
+        DrawWindowHook       = 1 << 6,
+        PaintEffectFrameHook = 1 << 7,
+        BuildQuadsHook       = 1 << 8,
+        AllPaintHooks        = (1 << 9) - 1
+    };
+    Q_DECLARE_FLAGS(PaintHooks, PaintHook)
+
     /**
      * Constructs new Effect object.
      *
@@ -550,6 +568,32 @@ public:
      */
     virtual bool isActive() const;
 
+    /**
+     * Reimplement this method to declare which of the paint hooks the effect reimplements.
+     * The effect is only called from the chains of the returned hooks, the others are
+     * passed on to the next effect without invoking this effect at all.
+     *
+     * Like isActive() the method is called directly before the paint loop begins.
+     *
+     * The default implementation returns AllPaintHooks.
+     * @since 5.18
+     */
+    virtual PaintHooks paintHooks() const;
+
+    /**
+     * Reimplement this method if the effect paints something itself in paintWindow() or
+     * drawWindow() only for some windows. Returning @c false tells that the effect doesn't
+     * paint anything for the window @p w in the current frame, it may still change the
+     * WindowPaintData though. The compositor can e.g. batch painting such windows.
+     *
+     * The method is called after prePaintWindow() for @p w, if the effect takes part
+     * in the paintWindow or drawWindow chain.
+     *
+     * The default implementation returns @c true.
+     * @since 5.18
+     */
+    virtual bool paintsWindow(const EffectWindow *w) const;
+
     /**
      * Reimplement this method to provide online debugging.
      * This could be as trivial as printing specific detail information about the effect state
@@ -846,6 +890,12 @@ public:
     // for use by effects
     virtual void prePaintScreen(ScreenPrePaintData& data, int time) = 0;
     virtual void paintScreen(int mask, const QRegion &region, ScreenPaintData& data) = 0;
+    /**
+     * Whether active effects follow the calling effect in the paintScreen chain. Their painting
+     * ends up on top of what the calling effect gets back from paintScreen.
+     * Only meaningful while an effect's paintScreen is running.
+     */
+    virtual bool hasFollowingPaintScreenEffects() const = 0;
     virtual void postPaintScreen() = 0;
     virtual void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) = 0;
     virtual void paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data) = 0;
@@ -2584,8 +2634,22 @@ private:
     int quadID;
 };
 
+} // namespace
+
+Q_DECLARE_TYPEINFO(KWin::WindowVertex, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(KWin::WindowQuad, Q_MOVABLE_TYPE);
+
+namespace KWin
+{
+
+/**
+ * @short List of WindowQuads
+ *
+ * The quads are stored contiguously, effects creating thousands of quads
+ * per frame don't cause an allocation per quad.
+ */
 class KWINEFFECTS_EXPORT WindowQuadList
-    : public QList< WindowQuad >
+    : public QVector< WindowQuad >
 {
 public:
     WindowQuadList splitAtX(double x) const;
@@ -2608,6 +2672,11 @@ public:
      * Region that will be painted, in screen coordinates.
      */
     QRegion paint;
+    /**
+     * Region of the window which changed since it was painted the last time, in screen
+     * coordinates. In contrast to @ref paint it does not include changes of other windows.
+     */
+    QRegion damage;
     /**
      * The clip region will be subtracted from paint region of following windows.
      * I.e. window will definitely cover it's clip region
@@ -4008,6 +4077,7 @@ void Effect::initConfig()
 }
 
 } // namespace
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::Effect::PaintHooks)
 Q_DECLARE_METATYPE(KWin::EffectWindow*)
 Q_DECLARE_METATYPE(QList<KWin::EffectWindow*>)
 Q_DECLARE_METATYPE(KWin::TimeLine)
@@ -34,6 +34,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector3D>
 #include <QVector4D>
 #include <QMatrix4x4>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstring>
 
 namespace KWin
 {
@@ -48,6 +52,10 @@ bool GLTexturePrivate::s_supportsUnpack = false;
 bool GLTexturePrivate::s_supportsTextureStorage = false;
 bool GLTexturePrivate::s_supportsTextureSwizzle = false;
 bool GLTexturePrivate::s_supportsTextureFormatRG = false;
+bool GLTexturePrivate::s_supportsPixelBufferObjects = false;
+GLuint GLTexturePrivate::s_pixelUnpackBuffers[3] = { 0, 0, 0 };
+int GLTexturePrivate::s_pixelUnpackBufferIndex = 0;
+GLTextureUploadStatistics GLTexturePrivate::s_uploadStatistics;
 uint GLTexturePrivate::s_textureObjectCounter = 0;
 uint GLTexturePrivate::s_fbo = 0;
 
@@ -312,6 +320,8 @@ void GLTexturePrivate::initStatic()
         s_supportsTextureFormatRG = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_texture_rg"));
         s_supportsARGB32 = true;
         s_supportsUnpack = true;
+        s_supportsPixelBufferObjects = (hasGLVersion(2, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object"))) &&
+            (hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")));
     } else {
         s_supportsFramebufferObjects = true;
         s_supportsTextureStorage = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_texture_storage"));
@@ -324,7 +334,8 @@ void GLTexturePrivate::initStatic()
         s_supportsARGB32 = QSysInfo::ByteOrder == QSysInfo::LittleEndian &&
             hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
 
-        s_supportsUnpack = hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsUnpack = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsPixelBufferObjects = hasGLVersion(3, 0);
     }
 }
 
@@ -332,6 +343,135 @@ void GLTexturePrivate::cleanup()
 {
     s_supportsFramebufferObjects = false;
     s_supportsARGB32 = false;
+    s_supportsPixelBufferObjects = false;
+    if (s_pixelUnpackBuffers[0]) {
+        glDeleteBuffers(3, s_pixelUnpackBuffers);
+        std::fill_n(s_pixelUnpackBuffers, 3, 0);
+    }
+    s_pixelUnpackBufferIndex = 0;
+}
+
+// A view on the pixels of @p rect in @p image, without copying them for 32 bit formats.
+static QImage subImage(const QImage &image, const QRect &rect)
+{
+    if (image.depth() != 32) {
+        return image.copy(rect);
+    }
+    return QImage(image.constScanLine(rect.y()) + rect.x() * 4, rect.width(), rect.height(),
+                  image.bytesPerLine(), image.format());
+}
+
+void GLTexturePrivate::upload(const QImage &image, const QRegion &region, const QPoint &offset)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // The format parameter of glTexSubImage2D() has to match the format the texture was
+    // created with on GLES, see the constructors.
+    GLenum format = GL_BGRA;
+    GLenum type = GL_UNSIGNED_INT_8_8_8_8_REV;
+    QImage::Format uploadFormat = QImage::Format_ARGB32_Premultiplied;
+    if (GLPlatform::instance()->isGLES()) {
+        type = GL_UNSIGNED_BYTE;
+        if (s_supportsARGB32) {
+            format = GL_BGRA_EXT;
+        } else {
+            format = GL_RGBA;
+            uploadFormat = QImage::Format_RGBA8888_Premultiplied;
+        }
+    }
+    // The undefined alpha channel of RGB32 images doesn't matter if the texture has none.
+    const bool needsConversion = image.format() != uploadFormat &&
+        !(image.format() == QImage::Format_RGB32 && m_internalFormat == GL_RGB8);
+
+    const QRect bounds = image.rect();
+    QVector<QRect> rects;
+    rects.reserve(region.rectCount());
+    GLsizeiptr bytes = 0;
+    for (const QRect &r : region) {
+        const QRect rect = r & bounds;
+        if (rect.isEmpty()) {
+            continue;
+        }
+        rects << rect;
+        bytes += GLsizeiptr(rect.width()) * rect.height() * 4;
+    }
+    if (rects.isEmpty()) {
+        return;
+    }
+
+    s_uploadStatistics.uploads++;
+    s_uploadStatistics.rects += rects.count();
+    s_uploadStatistics.bytes += bytes;
+    if (needsConversion) {
+        s_uploadStatistics.convertedBytes += bytes;
+    }
+
+    // Stream the pixels through a ring of pixel unpack buffers, that way the driver can
+    // copy them to the texture asynchronously instead of stalling until they are consumed.
+    uchar *mapped = nullptr;
+    if (s_supportsPixelBufferObjects) {
+        if (!s_pixelUnpackBuffers[0]) {
+            glGenBuffers(3, s_pixelUnpackBuffers);
+        }
+        s_pixelUnpackBufferIndex = (s_pixelUnpackBufferIndex + 1) % 3;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pixelUnpackBuffers[s_pixelUnpackBufferIndex]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        mapped = static_cast<uchar *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (!mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+
+    if (mapped) {
+        // Pack the rectangles tightly, so that no row length is needed.
+        GLsizeiptr position = 0;
+        for (const QRect &rect : qAsConst(rects)) {
+            const int rowSize = rect.width() * 4;
+            if (needsConversion) {
+                const QImage im = subImage(image, rect).convertToFormat(uploadFormat);
+                for (int y = 0; y < rect.height(); ++y) {
+                    std::memcpy(mapped + position + y * rowSize, im.constScanLine(y), rowSize);
+                }
+            } else {
+                const uchar *bits = image.constScanLine(rect.y()) + rect.x() * 4;
+                for (int y = 0; y < rect.height(); ++y) {
+                    std::memcpy(mapped + position + y * rowSize, bits + y * image.bytesPerLine(), rowSize);
+                }
+            }
+            position += GLsizeiptr(rowSize) * rect.height();
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        position = 0;
+        for (const QRect &rect : qAsConst(rects)) {
+            glTexSubImage2D(m_target, 0, rect.x() + offset.x(), rect.y() + offset.y(), rect.width(), rect.height(),
+                            format, type, reinterpret_cast<const void *>(position));
+            position += GLsizeiptr(rect.width()) * rect.height() * 4;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        s_uploadStatistics.streamedBytes += bytes;
+    } else {
+        for (const QRect &rect : qAsConst(rects)) {
+            QImage im = subImage(image, rect);
+            if (needsConversion) {
+                im = im.convertToFormat(uploadFormat);
+            } else if (!s_supportsUnpack && im.bytesPerLine() != rect.width() * 4) {
+                im = im.copy();
+            }
+            if (s_supportsUnpack) {
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, im.bytesPerLine() / 4);
+            }
+            glTexSubImage2D(m_target, 0, rect.x() + offset.x(), rect.y() + offset.y(), rect.width(), rect.height(),
+                            format, type, im.constBits());
+        }
+        if (s_supportsUnpack) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+    }
+
+    s_uploadStatistics.time += timer.nsecsElapsed();
 }
 
 bool GLTexture::isNull() const
@@ -354,51 +494,24 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     Q_D(GLTexture);
     Q_ASSERT(!d->m_foreign);
 
-    bool useUnpack = !src.isNull() && d->s_supportsUnpack && d->s_supportsARGB32 && image.format() == QImage::Format_ARGB32_Premultiplied;
+    const QRect rect = src.isNull() ? image.rect() : src;
 
-    int width = image.width();
-    int height = image.height();
-    QImage tmpImage;
+    bind();
+    d->upload(image, rect, offset - rect.topLeft());
+    unbind();
+}
 
-    if (!src.isNull()) {
-        if (useUnpack) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width());
-            glPixelStorei(GL_UNPACK_SKIP_PIXELS, src.x());
-            glPixelStorei(GL_UNPACK_SKIP_ROWS, src.y());
-        } else {
-            tmpImage = image.copy(src);
-        }
-        width = src.width();
-        height = src.height();
-    }
+void GLTexture::update(const QImage &image, const QRegion &region)
+{
+    if (image.isNull() || isNull())
+        return;
 
-    const QImage &img = tmpImage.isNull() ? image : tmpImage;
+    Q_D(GLTexture);
+    Q_ASSERT(!d->m_foreign);
 
     bind();
-
-    if (!GLPlatform::instance()->isGLES()) {
-        const QImage im = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                        GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, im.bits());
-    } else {
-        if (d->s_supportsARGB32) {
-            const QImage im = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                            GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
-        } else {
-            const QImage im = img.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                            GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
-        }
-    }
-
+    d->upload(image, region, QPoint(0, 0));
     unbind();
-
-    if (useUnpack) {
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-    }
 }
 
 void GLTexture::discard()
@@ -680,4 +793,14 @@ bool GLTexture::supportsFormatRG()
     return GLTexturePrivate::s_supportsTextureFormatRG;
 }
 
+GLTextureUploadStatistics GLTexture::uploadStatistics()
+{
+    return GLTexturePrivate::s_uploadStatistics;
+}
+
+void GLTexture::resetUploadStatistics()
+{
+    GLTexturePrivate::s_uploadStatistics = GLTextureUploadStatistics();
+}
+
 } // namespace KWin
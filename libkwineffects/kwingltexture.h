@@ -49,6 +49,28 @@ enum TextureCoordinateType {
     UnnormalizedCoordinates
 };
 
+/**
+ * Counters of the pixel data uploaded with GLTexture::update().
+ */
+struct GLTextureUploadStatistics
+{
+    quint64 uploads = 0;
+    quint64 rects = 0;
+    quint64 bytes = 0;
+    /**
+     * Bytes which had to be converted to the upload format of the texture.
+     */
+    quint64 convertedBytes = 0;
+    /**
+     * Bytes streamed through pixel unpack buffers.
+     */
+    quint64 streamedBytes = 0;
+    /**
+     * Time in nanoseconds spent in submitting the uploads.
+     */
+    qint64 time = 0;
+};
+
 class KWINGLUTILS_EXPORT GLTexture
 {
 public:
@@ -103,6 +125,13 @@ public:
     QMatrix4x4 matrix(TextureCoordinateType type) const;
 
     void update(const QImage& image, const QPoint &offset = QPoint(0, 0), const QRect &src = QRect());
+    /**
+     * Uploads the parts of @p image covered by @p region to the same position in the texture.
+     *
+     * Images which are already in the upload format of the texture are uploaded without
+     * an intermediate copy, otherwise only the rectangles of @p region get converted.
+     */
+    void update(const QImage &image, const QRegion &region);
     virtual void discard();
     void bind();
     void unbind();
@@ -144,6 +173,12 @@ public:
      */
     static bool supportsFormatRG();
 
+    /**
+     * Returns the counters of all texture uploads since the last reset.
+     */
+    static GLTextureUploadStatistics uploadStatistics();
+    static void resetUploadStatistics();
+
 protected:
     QExplicitlySharedDataPointer<GLTexturePrivate> d_ptr;
     GLTexture(GLTexturePrivate& dd);
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "kwinconfig.h" // KWIN_HAVE_OPENGL
 #include "kwinglutils.h"
+#include "kwingltexture.h"
 #include <kwinglutils_export.h>
 
 #include <QSize>
@@ -48,6 +49,10 @@ public:
     virtual void onDamage();
 
     void updateMatrix();
+    /**
+     * Uploads the rectangles of @p region in @p image, moved by @p offset, to the bound texture.
+     */
+    void upload(const QImage &image, const QRegion &region, const QPoint &offset);
 
     GLuint m_texture;
     GLenum m_target;
@@ -79,6 +84,10 @@ public:
     static bool s_supportsTextureStorage;
     static bool s_supportsTextureSwizzle;
     static bool s_supportsTextureFormatRG;
+    static bool s_supportsPixelBufferObjects;
+    static GLuint s_pixelUnpackBuffers[3];
+    static int s_pixelUnpackBufferIndex;
+    static GLTextureUploadStatistics s_uploadStatistics;
     static GLuint s_fbo;
     static uint s_textureObjectCounter;
 private:
@@ -31,7 +31,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPixmap>
 #include <QImage>
 #include <QHash>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QVector2D>
 #include <QVector3D>
 #include <QVector4D>
@@ -307,6 +314,31 @@ bool GLShader::load(const QByteArray &vertexSource, const QByteArray &fragmentSo
     return link();
 }
 
+bool GLShader::loadBinary(GLenum binaryFormat, const QByteArray &binary)
+{
+    mValid = false;
+    glProgramBinary(mProgram, binaryFormat, binary.constData(), binary.size());
+
+    // The driver rejects binaries of another driver version, the program has to be compiled then
+    int status;
+    glGetProgramiv(mProgram, GL_LINK_STATUS, &status);
+    mValid = status != 0;
+    return mValid;
+}
+
+QByteArray GLShader::programBinary(GLenum *binaryFormat) const
+{
+    int length = 0;
+    glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return QByteArray();
+    }
+    QByteArray binary(length, Qt::Uninitialized);
+    glGetProgramBinary(mProgram, length, &length, binaryFormat, binary.data());
+    binary.resize(length);
+    return binary;
+}
+
 void GLShader::bindAttributeLocation(const char *name, int index)
 {
     glBindAttribLocation(mProgram, index, name);
@@ -555,10 +587,44 @@ void ShaderManager::cleanup()
     s_shaderManager = nullptr;
 }
 
+static const quint32 s_programCacheMagic = 0x4b575343; // "KWSC"
+static const quint32 s_programCacheVersion = 1;
+
+static bool supportsProgramBinaries()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        if (!hasGLVersion(3, 0)) {
+            return false;
+        }
+    } else if (!hasGLVersion(4, 1) && !hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"))) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
 ShaderManager::ShaderManager()
 {
     m_debug = qstrcmp(qgetenv("KWIN_GL_DEBUG"), "1") == 0;
 
+    // Linked programs are cached on disk, so that shaders don't have to be compiled again
+    // each time compositing is started or an effect is used for the first time.
+    if (qstrcmp(qgetenv("KWIN_GL_SHADER_CACHE"), "0") != 0 && supportsProgramBinaries()) {
+        // The binaries are only valid for the driver which created them, each driver gets its own directory.
+        GLPlatform *gl = GLPlatform::instance();
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(gl->glVendorString());
+        hash.addData(gl->glRendererString());
+        hash.addData(gl->glVersionString());
+        hash.addData(gl->glShadingLanguageVersionString());
+        const QString driver = QString::fromLatin1(hash.result().toHex());
+
+        const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/ukui-kwin/shaders/");
+        pruneProgramCache(cacheDir, driver);
+        m_cachePath = cacheDir + driver + QLatin1Char('/');
+    }
+
     const qint64 coreVersionNumber = GLPlatform::instance()->isGLES() ? kVersionNumber(3, 0) : kVersionNumber(1, 40);
     if (GLPlatform::instance()->glslVersion() >= coreVersionNumber) {
         m_resourcePath = QStringLiteral(":/effect-shaders-1.40/");
@@ -931,7 +997,18 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     qCDebug(LIBKWINGLUTILS) << "**************";
 #endif
 
+    const QByteArray key = cacheKey(traits, vertex, fragment, QByteArrayLiteral("position texcoord"));
+    if (GLShader *shader = loadCachedShader(key)) {
+        return shader;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    if (isProgramCacheEnabled()) {
+        glProgramParameteri(shader->mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
@@ -939,6 +1016,7 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     shader->bindFragDataLocation("fragColor", 0);
 
     shader->link();
+    storeCachedShader(key, shader, timer.nsecsElapsed());
     return shader;
 }
 
@@ -1045,14 +1123,137 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 
 GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
+    const QByteArray key = cacheKey(ShaderTraits(), vertexSource, fragmentSource, QByteArrayLiteral("vertex texCoord"));
+    if (GLShader *shader = loadCachedShader(key)) {
+        return shader;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    if (isProgramCacheEnabled()) {
+        glProgramParameteri(shader->mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     shader->load(vertexSource, fragmentSource);
     bindAttributeLocations(shader);
     bindFragDataLocations(shader);
     shader->link();
+    storeCachedShader(key, shader, timer.nsecsElapsed());
     return shader;
 }
 
+bool ShaderManager::isProgramCacheEnabled() const
+{
+    return !m_cachePath.isEmpty();
+}
+
+ShaderManager::CacheStatistics ShaderManager::cacheStatistics() const
+{
+    return m_cacheStatistics;
+}
+
+QByteArray ShaderManager::cacheKey(ShaderTraits traits, const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const
+{
+    if (!isProgramCacheEnabled()) {
+        return QByteArray();
+    }
+    // The driver is part of the cache path, see the constructor
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(int(traits)));
+    hash.addData(m_debug ? "debug" : "release");
+    hash.addData(bindings);
+    hash.addData(QByteArray::number(vertexSource.size()));
+    hash.addData(vertexSource);
+    hash.addData(fragmentSource);
+    return hash.result().toHex();
+}
+
+void ShaderManager::pruneProgramCache(const QString &cacheDir, const QString &driver)
+{
+    // Binaries of other drivers would never be loaded again after a driver update
+    // or a change of the graphics card, so they are removed instead of piling up.
+    QDir dir(cacheDir);
+    if (!dir.exists()) {
+        return;
+    }
+    const QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : entries) {
+        if (entry.fileName() == driver && entry.isDir()) {
+            continue;
+        }
+        qCDebug(LIBKWINGLUTILS) << "Removing stale shader cache" << entry.filePath();
+        if (entry.isDir()) {
+            QDir(entry.filePath()).removeRecursively();
+        } else {
+            QFile::remove(entry.filePath());
+        }
+    }
+}
+
+GLShader *ShaderManager::loadCachedShader(const QByteArray &key)
+{
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    QFile file(m_cachePath + QString::fromLatin1(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_cacheStatistics.misses++;
+        return nullptr;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 binaryFormat = 0;
+    qint64 compileTime = 0;
+    QByteArray binary;
+    stream >> magic >> version >> binaryFormat >> compileTime >> binary;
+    file.close();
+
+    if (stream.status() == QDataStream::Ok && magic == s_programCacheMagic &&
+            version == s_programCacheVersion && !binary.isEmpty()) {
+        GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+        if (shader->loadBinary(binaryFormat, binary)) {
+            m_cacheStatistics.hits++;
+            m_cacheStatistics.savedTime += qMax<qint64>(0, compileTime - timer.nsecsElapsed());
+            return shader;
+        }
+        delete shader;
+    }
+    qCDebug(LIBKWINGLUTILS) << "Discarding invalid cached shader" << file.fileName();
+    file.remove();
+    m_cacheStatistics.misses++;
+    return nullptr;
+}
+
+void ShaderManager::storeCachedShader(const QByteArray &key, GLShader *shader, qint64 compileTime)
+{
+    m_cacheStatistics.compileTime += compileTime;
+    if (key.isEmpty() || !shader->isValid()) {
+        return;
+    }
+    GLenum binaryFormat = 0;
+    const QByteArray binary = shader->programBinary(&binaryFormat);
+    if (binary.isEmpty()) {
+        return;
+    }
+    if (!QDir().mkpath(m_cachePath)) {
+        return;
+    }
+    QSaveFile file(m_cachePath + QString::fromLatin1(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write shader cache" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_programCacheMagic << s_programCacheVersion << quint32(binaryFormat) << compileTime << binary;
+    file.commit();
+}
+
 /***  GLRenderTarget  ***/
 bool GLRenderTarget::sSupported = false;
 bool GLRenderTarget::s_blitSupported = false;
@@ -1304,6 +1505,32 @@ void GLRenderTarget::blitFromFramebuffer(const QRect &source, const QRect &desti
     GLRenderTarget::popRenderTarget();
 }
 
+void GLRenderTarget::blitFromRenderTarget(GLRenderTarget *source, const QRect &sourceRect, const QRect &destination, GLenum filter)
+{
+    if (!GLRenderTarget::blitSupported()) {
+        return;
+    }
+
+    if (!mValid) {
+        initFBO();
+    }
+    if (!source->mValid) {
+        source->initFBO();
+    }
+
+    GLRenderTarget::pushRenderTarget(this);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source->mFramebuffer);
+    const QRect &s = sourceRect;
+    const int sourceHeight = source->mTexture.height();
+    const QRect d = destination.isNull() ? QRect(0, 0, mTexture.width(), mTexture.height()) : destination;
+
+    glBlitFramebuffer(s.x(), sourceHeight - s.y() - s.height(), s.x() + s.width(), sourceHeight - s.y(),
+                      d.x(), mTexture.height() - d.y() - d.height(), d.x() + d.width(), mTexture.height() - d.y(),
+                      GL_COLOR_BUFFER_BIT, filter);
+    GLRenderTarget::popRenderTarget();
+}
+
 void GLRenderTarget::attachTexture(const GLTexture& target)
 {
     if (!mValid) {
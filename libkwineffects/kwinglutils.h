@@ -162,6 +162,11 @@ protected:
     bool load(const QByteArray &vertexSource, const QByteArray &fragmentSource);
     const QByteArray prepareSource(GLenum shaderType, const QByteArray &sourceCode) const;
     bool compile(GLuint program, GLenum shaderType, const QByteArray &sourceCode) const;
+    /**
+     * Loads the linked program from a binary retrieved with programBinary().
+     */
+    bool loadBinary(GLenum binaryFormat, const QByteArray &binary);
+    QByteArray programBinary(GLenum *binaryFormat) const;
     void bind();
     void unbind();
     void resolveLocations();
@@ -309,6 +314,27 @@ public:
      */
     bool selfTest();
 
+    /**
+     * Statistics of the on-disk program binary cache.
+     */
+    struct CacheStatistics {
+        int hits = 0;
+        int misses = 0;
+        /**
+         * Time in nanoseconds spent in compiling and linking shaders which were not cached.
+         */
+        qint64 compileTime = 0;
+        /**
+         * Time in nanoseconds the cache hits saved compared to compiling the shaders.
+         */
+        qint64 savedTime = 0;
+    };
+    /**
+     * @returns @c true if linked programs are cached on disk
+     */
+    bool isProgramCacheEnabled() const;
+    CacheStatistics cacheStatistics() const;
+
     /**
      * @return a pointer to the ShaderManager instance
      */
@@ -330,10 +356,17 @@ private:
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     GLShader *generateShader(ShaderTraits traits);
 
+    QByteArray cacheKey(ShaderTraits traits, const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const;
+    void pruneProgramCache(const QString &cacheDir, const QString &driver);
+    GLShader *loadCachedShader(const QByteArray &key);
+    void storeCachedShader(const QByteArray &key, GLShader *shader, qint64 compileTime);
+
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     bool m_debug;
     QString m_resourcePath;
+    QString m_cachePath;
+    CacheStatistics m_cacheStatistics;
     static ShaderManager *s_shaderManager;
 };
 
@@ -502,6 +535,19 @@ public:
      */
     void blitFromFramebuffer(const QRect &source = QRect(), const QRect &destination = QRect(), GLenum filter = GL_LINEAR);
 
+    /**
+     * Blits the content of @p sourceRect in the texture attached to @p source into the texture
+     * attached to this FBO.
+     *
+     * Both rectangles are in texture coordinates with the origin in the top left corner.
+     * @param source The render target to copy from
+     * @param sourceRect Geometry in the texture attached to @p source
+     * @param destination Geometry in the attached texture, if not specified complete texture is used as destination
+     * @param filter The filter to use if blitted content needs to be scaled.
+     * @see blitSupported
+     */
+    void blitFromRenderTarget(GLRenderTarget *source, const QRect &sourceRect, const QRect &destination = QRect(), GLenum filter = GL_NEAREST);
+
     /**
      * Sets the virtual screen size to @p s.
      * @since 5.2
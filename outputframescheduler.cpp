@@ -0,0 +1,244 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "outputframescheduler.h"
+#include "options.h"
+
+#include <QTimerEvent>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static inline qint64 nanoToMilli(qint64 nano) { return nano / (1000*1000); }
+
+// Number of recent frames the render time prediction is based on.
+static const int s_renderTimeSamples = 32;
+// Added on top of the predicted render time to absorb scheduling jitter of the event loop.
+static const qint64 s_renderTimeSafetyMargin = 1000 * 1000;
+
+OutputFrameScheduler::OutputFrameScheduler(AbstractOutput *output, const QRect &geometry, int refreshRate, QObject *parent)
+    : QObject(parent)
+    , m_output(output)
+    , m_geometry(geometry)
+    // DO NOT allow "0", would cause div-by-zero when deriving the vblank interval.
+    , m_refreshRate(refreshRate > 0 ? refreshRate : 60000)
+{
+    resetRenderTimePrediction();
+}
+
+OutputFrameScheduler::~OutputFrameScheduler() = default;
+
+void OutputFrameScheduler::setGeometry(const QRect &geometry)
+{
+    m_geometry = geometry;
+    m_repaints &= geometry;
+}
+
+void OutputFrameScheduler::setRefreshRate(int refreshRate)
+{
+    m_refreshRate = refreshRate > 0 ? refreshRate : 60000;
+}
+
+void OutputFrameScheduler::configure(bool syncsToVBlank, bool blocksForRetrace, qint64 maxFpsInterval)
+{
+    m_blocksForRetrace = blocksForRetrace;
+    m_fpsInterval = maxFpsInterval;
+    if (syncsToVBlank) {
+        // If we do vsync, set the fps to the next multiple of the vblank rate.
+        m_vBlankInterval = qint64(1000) * 1000 * 1000 * 1000 / m_refreshRate;
+        m_fpsInterval = qMax((m_fpsInterval / m_vBlankInterval) * m_vBlankInterval, m_vBlankInterval);
+    } else {
+        // No vsync - DO NOT set "0", would cause div-by-zero segfaults.
+        m_vBlankInterval = 1000 * 1000;
+    }
+    m_timeSinceLastVBlank = 0;
+    resetRenderTimePrediction();
+}
+
+void OutputFrameScheduler::resetRenderTimePrediction()
+{
+    m_renderTimes.clear();
+    m_renderTimes.reserve(s_renderTimeSamples);
+    m_renderTimesIndex = 0;
+    m_lastRenderTime = 0;
+    m_predictedRenderTime = options->vBlankTime();
+}
+
+qint64 OutputFrameScheduler::renderLatency() const
+{
+    return m_predictedRenderTime + s_renderTimeSafetyMargin;
+}
+
+bool OutputFrameScheduler::addRepaint(const QRegion &region)
+{
+    const QRegion repaint = region & m_geometry;
+    if (repaint.isEmpty()) {
+        return false;
+    }
+    m_repaints += repaint;
+    return true;
+}
+
+void OutputFrameScheduler::addRepaintFull()
+{
+    m_repaints = m_geometry;
+}
+
+QRegion OutputFrameScheduler::takeRepaints()
+{
+    const QRegion repaints = m_repaints;
+    m_repaints = QRegion();
+    return repaints;
+}
+
+void OutputFrameScheduler::stop()
+{
+    m_frameTimer.stop();
+}
+
+void OutputFrameScheduler::reset()
+{
+    m_frameTimer.stop();
+    m_repaints = QRegion();
+    m_bufferSwapPending = false;
+    m_composeAtSwapCompletion = false;
+    m_timeSinceLastVBlank = 0;
+}
+
+void OutputFrameScheduler::aboutToSwapBuffers()
+{
+    m_bufferSwapPending = true;
+}
+
+void OutputFrameScheduler::composeAtSwapCompletion()
+{
+    m_composeAtSwapCompletion = true;
+    m_frameTimer.stop();
+}
+
+bool OutputFrameScheduler::bufferSwapComplete()
+{
+    if (!m_bufferSwapPending) {
+        return false;
+    }
+    m_bufferSwapPending = false;
+    if (!m_composeAtSwapCompletion) {
+        return false;
+    }
+    m_composeAtSwapCompletion = false;
+
+    // The swap completes with the vblank the frame got presented at. Don't paint right
+    // away, start the next frame as late as possible so that it still meets the next
+    // vblank. That way the frame shows the most recent client content.
+    const qint64 delay = m_fpsInterval - renderLatency();
+    if (nanoToMilli(delay) < 1) {
+        return true;
+    }
+    m_frameTimer.start(nanoToMilli(delay), Qt::PreciseTimer, this);
+    return false;
+}
+
+void OutputFrameScheduler::frameRendered(qint64 renderTime)
+{
+    m_timeSinceLastVBlank = renderTime;
+    m_lastRenderTime = renderTime;
+
+    if (m_renderTimes.count() < s_renderTimeSamples) {
+        m_renderTimes.append(renderTime);
+    } else {
+        m_renderTimes[m_renderTimesIndex] = renderTime;
+    }
+    m_renderTimesIndex = (m_renderTimesIndex + 1) % s_renderTimeSamples;
+
+    // Be pessimistic: the slowest recent frame decides, a single slow frame keeps the
+    // prediction up until it left the window, but a dropped frame costs more than
+    // starting a little bit too early.
+    m_predictedRenderTime = *std::max_element(m_renderTimes.constBegin(), m_renderTimes.constEnd());
+    if (m_vBlankInterval > s_renderTimeSafetyMargin) {
+        m_predictedRenderTime = qMin(m_predictedRenderTime, m_vBlankInterval - s_renderTimeSafetyMargin);
+    }
+}
+
+void OutputFrameScheduler::idle()
+{
+    m_timeSinceLastVBlank = m_fpsInterval - (renderLatency() + 1); // means "start now"
+    m_frameTimer.stop();
+}
+
+void OutputFrameScheduler::timerEvent(QTimerEvent *te)
+{
+    if (te->timerId() == m_frameTimer.timerId()) {
+        m_frameTimer.stop();
+        emit frameRequested();
+    } else {
+        QObject::timerEvent(te);
+    }
+}
+
+void OutputFrameScheduler::scheduleRepaint()
+{
+    if (m_frameTimer.isActive()) {
+        return;
+    }
+    // Don't start the timer if we're waiting for a swap event
+    if (m_bufferSwapPending && m_composeAtSwapCompletion) {
+        return;
+    }
+
+    qint64 waitTime = 1;
+
+    if (m_blocksForRetrace) {
+        // The render latency is required because glXWaitVideoSync will *likely* block a full frame
+        // if one enters a retrace pass which can last a variable amount of time, depending on the
+        // actual screen. It is predicted from the recent paint durations.
+        const qint64 latency = renderLatency();
+        qint64 padding = m_timeSinceLastVBlank;
+        if (padding > m_fpsInterval) {
+            // We're at low repaints or spent more time in painting than the user wanted to wait
+            // for that frame. Align to next vblank:
+            padding = m_vBlankInterval - (padding % m_vBlankInterval);
+        } else {
+            // Align to the next maxFps tick:
+            // "remaining time of the first vsync" + "time for the other vsyncs of the frame"
+            padding = ((m_vBlankInterval - padding % m_vBlankInterval) +
+                       (m_fpsInterval / m_vBlankInterval - 1) * m_vBlankInterval);
+        }
+
+        if (padding < latency) {
+            // We'll likely miss this frame so we add one:
+            waitTime = nanoToMilli(padding + m_vBlankInterval - latency);
+        } else {
+            waitTime = nanoToMilli(padding - latency);
+        }
+    } else if (m_fpsInterval > m_timeSinceLastVBlank) {
+        // w/o blocking vsync we just jump to the next demanded tick
+        waitTime = nanoToMilli(m_fpsInterval - m_timeSinceLastVBlank);
+        if (!waitTime) {
+            // Will ensure we don't block out the eventloop - the system's just not faster ...
+            waitTime = 1;
+        }
+    }
+    // Force 4fps minimum:
+    m_frameTimer.start(qBound<qint64>(0, waitTime, 250), this);
+}
+
+}
@@ -0,0 +1,189 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QBasicTimer>
+#include <QObject>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace KWin
+{
+class AbstractOutput;
+
+/**
+ * The OutputFrameScheduler drives the repaints of a single output.
+ *
+ * Each scheduler owns the repaint region, the vblank clock and the frame timer
+ * of its output, so outputs with different refresh rates are painted at their
+ * own pace and an output without pending repaints does not get painted at all.
+ *
+ * If the Scene cannot render outputs individually the Compositor uses a single
+ * scheduler without an output which covers the complete screen area.
+ *
+ * Instead of a static safety margin the scheduler predicts the time the next frame
+ * needs to render from the recent paint durations, and starts painting as late as
+ * possible while still meeting the next vblank.
+ */
+class UKUI_KWIN_EXPORT OutputFrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    OutputFrameScheduler(AbstractOutput *output, const QRect &geometry, int refreshRate, QObject *parent = nullptr);
+    ~OutputFrameScheduler() override;
+
+    /**
+     * The output driven by this scheduler, @c null if the scheduler drives all outputs.
+     */
+    AbstractOutput *output() const {
+        return m_output;
+    }
+    /**
+     * The area of the output in compositor coordinates.
+     */
+    QRect geometry() const {
+        return m_geometry;
+    }
+    /**
+     * Moves the scheduler to the new output geometry, the repaint region is clipped to it.
+     */
+    void setGeometry(const QRect &geometry);
+    /**
+     * The refresh rate of the output in mHz.
+     */
+    int refreshRate() const {
+        return m_refreshRate;
+    }
+    /**
+     * Sets the refresh rate of the output in mHz, configure() has to be called afterwards.
+     */
+    void setRefreshRate(int refreshRate);
+    /**
+     * Derives the vblank and frame intervals from the refresh rate.
+     */
+    void configure(bool syncsToVBlank, bool blocksForRetrace, qint64 maxFpsInterval);
+
+    /**
+     * Adds the part of @p region intersecting this output to the repaint region.
+     * @returns @c true if the repaint region changed
+     */
+    bool addRepaint(const QRegion &region);
+    void addRepaintFull();
+    QRegion repaints() const {
+        return m_repaints;
+    }
+    bool hasRepaints() const {
+        return !m_repaints.isEmpty();
+    }
+    /**
+     * Returns the repaint region and clears it, so that repaints added while painting
+     * are carried over to the next frame.
+     */
+    QRegion takeRepaints();
+
+    /**
+     * Starts the frame timer if it is not yet running.
+     */
+    void scheduleRepaint();
+    /**
+     * Stops the frame timer, frames deferred until a swap completion are kept.
+     */
+    void stop();
+    /**
+     * Stops the frame timer and drops all pending repaints and swap state.
+     */
+    void reset();
+
+    void aboutToSwapBuffers();
+    bool isSwapPending() const {
+        return m_bufferSwapPending;
+    }
+    /**
+     * Defers the next frame until the pending buffer swap has completed.
+     */
+    void composeAtSwapCompletion();
+    /**
+     * Notifies the scheduler that the buffer swap of this output has completed.
+     * A deferred frame is scheduled to start as late as the predicted render time allows.
+     * @returns @c true if a frame was deferred and has to be composited right now
+     */
+    bool bufferSwapComplete();
+
+    /**
+     * Records the time in nanoseconds the Scene needed to paint the last frame.
+     */
+    void frameRendered(qint64 renderTime);
+    /**
+     * The time in nanoseconds the Scene needed to paint the last frame.
+     */
+    qint64 lastRenderTime() const {
+        return m_lastRenderTime;
+    }
+    /**
+     * The predicted time in nanoseconds the Scene needs to paint the next frame.
+     * Until enough frames have been painted this is the configured vBlankTime.
+     */
+    qint64 predictedRenderTime() const {
+        return m_predictedRenderTime;
+    }
+    /**
+     * Nothing was painted, the next frame should start as soon as possible.
+     */
+    void idle();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the frame timer expired and the output should be painted.
+     */
+    void frameRequested();
+
+protected:
+    void timerEvent(QTimerEvent *te) override;
+
+private:
+    qint64 renderLatency() const;
+    void resetRenderTimePrediction();
+
+    AbstractOutput *m_output;
+    QRect m_geometry;
+    int m_refreshRate;
+
+    QRegion m_repaints;
+    QBasicTimer m_frameTimer;
+
+    qint64 m_vBlankInterval = 0;
+    qint64 m_fpsInterval = 0;
+    qint64 m_timeSinceLastVBlank = 0;
+    bool m_blocksForRetrace = false;
+
+    QVector<qint64> m_renderTimes;
+    int m_renderTimesIndex = 0;
+    qint64 m_lastRenderTime = 0;
+    qint64 m_predictedRenderTime = 0;
+
+    bool m_bufferSwapPending = false;
+    bool m_composeAtSwapCompletion = false;
+};
+
+}
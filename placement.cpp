@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "options.h"
 #include "rules.h"
 #include "screens.h"
+#include "windowgeometryindex.h"
 #endif
 
 #include <QRect>
@@ -241,6 +242,8 @@ void Placement::placeSmart(AbstractClient* c, const QRect& area, Policy /*next*/
 
     bool first_pass = true; //CT lame flag. Don't like it. What else would do?
 
+    const WindowGeometryIndex *index = workspace()->geometryIndex();
+
     //loop over possible positions
     do {
         //test if enough room in x and y directions
@@ -253,8 +256,8 @@ void Placement::placeSmart(AbstractClient* c, const QRect& area, Policy /*next*/
 
             cxl = x; cxr = x + cw;
             cyt = y; cyb = y + ch;
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
+            const auto overlapping = index->intersecting(QRect(QPoint(cxl, cyt), QPoint(cxr, cyb)));
+            for (AbstractClient *client : overlapping) {
                 if (isIrrelevant(client, c, desktop)) {
                     continue;
                 }
@@ -300,9 +303,11 @@ void Placement::placeSmart(AbstractClient* c, const QRect& area, Policy /*next*/
             possible = area.right();
             if (possible - cw > x) possible -= cw;
 
-            // compare to the position of each client on the same desk
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
+            // compare to the position of each client on the same desk, only the clients
+            // in the rows of the tested position and to the right of it matter
+            const QRect bounds = index->boundingRect();
+            const auto inRows = index->intersecting(QRect(QPoint(x, y), QPoint(qMax(x, bounds.right()), y + ch)));
+            for (AbstractClient *client : inRows) {
                 if (isIrrelevant(client, c, desktop)) {
                     continue;
                 }
@@ -330,9 +335,10 @@ void Placement::placeSmart(AbstractClient* c, const QRect& area, Policy /*next*/
 
             if (possible - ch > y) possible -= ch;
 
-            //test the position of each window on the desk
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
+            //test the position of each window on the desk, only the ones reaching below y matter
+            const QRect bounds = index->boundingRect();
+            const auto below = index->intersecting(QRect(QPoint(bounds.left(), y), QPoint(bounds.right(), qMax(y, bounds.bottom()))));
+            for (AbstractClient *client : below) {
                 if (isIrrelevant(client, c, desktop)) {
                     continue;
                 }
@@ -865,8 +871,10 @@ int Workspace::packPositionLeft(const AbstractClient *client, int oldX, bool lef
         return oldX;
     }
     const int desktop = client->desktop() == 0 || client->isOnAllDesktops() ? VirtualDesktopManager::self()->current() : client->desktop();
-    for (auto it = m_allClients.constBegin(), end = m_allClients.constEnd(); it != end; ++it) {
-        if (isIrrelevant(*it, client, desktop)) {
+    // only the clients between the old and the new position can be in the way
+    const auto candidates = m_geometryIndex->intersecting(QRect(QPoint(newX - 1, client->frameGeometry().top()), QPoint(oldX + 1, client->frameGeometry().bottom())));
+    for (auto it = candidates.constBegin(), end = candidates.constEnd(); it != end; ++it) {
+        if ((*it)->isInternal() || isIrrelevant(*it, client, desktop)) {
             continue;
         }
         const int x = leftEdge ? (*it)->frameGeometry().right() + 1 : (*it)->frameGeometry().left() - 1;
@@ -898,8 +906,10 @@ int Workspace::packPositionRight(const AbstractClient *client, int oldX, bool ri
         return oldX;
     }
     const int desktop = client->desktop() == 0 || client->isOnAllDesktops() ? VirtualDesktopManager::self()->current() : client->desktop();
-    for (auto it = m_allClients.constBegin(), end = m_allClients.constEnd(); it != end; ++it) {
-        if (isIrrelevant(*it, client, desktop)) {
+    // only the clients between the old and the new position can be in the way
+    const auto candidates = m_geometryIndex->intersecting(QRect(QPoint(oldX - 1, client->frameGeometry().top()), QPoint(newX + 1, client->frameGeometry().bottom())));
+    for (auto it = candidates.constBegin(), end = candidates.constEnd(); it != end; ++it) {
+        if ((*it)->isInternal() || isIrrelevant(*it, client, desktop)) {
             continue;
         }
         const int x = rightEdge ? (*it)->frameGeometry().left() - 1 : (*it)->frameGeometry().right() + 1;
@@ -931,8 +941,10 @@ int Workspace::packPositionUp(const AbstractClient *client, int oldY, bool topEd
         return oldY;
     }
     const int desktop = client->desktop() == 0 || client->isOnAllDesktops() ? VirtualDesktopManager::self()->current() : client->desktop();
-    for (auto it = m_allClients.constBegin(), end = m_allClients.constEnd(); it != end; ++it) {
-        if (isIrrelevant(*it, client, desktop)) {
+    // only the clients between the old and the new position can be in the way
+    const auto candidates = m_geometryIndex->intersecting(QRect(QPoint(client->frameGeometry().left(), newY - 1), QPoint(client->frameGeometry().right(), oldY + 1)));
+    for (auto it = candidates.constBegin(), end = candidates.constEnd(); it != end; ++it) {
+        if ((*it)->isInternal() || isIrrelevant(*it, client, desktop)) {
             continue;
         }
         const int y = topEdge ? (*it)->frameGeometry().bottom() + 1 : (*it)->frameGeometry().top() - 1;
@@ -964,8 +976,10 @@ int Workspace::packPositionDown(const AbstractClient *client, int oldY, bool bot
         return oldY;
     }
     const int desktop = client->desktop() == 0 || client->isOnAllDesktops() ? VirtualDesktopManager::self()->current() : client->desktop();
-    for (auto it = m_allClients.constBegin(), end = m_allClients.constEnd(); it != end; ++it) {
-        if (isIrrelevant(*it, client, desktop)) {
+    // only the clients between the old and the new position can be in the way
+    const auto candidates = m_geometryIndex->intersecting(QRect(QPoint(client->frameGeometry().left(), oldY - 1), QPoint(client->frameGeometry().right(), newY + 1)));
+    for (auto it = candidates.constBegin(), end = candidates.constEnd(); it != end; ++it) {
+        if ((*it)->isInternal() || isIrrelevant(*it, client, desktop)) {
             continue;
         }
         const int y = bottomEdge ? (*it)->frameGeometry().top() - 1 : (*it)->frameGeometry().bottom() + 1;
@@ -434,37 +434,15 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
         }
     }
     Q_ASSERT(image.size() == m_size);
-    q->bind();
     const QRegion damage = s->trackedDamage();
     s->resetTrackedDamage();
     auto scale = s->scale(); //damage is normalised, so needs converting up to match texture
 
-    // TODO: this should be shared with GLTexture::update
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        }
-    } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-        }
+    QRegion scaledDamage;
+    for (const QRect &rect : damage) {
+        scaledDamage += QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
     }
-    q->unbind();
+    q->update(image, scaledDamage);
 }
 
 bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
@@ -480,6 +458,19 @@ bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::Buffer
     q->bind();
 
     const QSize &size = image.size();
+    if (!createTexture(image)) {
+        return false;
+    }
+
+    q->unbind();
+    q->setYInverted(true);
+    m_size = size;
+    updateMatrix();
+    return true;
+}
+
+bool AbstractEglTexture::createTexture(const QImage &image)
+{
     // TODO: this should be shared with GLTexture(const QImage&, GLenum)
     GLenum format = 0;
     switch (image.format()) {
@@ -494,24 +485,26 @@ bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::Buffer
         return false;
     }
     if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && format == GL_RGBA8) {
+        // Use the same format as GLTexture, so that updates can go through GLTexture::update.
+        m_internalFormat = GL_RGBA8;
+        if (s_supportsARGB32) {
             const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
             glTexImage2D(m_target, 0, GL_BGRA_EXT, im.width(), im.height(),
-                         0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
+                         0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.constBits());
         } else {
             const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
             glTexImage2D(m_target, 0, GL_RGBA, im.width(), im.height(),
-                         0, GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
+                         0, GL_RGBA, GL_UNSIGNED_BYTE, im.constBits());
         }
     } else {
-        glTexImage2D(m_target, 0, format, size.width(), size.height(), 0,
-                    GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+        m_internalFormat = format;
+        // Blending expects premultiplied data, only non-premultiplied images need a conversion.
+        const QImage im = image.format() == QImage::Format_ARGB32 ? image.convertToFormat(QImage::Format_ARGB32_Premultiplied) : image;
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, im.bytesPerLine() / 4);
+        glTexImage2D(m_target, 0, format, im.width(), im.height(), 0,
+                     GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, im.constBits());
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     }
-
-    q->unbind();
-    q->setYInverted(true);
-    m_size = size;
-    updateMatrix();
     return true;
 }
 
@@ -566,8 +559,6 @@ bool AbstractEglTexture::loadDmabufTexture(const QPointer< KWayland::Server::Buf
 
 bool AbstractEglTexture::loadInternalImageObject(WindowPixmap *pixmap)
 {
-    // FIXME: Share some code with loadShmTexture().
-
     const QImage image = pixmap->internalImage();
     if (image.isNull()) {
         return false;
@@ -580,33 +571,9 @@ bool AbstractEglTexture::loadInternalImageObject(WindowPixmap *pixmap)
     q->bind();
 
     const QSize &size = image.size();
-    // TODO: this should be shared with GLTexture(const QImage&, GLenum)
-    GLenum format = 0;
-    switch (image.format()) {
-    case QImage::Format_ARGB32:
-    case QImage::Format_ARGB32_Premultiplied:
-        format = GL_RGBA8;
-        break;
-    case QImage::Format_RGB32:
-        format = GL_RGB8;
-        break;
-    default:
+    if (!createTexture(image)) {
         return false;
     }
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && format == GL_RGBA8) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            glTexImage2D(m_target, 0, GL_BGRA_EXT, im.width(), im.height(),
-                         0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            glTexImage2D(m_target, 0, GL_RGBA, im.width(), im.height(),
-                         0, GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
-        }
-    } else {
-        glTexImage2D(m_target, 0, format, size.width(), size.height(), 0,
-                    GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
-    }
 
     q->unbind();
 
@@ -660,8 +627,6 @@ bool AbstractEglTexture::updateFromFBO(const QSharedPointer<QOpenGLFramebufferOb
 
 bool AbstractEglTexture::updateFromInternalImageObject(WindowPixmap *pixmap)
 {
-    // FIXME: Share some code with the shm fallback in updateTexture().
-
     const QImage image = pixmap->internalImage();
     if (image.isNull()) {
         return false;
@@ -675,35 +640,11 @@ bool AbstractEglTexture::updateFromInternalImageObject(WindowPixmap *pixmap)
     const QRegion damage = pixmap->toplevel()->damage();
     const qreal scale = image.devicePixelRatio();
 
-    q->bind();
-
-    // TODO: this should be shared with GLTexture::update
-    if (GLPlatform::instance()->isGLES()) {
-        if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-                glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-            }
-        }
-    } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            auto scaledRect = QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
-            glTexSubImage2D(m_target, 0, scaledRect.x(), scaledRect.y(), scaledRect.width(), scaledRect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(scaledRect).bits());
-        }
+    QRegion scaledDamage;
+    for (const QRect &rect : damage) {
+        scaledDamage += QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
     }
-
-    q->unbind();
+    q->update(image, scaledDamage);
 
     return true;
 }
@@ -65,4 +65,10 @@ QImage *QPainterBackend::bufferForScreen(int screenId)
     return buffer();
 }
 
+bool QPainterBackend::needsFullRepaintForScreen(int screenId) const
+{
+    Q_UNUSED(screenId)
+    return needsFullRepaint();
+}
+
 }
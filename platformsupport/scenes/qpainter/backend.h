@@ -81,6 +81,13 @@ public:
      */
     virtual QImage *bufferForScreen(int screenId);
     virtual bool needsFullRepaint() const = 0;
+    /**
+     * Overload for the case that there is a different buffer per screen, which means that
+     * only the buffer of @p screenId might need a full repaint.
+     * Default implementation just calls needsFullRepaint.
+     * @param screenId The id of the screen as used in Screens
+     */
+    virtual bool needsFullRepaintForScreen(int screenId) const;
     /**
      * Whether the rendering needs to be split per screen.
      * Default implementation returns @c false.
@@ -31,8 +31,14 @@ KGlobalAccelImpl::~KGlobalAccelImpl() = default;
 
 bool KGlobalAccelImpl::grabKey(int key, bool grab)
 {
-    Q_UNUSED(key)
-    Q_UNUSED(grab)
+    if (grab) {
+        m_grabbedKeys.insert(key);
+    } else {
+        m_grabbedKeys.remove(key);
+    }
+    if (m_enabled && !m_shuttingDown) {
+        KWin::InputRedirection::self()->registerGlobalAccelKeys(m_grabbedKeys);
+    }
     return true;
 }
 
@@ -49,7 +55,11 @@ void KGlobalAccelImpl::setEnabled(bool enabled)
             m_inputDestroyedConnection = connect(s_input, &QObject::destroyed, this, [this] { m_shuttingDown = true; });
         }
     }
+    m_enabled = enabled;
     s_input->registerGlobalAccel(enabled ? this : nullptr);
+    if (enabled) {
+        s_input->registerGlobalAccelKeys(m_grabbedKeys);
+    }
 }
 
 bool KGlobalAccelImpl::checkKeyPressed(int keyQt)
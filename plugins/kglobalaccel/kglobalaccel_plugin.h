@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KGlobalAccel/private/kglobalaccel_interface.h>
 
 #include <QObject>
+#include <QSet>
 
 class KGlobalAccelImpl : public KGlobalAccelInterface
 {
@@ -47,6 +48,8 @@ public Q_SLOTS:
     bool checkKeyPressed(int keyQt);
 
 private:
+    QSet<int> m_grabbedKeys;
+    bool m_enabled = false;
     bool m_shuttingDown = false;
     QMetaObject::Connection m_inputDestroyedConnection;
 };
@@ -207,7 +207,9 @@ void DrmBackend::reactivate()
     // restart compositor
     m_pageFlipsPending = 0;
     if (Compositor *compositor = Compositor::self()) {
-        compositor->bufferSwapComplete();
+        for (DrmOutput *o : qAsConst(m_outputs)) {
+            compositor->bufferSwapComplete(o);
+        }
         compositor->addRepaintFull();
     }
 }
@@ -217,9 +219,11 @@ void DrmBackend::deactivate()
     if (!m_active) {
         return;
     }
-    // block compositor
-    if (m_pageFlipsPending == 0 && Compositor::self()) {
-        Compositor::self()->aboutToSwapBuffers();
+    // block compositor on all outputs
+    if (Compositor *compositor = Compositor::self()) {
+        for (DrmOutput *o : qAsConst(m_outputs)) {
+            compositor->aboutToSwapBuffers(o);
+        }
     }
     // hide cursor and disable
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
@@ -239,13 +243,9 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
 
     output->pageFlipped();
     output->m_backend->m_pageFlipsPending--;
-    if (output->m_backend->m_pageFlipsPending == 0) {
-        // TODO: improve, this currently means we wait for all page flips or all outputs.
-        // It would be better to driver the repaint per output
-
-        if (Compositor::self()) {
-            Compositor::self()->bufferSwapComplete();
-        }
+    // every output is repainted at its own pace, don't wait for the other outputs
+    if (Compositor::self() && output->m_backend->m_active) {
+        Compositor::self()->bufferSwapComplete(output);
     }
 }
 
@@ -594,8 +594,8 @@ bool DrmBackend::present(DrmBuffer *buffer, DrmOutput *output)
 
     if (output->present(buffer)) {
         m_pageFlipsPending++;
-        if (m_pageFlipsPending == 1 && Compositor::self()) {
-            Compositor::self()->aboutToSwapBuffers();
+        if (Compositor::self()) {
+            Compositor::self()->aboutToSwapBuffers(output);
         }
         return true;
     } else if (m_deleteBufferAfterPageFlip) {
@@ -35,6 +35,30 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+namespace
+{
+
+/**
+ * The framebuffer of a gbm_bo, owned by the bo through its user data. A GbmSurface only
+ * cycles through a few bos, so the framebuffer is created once and removed together
+ * with the bo, when the surface is destroyed.
+ */
+struct GbmFramebuffer
+{
+    int fd;
+    uint32_t id;
+};
+
+void destroyFramebuffer(gbm_bo *bo, void *data)
+{
+    Q_UNUSED(bo)
+    GbmFramebuffer *framebuffer = static_cast<GbmFramebuffer *>(data);
+    drmModeRmFB(framebuffer->fd, framebuffer->id);
+    delete framebuffer;
+}
+
+}
+
 // DrmSurfaceBuffer
 DrmSurfaceBuffer::DrmSurfaceBuffer(int fd, const std::shared_ptr<GbmSurface> &surface)
     : DrmBuffer(fd)
@@ -46,17 +70,20 @@ DrmSurfaceBuffer::DrmSurfaceBuffer(int fd, const std::shared_ptr<GbmSurface> &su
         return;
     }
     m_size = QSize(gbm_bo_get_width(m_bo), gbm_bo_get_height(m_bo));
+    if (GbmFramebuffer *framebuffer = static_cast<GbmFramebuffer *>(gbm_bo_get_user_data(m_bo))) {
+        m_bufferId = framebuffer->id;
+        return;
+    }
     if (drmModeAddFB(fd, m_size.width(), m_size.height(), 24, 32, gbm_bo_get_stride(m_bo), gbm_bo_get_handle(m_bo).u32, &m_bufferId) != 0) {
         qCWarning(KWIN_DRM) << "drmModeAddFB failed";
+        return;
     }
-    gbm_bo_set_user_data(m_bo, this, nullptr);
+    gbm_bo_set_user_data(m_bo, new GbmFramebuffer{fd, m_bufferId}, destroyFramebuffer);
 }
 
 DrmSurfaceBuffer::~DrmSurfaceBuffer()
 {
-    if (m_bufferId) {
-        drmModeRmFB(fd(), m_bufferId);
-    }
+    // the framebuffer stays with the bo
     releaseGbm();
 }
 
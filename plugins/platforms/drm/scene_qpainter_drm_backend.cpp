@@ -113,21 +113,23 @@ bool DrmQPainterBackend::needsFullRepaint() const
 
 void DrmQPainterBackend::prepareRenderingFrame()
 {
-    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
-        (*it).index = ((*it).index + 1) % 2;
-    }
 }
 
 void DrmQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
-    Q_UNUSED(damage)
     if (!LogindIntegration::self()->isActiveSession()) {
         return;
     }
     for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
-        const Output &o = *it;
+        Output &o = *it;
+        if (!damage.intersects(o.output->geometry())) {
+            // the screen was not rendered in this frame
+            continue;
+        }
         m_backend->present(o.buffer[o.index], o.output);
+        // render the next frame into the other buffer
+        o.index = (o.index + 1) % 2;
     }
 }
 
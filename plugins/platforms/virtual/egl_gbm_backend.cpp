@@ -106,7 +106,9 @@ void EglGbmBackend::init()
         return;
     }
 
-    setSupportsBufferAge(false);
+    // The back buffer is a framebuffer object, which keeps its content between frames.
+    // So after the first frame it always has a buffer age of one.
+    setSupportsBufferAge(true);
     initWayland();
 }
 
@@ -184,6 +186,9 @@ QRegion EglGbmBackend::prepareRenderingFrame()
     if (!GLRenderTarget::isRenderTargetBound()) {
         GLRenderTarget::pushRenderTarget(m_fbo);
     }
+    if (m_backBufferValid) {
+        return QRegion();
+    }
     return QRegion(0, 0, screens()->size().width(), screens()->size().height());
 }
 
@@ -230,6 +235,7 @@ void EglGbmBackend::endRenderingFrame(const QRegion &renderedRegion, const QRegi
     }
     GLRenderTarget::popRenderTarget();
     setLastDamage(renderedRegion);
+    m_backBufferValid = true;
 }
 
 bool EglGbmBackend::usesOverlayWindow() const
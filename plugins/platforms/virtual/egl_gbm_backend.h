@@ -53,6 +53,7 @@ private:
     GLTexture *m_backBuffer = nullptr;
     GLRenderTarget *m_fbo = nullptr;
     int m_frameCounter = 0;
+    bool m_backBufferValid = false;
     friend class EglGbmTexture;
 };
 
@@ -48,7 +48,12 @@ QImage *VirtualQPainterBackend::bufferForScreen(int screen)
 
 bool VirtualQPainterBackend::needsFullRepaint() const
 {
-    return true;
+    return m_needsFullRepaint.contains(true);
+}
+
+bool VirtualQPainterBackend::needsFullRepaintForScreen(int screenId) const
+{
+    return m_needsFullRepaint.value(screenId, true);
 }
 
 void VirtualQPainterBackend::prepareRenderingFrame()
@@ -63,12 +68,17 @@ void VirtualQPainterBackend::createOutputs()
         buffer.fill(Qt::black);
         m_backBuffers << buffer;
     }
+    m_needsFullRepaint.fill(true, m_backBuffers.count());
 }
 
 void VirtualQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
-    Q_UNUSED(damage)
+    for (int i = 0; i < m_needsFullRepaint.count(); ++i) {
+        if (damage.intersects(screens()->geometry(i))) {
+            m_needsFullRepaint[i] = false;
+        }
+    }
     if (m_backend->saveFrames()) {
         for (int i=0; i < m_backBuffers.size() ; i++) {
             m_backBuffers[i].save(QStringLiteral("%1/screen%2-%3.png").arg(m_backend->screenshotDirPath(), QString::number(i), QString::number(m_frameCounter++)));
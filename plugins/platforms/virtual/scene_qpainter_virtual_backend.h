@@ -40,6 +40,7 @@ public:
     QImage *buffer() override;
     QImage *bufferForScreen(int screenId) override;
     bool needsFullRepaint() const override;
+    bool needsFullRepaintForScreen(int screenId) const override;
     bool usesOverlayWindow() const override;
     void prepareRenderingFrame() override;
     void present(int mask, const QRegion &damage) override;
@@ -49,6 +50,8 @@ private:
     void createOutputs();
 
     QVector<QImage> m_backBuffers;
+    // the buffers keep their content, so only new buffers need a full repaint
+    QVector<bool> m_needsFullRepaint;
     VirtualBackend *m_backend;
     int m_frameCounter = 0;
 };
@@ -289,10 +289,7 @@ void EglWaylandBackend::present()
 void EglWaylandBackend::presentOnSurface(EglWaylandOutput *output)
 {
     output->m_waylandOutput->surface()->setupFrameCallback();
-    if (!m_swapping) {
-        m_swapping = true;
-        Compositor::self()->aboutToSwapBuffers();
-    }
+    Compositor::self()->aboutToSwapBuffers(output->m_waylandOutput);
 
     if (supportsBufferAge()) {
         eglSwapBuffers(eglDisplay(), output->m_eglSurface);
@@ -324,7 +321,6 @@ QRegion EglWaylandBackend::prepareRenderingFrame()
 {
     eglWaitNative(EGL_CORE_NATIVE_ENGINE);
     startRenderTimer();
-    m_swapping = false;
     return QRegion();
 }
 
@@ -357,7 +353,7 @@ void EglWaylandBackend::endRenderingFrame(const QRegion &renderedRegion, const Q
 void EglWaylandBackend::endRenderingFrameForScreen(int screenId, const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     EglWaylandOutput *output = m_outputs[screenId];
-    if (damagedRegion.intersected(output->m_waylandOutput->geometry()).isEmpty() && screenId == 0) {
+    if (damagedRegion.intersected(output->m_waylandOutput->geometry()).isEmpty()) {
 
         // If the damaged region of a window is fully occluded, the only
         // rendering done, if any, will have been to repair a reused back
@@ -370,17 +366,13 @@ void EglWaylandBackend::endRenderingFrameForScreen(int screenId, const QRegion &
             glFlush();
         }
 
-        for (auto *o : qAsConst(m_outputs)) {
-            o->m_bufferAge = 1;
-        }
+        output->m_bufferAge = 1;
         return;
     }
     presentOnSurface(output);
 
     // Save the damaged region to history
-    // Note: damage history is only collected for the first screen. See EglGbmBackend
-    // for mor information regarding this limitation.
-    if (supportsBufferAge() && screenId == 0) {
+    if (supportsBufferAge()) {
         if (output->m_damageHistory.count() > 10) {
             output->m_damageHistory.removeLast();
         }
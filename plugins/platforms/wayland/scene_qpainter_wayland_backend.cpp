@@ -174,10 +174,14 @@ void WaylandQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
 
-    Compositor::self()->aboutToSwapBuffers();
     m_needsFullRepaint = false;
 
     for (auto *output : m_outputs) {
+        // outputs without damage did not get rendered, keep their previous buffer
+        if (!damage.intersects(output->m_waylandOutput->geometry())) {
+            continue;
+        }
+        Compositor::self()->aboutToSwapBuffers(output->m_waylandOutput);
         output->present(damage);
     }
 }
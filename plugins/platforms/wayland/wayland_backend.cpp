@@ -707,7 +707,9 @@ void WaylandBackend::createOutputs()
             updateScreenSize(waylandOutput);
             Compositor::self()->addRepaintFull();
         });
-        connect(waylandOutput, &WaylandOutput::frameRendered, this, &WaylandBackend::checkBufferSwap);
+        connect(waylandOutput, &WaylandOutput::frameRendered, this, [this, waylandOutput] {
+            checkBufferSwap(waylandOutput);
+        });
 
         logicalWidthSum += logicalWidth;
         m_outputs << waylandOutput;
@@ -735,27 +737,16 @@ QPainterBackend *WaylandBackend::createQPainterBackend()
     return new WaylandQPainterBackend(this);
 }
 
-void WaylandBackend::checkBufferSwap()
+void WaylandBackend::checkBufferSwap(WaylandOutput *output)
 {
-    const bool allRendered = std::all_of(m_outputs.begin(), m_outputs.end(), [](WaylandOutput *o) {
-            return o->rendered();
-        });
-    if (!allRendered) {
-        // need to wait more
-        // TODO: what if one does not need to be rendered (no damage)?
+    // Every output is presented on its own surface and gets its own frame callback,
+    // so the swap completes per output. Waiting for all outputs would stall an output
+    // which is repainted while the other ones are not.
+    if (!output->rendered()) {
         return;
     }
-
-    for (auto *output : m_outputs) {
-        if (!output->rendered()) {
-            return;
-        }
-    }
-    Compositor::self()->bufferSwapComplete();
-
-    for (auto *output : m_outputs) {
-        output->resetRendered();
-    }
+    output->resetRendered();
+    Compositor::self()->bufferSwapComplete(output);
 }
 
 void WaylandBackend::flush()
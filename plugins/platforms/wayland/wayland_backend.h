@@ -210,7 +210,7 @@ public:
 
     QVector<CompositingType> supportedCompositors() const override;
 
-    void checkBufferSwap();
+    void checkBufferSwap(WaylandOutput *output);
 
     WaylandOutput* getOutputAt(const QPointF globalPosition);
     Outputs outputs() const override;
@@ -52,6 +52,8 @@ bool EglX11Backend::createSurfaces()
         }
         m_surfaces << s;
     }
+    m_bufferAges.fill(0, m_surfaces.count());
+    m_damageHistories.fill(QList<QRegion>(), m_surfaces.count());
     if (m_surfaces.isEmpty()) {
         return false;
     }
@@ -97,7 +99,22 @@ QRegion EglX11Backend::prepareRenderingForScreen(int screenId)
 {
     makeContextCurrent(m_surfaces.at(screenId));
     setupViewport(screenId);
-    return screens()->geometry(screenId);
+    const QRect geometry = screens()->geometry(screenId);
+    if (!supportsBufferAge()) {
+        return geometry;
+    }
+
+    // Note: An age of zero means the buffer contents are undefined
+    const int bufferAge = m_bufferAges.at(screenId);
+    const QList<QRegion> &damageHistory = m_damageHistories.at(screenId);
+    if (bufferAge <= 0 || bufferAge > damageHistory.count()) {
+        return geometry;
+    }
+    QRegion region;
+    for (int i = 0; i < bufferAge - 1; i++) {
+        region |= damageHistory.at(i);
+    }
+    return region;
 }
 
 void EglX11Backend::setupViewport(int screenId)
@@ -113,9 +130,27 @@ void EglX11Backend::setupViewport(int screenId)
 
 void EglX11Backend::endRenderingFrameForScreen(int screenId, const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
-    Q_UNUSED(damagedRegion)
     const QRect &outputGeometry = screens()->geometry(screenId);
-    presentSurface(m_surfaces.at(screenId), renderedRegion, outputGeometry);
+    if (supportsBufferAge() && damagedRegion.intersected(outputGeometry).isEmpty()) {
+        // Nothing got damaged, at most a reused back buffer got repaired. Don't post it,
+        // but remember that it is up to date.
+        if (!renderedRegion.intersected(outputGeometry).isEmpty()) {
+            glFlush();
+        }
+        m_bufferAges[screenId] = 1;
+        return;
+    }
+    EGLSurface surface = m_surfaces.at(screenId);
+    presentSurface(surface, renderedRegion, outputGeometry);
+
+    if (supportsBufferAge()) {
+        eglQuerySurface(eglDisplay(), surface, EGL_BUFFER_AGE_EXT, &m_bufferAges[screenId]);
+        QList<QRegion> &damageHistory = m_damageHistories[screenId];
+        if (damageHistory.count() > 10) {
+            damageHistory.removeLast();
+        }
+        damageHistory.prepend(damagedRegion.intersected(outputGeometry));
+    }
 }
 
 } // namespace
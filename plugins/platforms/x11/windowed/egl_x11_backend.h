@@ -49,6 +49,9 @@ protected:
 private:
     void setupViewport(int screenId);
     QVector<EGLSurface> m_surfaces;
+    // buffer age and damage history of each surface
+    QVector<int> m_bufferAges;
+    QVector<QList<QRegion>> m_damageHistories;
     X11WindowedBackend *m_backend;
 };
 
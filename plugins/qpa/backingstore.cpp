@@ -28,6 +28,8 @@ namespace KWin
 namespace QPA
 {
 
+static const int s_maxRetainedBuffers = 2;
+
 BackingStore::BackingStore(QWindow *window)
     : QPlatformBackingStore(window)
 {
@@ -54,8 +56,14 @@ void BackingStore::resize(const QSize &size, const QRegion &staticContents)
     m_backBuffer = QImage(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
     m_backBuffer.setDevicePixelRatio(devicePixelRatio);
 
-    m_frontBuffer = QImage(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-    m_frontBuffer.setDevicePixelRatio(devicePixelRatio);
+    m_buffers.clear();
+    m_paintedRegion = QRegion();
+}
+
+void BackingStore::beginPaint(const QRegion &region)
+{
+    m_paintedRegion += region;
+    QPlatformBackingStore::beginPaint(region);
 }
 
 static void blitImage(const QImage &source, QImage &target, const QRect &rect)
@@ -94,9 +102,38 @@ void BackingStore::flush(QWindow *window, const QRegion &region, const QPoint &o
         return;
     }
 
-    blitImage(m_backBuffer, m_frontBuffer, region);
+    // The client keeps a shallow copy of the presented image, so painting into it again
+    // would detach. Continue painting into a buffer the compositor no longer references.
+    client->present(m_backBuffer, region);
+
+    const QRegion damage = m_paintedRegion | region;
+    m_paintedRegion = QRegion();
+    for (Buffer &buffer : m_buffers) {
+        buffer.damage += damage;
+    }
+
+    const QImage presented = m_backBuffer;
+    m_backBuffer = acquireBuffer(presented);
+
+    m_buffers.append(Buffer{presented, QRegion()});
+    while (m_buffers.count() > s_maxRetainedBuffers) {
+        m_buffers.removeFirst();
+    }
+}
+
+QImage BackingStore::acquireBuffer(const QImage &presented)
+{
+    for (int i = 0; i < m_buffers.count(); ++i) {
+        if (!m_buffers[i].image.isDetached()) {
+            continue;
+        }
+        Buffer buffer = m_buffers.takeAt(i);
+        blitImage(presented, buffer.image, buffer.damage);
+        return buffer.image;
+    }
 
-    client->present(m_frontBuffer, region);
+    // Every retained buffer is still referenced by the compositor, allocate a new one.
+    return presented.copy();
 }
 
 }
@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <qpa/qplatformbackingstore.h>
 
+#include <QImage>
+#include <QVector>
+
 namespace KWin
 {
 namespace QPA
@@ -37,10 +40,26 @@ public:
     QPaintDevice *paintDevice() override;
     void flush(QWindow *window, const QRegion &region, const QPoint &offset) override;
     void resize(const QSize &size, const QRegion &staticContents) override;
+    void beginPaint(const QRegion &region) override;
 
 private:
+    struct Buffer {
+        QImage image;
+        /**
+         * Area painted into the chain since this buffer was last brought up to date.
+         */
+        QRegion damage;
+    };
+
+    QImage acquireBuffer(const QImage &presented);
+
     QImage m_backBuffer;
-    QImage m_frontBuffer;
+    /**
+     * Buffers previously handed over to the InternalClient, oldest first. A buffer
+     * is recycled once the compositor has dropped all of its references to it.
+     */
+    QVector<Buffer> m_buffers;
+    QRegion m_paintedRegion;
 };
 
 }
@@ -54,9 +54,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Server/subcompositor_interface.h>
 #include <KWayland/Server/surface_interface.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <unistd.h>
 
 #include <QDBusConnection>
@@ -370,6 +372,7 @@ SceneOpenGL::~SceneOpenGL()
         makeOpenGLContextCurrent();
     }
     SceneOpenGL::EffectFrame::cleanup();
+    releaseDesktopThumbnailCache();
 
     delete m_syncManager;
 
@@ -503,6 +506,11 @@ bool SceneOpenGL::blocksForRetrace() const
     return m_backend->blocksForRetrace();
 }
 
+bool SceneOpenGL::perScreenRendering() const
+{
+    return m_backend->perScreenRendering();
+}
+
 void SceneOpenGL::idle()
 {
     m_backend->idle();
@@ -634,6 +642,10 @@ qint64 SceneOpenGL::paint(QRegion damage, QList<Toplevel *> toplevels)
         m_backend->prepareRenderingFrame();
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect &geo = screens()->geometry(i);
+            if (!damage.intersects(geo)) {
+                // nothing changed on this screen, don't render and present it
+                continue;
+            }
             QRegion update;
             QRegion valid;
             // prepare rendering makes context current on the output
@@ -712,6 +724,7 @@ qint64 SceneOpenGL::paint(QRegion damage, QList<Toplevel *> toplevels)
 
     // do cleanup
     clearStackingOrder();
+    emit frameRendered();
     return m_backend->renderTime();
 }
 
@@ -917,6 +930,7 @@ bool SceneOpenGL2::supported(OpenGLBackend *backend)
 SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
     : SceneOpenGL(backend, parent)
     , m_lanczosFilter(nullptr)
+    , m_windowBatching(qstrcmp(qgetenv("KWIN_GL_WINDOW_BATCHING"), "0") != 0)
 {
     if (!init_ok) {
         // base ctor already failed
@@ -1008,7 +1022,34 @@ void SceneOpenGL2::paintSimpleScreen(int mask, QRegion region)
 {
     m_screenProjectionMatrix = m_projectionMatrix;
 
+    // Windows an effect paints something for are painted outside of the batch, see paintWindow()
+    const bool batching = m_windowBatching && !m_windowBatch.isActive();
+    if (batching) {
+        m_windowBatch.begin(m_projectionMatrix);
+    }
+
     Scene::paintSimpleScreen(mask, region);
+
+    if (batching) {
+        m_windowBatch.end();
+    }
+}
+
+void SceneOpenGL2::paintWindow(Scene::Window *w, int mask, QRegion region, WindowQuadList quads)
+{
+    // What an effect or a thumbnail paints around a window must neither end up below the
+    // windows collected before, nor above the window itself. The batch is painted before
+    // such a window and collecting starts again after it.
+    EffectWindowImpl *effectWindow = w->window()->effectWindow();
+    if (m_windowBatch.isActive() && effectWindow &&
+            (static_cast<EffectsHandlerImpl *>(effects)->hasWindowPaintEffects(effectWindow) ||
+             !effectWindow->thumbnails().isEmpty() || !effectWindow->desktopThumbnails().isEmpty())) {
+        m_windowBatch.end();
+        Scene::paintWindow(w, mask, region, quads);
+        m_windowBatch.begin(m_projectionMatrix);
+        return;
+    }
+    Scene::paintWindow(w, mask, region, quads);
 }
 
 void SceneOpenGL2::paintGenericScreen(int mask, ScreenPaintData data)
@@ -1048,6 +1089,14 @@ void SceneOpenGL2::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region
 
 void SceneOpenGL2::performPaintWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data)
 {
+    if (m_windowBatch.isActive()) {
+        if (!(mask & PAINT_WINDOW_LANCZOS) &&
+                static_cast<OpenGLWindow *>(w->sceneWindow())->paintBatched(&m_windowBatch, mask, region, data)) {
+            return;
+        }
+        // keep the painting order
+        m_windowBatch.flush();
+    }
     if (mask & PAINT_WINDOW_LANCZOS) {
         if (!m_lanczosFilter) {
             m_lanczosFilter = new LanczosFilter(this);
@@ -1064,6 +1113,116 @@ void SceneOpenGL2::performPaintWindow(EffectWindowImpl* w, int mask, QRegion reg
         w->sceneWindow()->performPaint(mask, region, data);
 }
 
+//****************************************
+// OpenGLWindowBatch
+//****************************************
+
+static GLenum batchPrimitiveType()
+{
+    return GLVertexBuffer::supportsIndexedQuads() ? GL_QUADS : GL_TRIANGLES;
+}
+
+void OpenGLWindowBatch::begin(const QMatrix4x4 &projection)
+{
+    m_projection = projection;
+    m_active = true;
+}
+
+void OpenGLWindowBatch::end()
+{
+    flush();
+    m_active = false;
+}
+
+GLVertex2D *OpenGLWindowBatch::allocate(int count)
+{
+    // the storage is kept across frames, so it only grows a few times in the beginning
+    const int required = m_vertexCount + count;
+    if (m_vertices.size() < required) {
+        m_vertices.resize(qMax(required, m_vertices.size() * 2));
+    }
+    GLVertex2D *vertices = m_vertices.data() + m_vertexCount;
+    m_vertexCount = required;
+    return vertices;
+}
+
+void OpenGLWindowBatch::flush()
+{
+    if (m_draws.isEmpty()) {
+        m_vertexCount = 0;
+        return;
+    }
+
+    const GLVertexAttrib attribs[] = {
+        { VA_Position, 2, GL_FLOAT, offsetof(GLVertex2D, position) },
+        { VA_TexCoord, 2, GL_FLOAT, offsetof(GLVertex2D, texcoord) },
+    };
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+    const size_t size = m_vertexCount * sizeof(GLVertex2D);
+    memcpy(vbo->map(size), m_vertices.constData(), size);
+    vbo->unmap();
+    vbo->bindArrays();
+
+    ShaderBinder binder(m_traits);
+    GLShader *shader = binder.shader();
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, m_projection);
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    const GLenum primitiveType = batchPrimitiveType();
+    bool blend = false;
+    QVector4D modulation(1.0, 1.0, 1.0, 1.0);
+    if (m_traits & ShaderTrait::Modulate) {
+        shader->setUniform(GLShader::ModulationConstant, modulation);
+    }
+
+    for (int i = 0; i < m_draws.count(); ++i) {
+        const Draw &draw = m_draws.at(i);
+        int vertexCount = draw.vertexCount;
+        // consecutive draws of the same texture, e.g. of a shared shadow, become a single one
+        while (i + 1 < m_draws.count()) {
+            const Draw &next = m_draws.at(i + 1);
+            if (next.texture != draw.texture || next.filter != draw.filter || next.blend != draw.blend ||
+                    next.modulation != draw.modulation || next.firstVertex != draw.firstVertex + vertexCount) {
+                break;
+            }
+            vertexCount += next.vertexCount;
+            ++i;
+        }
+
+        if (draw.blend != blend) {
+            if (draw.blend) {
+                glEnable(GL_BLEND);
+            } else {
+                glDisable(GL_BLEND);
+            }
+            blend = draw.blend;
+        }
+        if ((m_traits & ShaderTrait::Modulate) && draw.modulation != modulation) {
+            shader->setUniform(GLShader::ModulationConstant, draw.modulation);
+            modulation = draw.modulation;
+        }
+
+        draw.texture->setFilter(draw.filter);
+        draw.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        draw.texture->bind();
+
+        vbo->draw(infiniteRegion(), primitiveType, draw.firstVertex, vertexCount, false);
+    }
+
+    vbo->unbindArrays();
+    if (blend) {
+        glDisable(GL_BLEND);
+    }
+
+    m_draws.clear();
+    m_vertexCount = 0;
+    m_traits = ShaderTrait::MapTexture;
+}
+
 //****************************************
 // OpenGLWindow
 //****************************************
@@ -1336,11 +1495,133 @@ void OpenGLWindow::renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, con
     }
 }
 
+void OpenGLWindow::splitQuads(const WindowQuadList &quads, WindowQuadList *leaves) const
+{
+    // Split the quads into separate lists for each type, with a single allocation per list
+    int quadCounts[LeafCount] = {};
+    for (const WindowQuad &quad : quads) {
+        switch (quad.type()) {
+        case WindowQuadDecoration:
+            quadCounts[DecorationLeaf]++;
+            continue;
+        case WindowQuadContents:
+            quadCounts[ContentLeaf]++;
+            continue;
+        case WindowQuadShadow:
+            quadCounts[ShadowLeaf]++;
+            continue;
+        default:
+            continue;
+        }
+    }
+    for (int i = 0; i < LeafCount; i++) {
+        leaves[i].reserve(quadCounts[i]);
+    }
+    for (const WindowQuad &quad : quads) {
+        switch (quad.type()) {
+        case WindowQuadDecoration:
+            leaves[DecorationLeaf].append(quad);
+            continue;
+
+        case WindowQuadContents:
+            leaves[ContentLeaf].append(quad);
+            continue;
+
+        case WindowQuadShadow:
+            leaves[ShadowLeaf].append(quad);
+            continue;
+
+        default:
+            continue;
+        }
+    }
+}
+
+bool OpenGLWindow::hasMappedSubSurfaces() const
+{
+    auto wp = windowPixmap<OpenGLWindowPixmap>();
+    if (!wp) {
+        return false;
+    }
+    const auto &children = wp->children();
+    return std::any_of(children.begin(), children.end(), [](WindowPixmap *pixmap) {
+        return !pixmap->subSurface().isNull() && !pixmap->subSurface()->surface().isNull()
+            && pixmap->subSurface()->surface()->isMapped();
+    });
+}
+
+bool OpenGLWindow::paintBatched(OpenGLWindowBatch *batch, int mask, const QRegion &region, WindowPaintData &data)
+{
+    // Only windows painted at their position with the default shader share the
+    // projection matrix and shader of the batch.
+    if ((mask & (Scene::PAINT_WINDOW_TRANSFORMED | Scene::PAINT_SCREEN_TRANSFORMED)) || data.shader ||
+            !data.projectionMatrix().isIdentity() || !data.modelViewMatrix().isIdentity() ||
+            data.saturation() != 1.0 || data.crossFadeProgress() != 1.0) {
+        return false;
+    }
+
+    if (!beginRenderWindow(mask, region, data)) {
+        return true;
+    }
+    if (hasMappedSubSurfaces()) {
+        // sub-surfaces are painted with their own vertices on top of the window
+        batch->flush();
+        renderWindow(mask, region, data);
+        return true;
+    }
+
+    WindowQuadList quads[LeafCount];
+    splitQuads(data.quads, quads);
+
+    LeafNode nodes[LeafCount];
+    setupLeafNodes(nodes, quads, data);
+
+    if (data.opacity() != 1.0 || data.brightness() != 1.0) {
+        batch->addShaderTraits(ShaderTrait::Modulate);
+    }
+
+    const GLenum primitiveType = batchPrimitiveType();
+    const int verticesPerQuad = primitiveType == GL_QUADS ? 4 : 6;
+    const GLenum filter = waylandServer() ? GL_LINEAR : GL_NEAREST;
+    // the batch is painted with the projection matrix only
+    const QVector2D offset(x(), y());
+
+    for (int i = 0; i < LeafCount; i++) {
+        if (quads[i].isEmpty() || !nodes[i].texture)
+            continue;
+
+        const int firstVertex = batch->vertexCount();
+        const int vertexCount = quads[i].count() * verticesPerQuad;
+        GLVertex2D *vertices = batch->allocate(vertexCount);
+        quads[i].makeInterleavedArrays(primitiveType, vertices, nodes[i].texture->matrix(nodes[i].coordinateType));
+        for (int j = 0; j < vertexCount; j++) {
+            vertices[j].position += offset;
+        }
+
+        batch->addDraw({
+            nodes[i].texture,
+            filter,
+            modulate(nodes[i].opacity, data.brightness()),
+            nodes[i].hasAlpha || nodes[i].opacity < 1.0,
+            firstVertex,
+            vertexCount
+        });
+    }
+
+    endRenderWindow();
+    return true;
+}
+
 void OpenGLWindow::performPaint(int mask, QRegion region, WindowPaintData data)
 {
     if (!beginRenderWindow(mask, region, data))
         return;
 
+    renderWindow(mask, region, data);
+}
+
+void OpenGLWindow::renderWindow(int mask, const QRegion &region, WindowPaintData &data)
+{
     QMatrix4x4 windowMatrix = transformation(mask, data);
     const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
     const QMatrix4x4 mvpMatrix = modelViewProjection * windowMatrix;
@@ -1383,26 +1664,7 @@ void OpenGLWindow::performPaint(int mask, QRegion region, WindowPaintData data)
     shader->setUniform(GLShader::Saturation, data.saturation());
 
     WindowQuadList quads[LeafCount];
-
-    // Split the quads into separate lists for each type
-    foreach (const WindowQuad &quad, data.quads) {
-        switch (quad.type()) {
-        case WindowQuadDecoration:
-            quads[DecorationLeaf].append(quad);
-            continue;
-
-        case WindowQuadContents:
-            quads[ContentLeaf].append(quad);
-            continue;
-
-        case WindowQuadShadow:
-            quads[ShadowLeaf].append(quad);
-            continue;
-
-        default:
-            continue;
-        }
-    }
+    splitQuads(data.quads, quads);
 
     if (data.crossFadeProgress() != 1.0) {
         OpenGLWindowPixmap *previous = previousWindowPixmap<OpenGLWindowPixmap>();
@@ -60,6 +60,7 @@ public:
     bool usesOverlayWindow() const override;
     bool blocksForRetrace() const override;
     bool syncsToVBlank() const override;
+    bool perScreenRendering() const override;
     bool makeOpenGLContextCurrent() override;
     void doneOpenGLContextCurrent() override;
     Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *impl) override;
@@ -113,6 +114,69 @@ private:
     SyncObject *m_currentFence;
 };
 
+/**
+ * Collects the draws of windows painted untransformed with the default shader.
+ *
+ * The vertices of all collected windows are uploaded at once and drawn with a single
+ * shader setup, only the textures and the blend state change between the draws.
+ * The draws keep the painting order, anything else painted in between has to flush
+ * the batch first.
+ */
+class OpenGLWindowBatch
+{
+public:
+    struct Draw
+    {
+        GLTexture *texture;
+        GLenum filter;
+        QVector4D modulation;
+        bool blend;
+        int firstVertex;
+        int vertexCount;
+    };
+
+    bool isActive() const {
+        return m_active;
+    }
+    /**
+     * Starts collecting draws which get painted with the @p projection matrix.
+     */
+    void begin(const QMatrix4x4 &projection);
+    /**
+     * Paints the collected draws and stops collecting.
+     */
+    void end();
+    /**
+     * Paints the collected draws.
+     */
+    void flush();
+
+    /**
+     * Adds the @p traits the shader of the collected draws needs.
+     */
+    void addShaderTraits(ShaderTraits traits) {
+        m_traits |= traits;
+    }
+    int vertexCount() const {
+        return m_vertexCount;
+    }
+    /**
+     * Returns storage for @p count vertices, valid until the next call.
+     */
+    GLVertex2D *allocate(int count);
+    void addDraw(const Draw &draw) {
+        m_draws.append(draw);
+    }
+
+private:
+    QVector<GLVertex2D> m_vertices;
+    int m_vertexCount = 0;
+    QVector<Draw> m_draws;
+    QMatrix4x4 m_projection;
+    ShaderTraits m_traits = ShaderTrait::MapTexture;
+    bool m_active = false;
+};
+
 class SceneOpenGL2 : public SceneOpenGL
 {
     Q_OBJECT
@@ -131,6 +195,7 @@ public:
 protected:
     void paintSimpleScreen(int mask, QRegion region) override;
     void paintGenericScreen(int mask, ScreenPaintData data) override;
+    void paintWindow(Scene::Window *w, int mask, QRegion region, WindowQuadList quads) override;
     void doPaintBackground(const QVector< float >& vertices) override;
     Scene::Window *createWindow(Toplevel *t) override;
     void finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data) override;
@@ -146,6 +211,8 @@ private:
     QScopedPointer<GLTexture> m_cursorTexture;
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_screenProjectionMatrix;
+    OpenGLWindowBatch m_windowBatch;
+    bool m_windowBatching;
     GLuint vao;
 };
 
@@ -181,8 +248,16 @@ public:
 
     WindowPixmap *createWindowPixmap() override;
     void performPaint(int mask, QRegion region, WindowPaintData data) override;
+    /**
+     * Adds the window to the @p batch instead of painting it right away.
+     * @returns @c false if the window cannot be painted as part of a batch
+     */
+    bool paintBatched(OpenGLWindowBatch *batch, int mask, const QRegion &region, WindowPaintData &data);
 
 private:
+    void renderWindow(int mask, const QRegion &region, WindowPaintData &data);
+    void splitQuads(const WindowQuadList &quads, WindowQuadList *leaves) const;
+    bool hasMappedSubSurfaces() const;
     QMatrix4x4 transformation(int mask, const WindowPaintData &data) const;
     GLTexture *getDecorationTexture() const;
     QMatrix4x4 modelViewProjectionMatrix(int mask, const WindowPaintData &data) const;
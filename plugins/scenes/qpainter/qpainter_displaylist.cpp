@@ -0,0 +1,439 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "qpainter_displaylist.h"
+
+#include <QTextItem>
+
+namespace KWin
+{
+
+/**
+ * Records the state changes and paint operations of a QPainter into the QPainterDisplayList.
+ */
+class QPainterDisplayListEngine : public QPaintEngine
+{
+public:
+    explicit QPainterDisplayListEngine(QPainterDisplayList *list)
+        : QPaintEngine(AllFeatures)
+        , m_list(list)
+    {
+    }
+
+    bool begin(QPaintDevice *device) override;
+    bool end() override;
+    void updateState(const QPaintEngineState &state) override;
+    Type type() const override {
+        return User;
+    }
+
+    void drawRects(const QRect *rects, int rectCount) override;
+    void drawRects(const QRectF *rects, int rectCount) override;
+    void drawLines(const QLine *lines, int lineCount) override;
+    void drawLines(const QLineF *lines, int lineCount) override;
+    void drawEllipse(const QRectF &r) override;
+    void drawPath(const QPainterPath &path) override;
+    void drawPoints(const QPointF *points, int pointCount) override;
+    void drawPoints(const QPoint *points, int pointCount) override;
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) override;
+    void drawPolygon(const QPoint *points, int pointCount, PolygonDrawMode mode) override;
+    void drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr) override;
+    void drawTiledPixmap(const QRectF &r, const QPixmap &pixmap, const QPointF &s) override;
+    void drawImage(const QRectF &r, const QImage &pm, const QRectF &sr, Qt::ImageConversionFlags flags) override;
+    void drawTextItem(const QPointF &p, const QTextItem &textItem) override;
+
+private:
+    QPainterDisplayList::Command &addCommand(QPainterDisplayList::Command::Type type);
+
+    QPainterDisplayList *m_list;
+    bool m_clipEnabled = false;
+    QVector<QPainterDisplayList::ClipOperation> m_clip;
+    QPointF m_brushOrigin;
+    bool m_stateDirty = true;
+};
+
+bool QPainterDisplayListEngine::begin(QPaintDevice *device)
+{
+    Q_UNUSED(device)
+    m_clipEnabled = false;
+    m_clip.clear();
+    m_brushOrigin = QPointF();
+    m_stateDirty = true;
+    setActive(true);
+    return true;
+}
+
+bool QPainterDisplayListEngine::end()
+{
+    setActive(false);
+    return true;
+}
+
+void QPainterDisplayListEngine::updateState(const QPaintEngineState &state)
+{
+    // Most of the state is taken from the painter when the next command is recorded, only
+    // the clip has to be tracked: the painter provides it as a sequence of operations, each
+    // one in the coordinate system which was active when the clip got set.
+    const DirtyFlags flags = state.state();
+    if (flags & (DirtyClipRegion | DirtyClipPath)) {
+        const Qt::ClipOperation operation = state.clipOperation();
+        if (operation == Qt::NoClip || operation == Qt::ReplaceClip) {
+            m_clip.clear();
+        }
+        if (operation != Qt::NoClip) {
+            QPainterDisplayList::ClipOperation clip;
+            clip.transform = state.transform();
+            clip.operation = operation;
+            clip.isPath = flags & DirtyClipPath;
+            if (clip.isPath) {
+                clip.path = state.clipPath();
+            } else {
+                clip.region = state.clipRegion();
+            }
+            m_clip << clip;
+        }
+    }
+    if (flags & DirtyClipEnabled) {
+        m_clipEnabled = state.isClipEnabled();
+    }
+    if (flags & DirtyBrushOrigin) {
+        m_brushOrigin = state.brushOrigin();
+    }
+    m_stateDirty = true;
+}
+
+QPainterDisplayList::Command &QPainterDisplayListEngine::addCommand(QPainterDisplayList::Command::Type type)
+{
+    if (m_stateDirty) {
+        const QPainter *p = painter();
+        QPainterDisplayList::State state;
+        state.transform = p->deviceTransform();
+        state.clipEnabled = m_clipEnabled && !m_clip.isEmpty();
+        state.clip = m_clip;
+        state.compositionMode = p->compositionMode();
+        state.opacity = p->opacity();
+        state.pen = p->pen();
+        state.brush = p->brush();
+        state.brushOrigin = m_brushOrigin;
+        state.background = p->background();
+        state.backgroundMode = p->backgroundMode();
+        state.renderHints = p->renderHints();
+        m_list->m_states << state;
+        m_stateDirty = false;
+    }
+    return m_list->addCommand(type);
+}
+
+void QPainterDisplayListEngine::drawRects(const QRect *rects, int rectCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Rects);
+    command.rects = QVector<QRect>(rects, rects + rectCount);
+}
+
+void QPainterDisplayListEngine::drawRects(const QRectF *rects, int rectCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::RectsF);
+    command.rectsF = QVector<QRectF>(rects, rects + rectCount);
+}
+
+void QPainterDisplayListEngine::drawLines(const QLine *lines, int lineCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Lines);
+    command.lines = QVector<QLine>(lines, lines + lineCount);
+}
+
+void QPainterDisplayListEngine::drawLines(const QLineF *lines, int lineCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::LinesF);
+    command.linesF = QVector<QLineF>(lines, lines + lineCount);
+}
+
+void QPainterDisplayListEngine::drawEllipse(const QRectF &r)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Ellipse);
+    command.rect = r;
+}
+
+void QPainterDisplayListEngine::drawPath(const QPainterPath &path)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Path);
+    command.path = path;
+}
+
+void QPainterDisplayListEngine::drawPoints(const QPointF *points, int pointCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::PointsF);
+    command.pointsF = QVector<QPointF>(points, points + pointCount);
+}
+
+void QPainterDisplayListEngine::drawPoints(const QPoint *points, int pointCount)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Points);
+    command.points = QVector<QPoint>(points, points + pointCount);
+}
+
+void QPainterDisplayListEngine::drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::PolygonF);
+    command.pointsF = QVector<QPointF>(points, points + pointCount);
+    command.polygonMode = mode;
+}
+
+void QPainterDisplayListEngine::drawPolygon(const QPoint *points, int pointCount, PolygonDrawMode mode)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Polygon);
+    command.points = QVector<QPoint>(points, points + pointCount);
+    command.polygonMode = mode;
+}
+
+void QPainterDisplayListEngine::drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Pixmap);
+    command.rect = r;
+    command.source = sr;
+    if (pm.depth() == 1) {
+        // bitmaps are painted with the pen, keep the pixmap
+        command.pixmap = pm;
+        m_list->m_needsMainThread = true;
+    } else {
+        // pixmaps must not be used outside the main thread, with the raster backend
+        // this is a shallow copy of the pixmap's image
+        command.image = pm.toImage();
+    }
+}
+
+void QPainterDisplayListEngine::drawTiledPixmap(const QRectF &r, const QPixmap &pixmap, const QPointF &s)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::TiledPixmap);
+    command.rect = r;
+    command.pixmap = pixmap;
+    command.position = s;
+    m_list->m_needsMainThread = true;
+}
+
+void QPainterDisplayListEngine::drawImage(const QRectF &r, const QImage &pm, const QRectF &sr, Qt::ImageConversionFlags flags)
+{
+    auto &command = addCommand(QPainterDisplayList::Command::Image);
+    command.rect = r;
+    command.image = pm;
+    command.source = sr;
+    command.conversionFlags = flags;
+}
+
+void QPainterDisplayListEngine::drawTextItem(const QPointF &p, const QTextItem &textItem)
+{
+    // The glyphs of a text item are laid out by Qt's text engine and can't be recorded without
+    // losing e.g. the glyph positions or the render flags. Instead the commands recorded so far
+    // are painted on the target and the text item is painted directly after them. The text
+    // command only carries the painter state the text item is painted with.
+    addCommand(QPainterDisplayList::Command::Text);
+    QImage *target = m_list->target();
+    QPainter targetPainter(target);
+    m_list->replay(&targetPainter, target->rect());
+    targetPainter.drawTextItem(p, textItem);
+    targetPainter.end();
+    m_list->clear();
+    m_stateDirty = true;
+}
+
+QPainterDisplayList::QPainterDisplayList()
+    : m_engine(new QPainterDisplayListEngine(this))
+{
+}
+
+QPainterDisplayList::~QPainterDisplayList() = default;
+
+void QPainterDisplayList::setTarget(QImage *target)
+{
+    m_target = target;
+}
+
+QPaintEngine *QPainterDisplayList::paintEngine() const
+{
+    return m_engine.data();
+}
+
+int QPainterDisplayList::metric(PaintDeviceMetric metric) const
+{
+    if (!m_target) {
+        return 0;
+    }
+    switch (metric) {
+    case PdmWidth:
+        return m_target->width();
+    case PdmHeight:
+        return m_target->height();
+    case PdmWidthMM:
+        return m_target->widthMM();
+    case PdmHeightMM:
+        return m_target->heightMM();
+    case PdmNumColors:
+        return m_target->colorCount();
+    case PdmDepth:
+        return m_target->depth();
+    case PdmDpiX:
+        return m_target->logicalDpiX();
+    case PdmDpiY:
+        return m_target->logicalDpiY();
+    case PdmPhysicalDpiX:
+        return m_target->physicalDpiX();
+    case PdmPhysicalDpiY:
+        return m_target->physicalDpiY();
+    case PdmDevicePixelRatio:
+        return m_target->devicePixelRatio();
+    case PdmDevicePixelRatioScaled:
+        return m_target->devicePixelRatioF() * devicePixelRatioFScale();
+    default:
+        return 0;
+    }
+}
+
+QPainterDisplayList::Command &QPainterDisplayList::addCommand(Command::Type type)
+{
+    Command command;
+    command.type = type;
+    command.state = m_states.count() - 1;
+    command.polygonMode = QPaintEngine::OddEvenMode;
+    command.conversionFlags = Qt::AutoColor;
+    m_commands << command;
+    return m_commands.last();
+}
+
+void QPainterDisplayList::clear()
+{
+    m_states.clear();
+    m_commands.clear();
+    m_needsMainThread = false;
+}
+
+void QPainterDisplayList::applyState(QPainter *painter, const State &state, const QRect &rect) const
+{
+    // the band is clipped in device coordinates, the recorded clip operations are
+    // intersected with it in the coordinate system they were set in
+    painter->setTransform(QTransform());
+    painter->setClipRect(rect);
+    if (state.clipEnabled) {
+        for (const ClipOperation &clip : state.clip) {
+            painter->setTransform(clip.transform);
+            if (clip.isPath) {
+                painter->setClipPath(clip.path, Qt::IntersectClip);
+            } else {
+                painter->setClipRegion(clip.region, Qt::IntersectClip);
+            }
+        }
+    }
+    painter->setTransform(state.transform);
+    painter->setCompositionMode(state.compositionMode);
+    painter->setOpacity(state.opacity);
+    painter->setPen(state.pen);
+    painter->setBrush(state.brush);
+    painter->setBrushOrigin(state.brushOrigin);
+    painter->setBackground(state.background);
+    painter->setBackgroundMode(state.backgroundMode);
+    painter->setRenderHints(~state.renderHints, false);
+    painter->setRenderHints(state.renderHints, true);
+}
+
+void QPainterDisplayList::replay(QPainter *painter, const QRect &rect) const
+{
+    int state = -1;
+    for (const Command &command : m_commands) {
+        if (command.state != state) {
+            state = command.state;
+            applyState(painter, m_states.at(state), rect);
+        }
+        switch (command.type) {
+        case Command::Rects:
+            painter->drawRects(command.rects);
+            break;
+        case Command::RectsF:
+            painter->drawRects(command.rectsF);
+            break;
+        case Command::Lines:
+            painter->drawLines(command.lines);
+            break;
+        case Command::LinesF:
+            painter->drawLines(command.linesF);
+            break;
+        case Command::Points:
+            painter->drawPoints(command.points.constData(), command.points.count());
+            break;
+        case Command::PointsF:
+            painter->drawPoints(command.pointsF.constData(), command.pointsF.count());
+            break;
+        case Command::Ellipse:
+            painter->drawEllipse(command.rect);
+            break;
+        case Command::Path:
+            painter->drawPath(command.path);
+            break;
+        case Command::Polygon:
+            switch (command.polygonMode) {
+            case QPaintEngine::PolylineMode:
+                painter->drawPolyline(command.points.constData(), command.points.count());
+                break;
+            case QPaintEngine::ConvexMode:
+                painter->drawConvexPolygon(command.points.constData(), command.points.count());
+                break;
+            case QPaintEngine::WindingMode:
+                painter->drawPolygon(command.points.constData(), command.points.count(), Qt::WindingFill);
+                break;
+            default:
+                painter->drawPolygon(command.points.constData(), command.points.count(), Qt::OddEvenFill);
+                break;
+            }
+            break;
+        case Command::PolygonF:
+            switch (command.polygonMode) {
+            case QPaintEngine::PolylineMode:
+                painter->drawPolyline(command.pointsF.constData(), command.pointsF.count());
+                break;
+            case QPaintEngine::ConvexMode:
+                painter->drawConvexPolygon(command.pointsF.constData(), command.pointsF.count());
+                break;
+            case QPaintEngine::WindingMode:
+                painter->drawPolygon(command.pointsF.constData(), command.pointsF.count(), Qt::WindingFill);
+                break;
+            default:
+                painter->drawPolygon(command.pointsF.constData(), command.pointsF.count(), Qt::OddEvenFill);
+                break;
+            }
+            break;
+        case Command::Image:
+            painter->drawImage(command.rect, command.image, command.source, command.conversionFlags);
+            break;
+        case Command::Pixmap:
+            if (command.pixmap.isNull()) {
+                painter->drawImage(command.rect, command.image, command.source);
+            } else {
+                painter->drawPixmap(command.rect, command.pixmap, command.source);
+            }
+            break;
+        case Command::TiledPixmap:
+            painter->drawTiledPixmap(command.rect, command.pixmap, command.position);
+            break;
+        case Command::Text:
+            // painted by the engine right after replaying
+            break;
+        }
+    }
+}
+
+}
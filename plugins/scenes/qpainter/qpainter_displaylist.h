@@ -0,0 +1,159 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_QPAINTER_DISPLAYLIST_H
+#define KWIN_QPAINTER_DISPLAYLIST_H
+
+#include <QImage>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPixmap>
+#include <QScopedPointer>
+#include <QVector>
+
+namespace KWin
+{
+
+class QPainterDisplayListEngine;
+
+/**
+ * The QPainterDisplayList is a paint device recording everything painted on it.
+ *
+ * The SceneQPainter paints a frame on the display list on the main thread, where the
+ * effects chain runs, and replays it afterwards on the real render buffer. As the
+ * recorded commands don't change while being replayed, the replay can be split into
+ * several horizontal bands of the buffer which are rasterized on worker threads.
+ *
+ * Replaying the commands results in the same pixels as painting directly on the
+ * buffer: every band is painted with the same transformation and clip as the buffer
+ * itself, only additionally clipped to the band.
+ */
+class QPainterDisplayList : public QPaintDevice
+{
+public:
+    QPainterDisplayList();
+    ~QPainterDisplayList() override;
+
+    /**
+     * The buffer the recorded commands are going to be replayed on, the display list
+     * has the same size and resolution.
+     */
+    void setTarget(QImage *target);
+    QImage *target() const {
+        return m_target;
+    }
+
+    QPaintEngine *paintEngine() const override;
+
+    /**
+     * Whether a recorded command can only be replayed on the main thread, e.g. pixmaps
+     * which are not allowed to be used from other threads.
+     *
+     * Text is not recorded at all: painting text replays the commands recorded so far on
+     * the target and paints the text directly on it.
+     */
+    bool needsMainThread() const {
+        return m_needsMainThread;
+    }
+    /**
+     * Replays the recorded commands on @p painter, clipped to @p rect in device coordinates.
+     * The @p painter has to paint on the target or an image with the same layout.
+     */
+    void replay(QPainter *painter, const QRect &rect) const;
+    /**
+     * Drops all recorded commands, including the references to the painted images.
+     */
+    void clear();
+
+protected:
+    int metric(PaintDeviceMetric metric) const override;
+
+private:
+    friend class QPainterDisplayListEngine;
+
+    struct ClipOperation {
+        QTransform transform;
+        Qt::ClipOperation operation;
+        QRegion region;
+        QPainterPath path;
+        bool isPath;
+    };
+    struct State {
+        QTransform transform;
+        bool clipEnabled;
+        QVector<ClipOperation> clip;
+        QPainter::CompositionMode compositionMode;
+        qreal opacity;
+        QPen pen;
+        QBrush brush;
+        QPointF brushOrigin;
+        QBrush background;
+        Qt::BGMode backgroundMode;
+        QPainter::RenderHints renderHints;
+    };
+    struct Command {
+        enum Type {
+            Rects,
+            RectsF,
+            Lines,
+            LinesF,
+            Points,
+            PointsF,
+            Ellipse,
+            Path,
+            Polygon,
+            PolygonF,
+            Image,
+            Pixmap,
+            TiledPixmap,
+            Text
+        };
+        Type type;
+        int state;
+        QVector<QRect> rects;
+        QVector<QRectF> rectsF;
+        QVector<QLine> lines;
+        QVector<QLineF> linesF;
+        QVector<QPoint> points;
+        QVector<QPointF> pointsF;
+        QPaintEngine::PolygonDrawMode polygonMode;
+        QPainterPath path;
+        QRectF rect;
+        QRectF source;
+        QPointF position;
+        QImage image;
+        QPixmap pixmap;
+        Qt::ImageConversionFlags conversionFlags;
+    };
+    Command &addCommand(Command::Type type);
+    void applyState(QPainter *painter, const State &state, const QRect &rect) const;
+
+    QScopedPointer<QPainterDisplayListEngine> m_engine;
+    QImage *m_target = nullptr;
+    QVector<State> m_states;
+    QVector<Command> m_commands;
+    bool m_needsMainThread = false;
+};
+
+}
+
+#endif
@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter.h"
+#include "qpainter_displaylist.h"
 // KWin
 #include "x11client.h"
 #include "composite.h"
@@ -39,13 +40,58 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QDebug>
 #include <QPainter>
+#include <QRunnable>
+#include <QThread>
 #include <KDecoration2/Decoration>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace KWin
 {
 
+// Bands rasterized in parallel are not made smaller than this many scanlines.
+static const int s_minimumBandHeight = 32;
+
+static int renderThreadCount()
+{
+    bool ok = false;
+    const int count = qEnvironmentVariableIntValue("KWIN_QPAINTER_RENDER_THREADS", &ok);
+    if (ok) {
+        return qMax(1, count);
+    }
+    return qBound(1, QThread::idealThreadCount(), 4);
+}
+
+/**
+ * Rasterizes one horizontal band of a recorded frame.
+ */
+class QPainterBandRenderer : public QRunnable
+{
+public:
+    QPainterBandRenderer(const QPainterDisplayList *list, const QImage &target, const QRect &band, QSemaphore *done)
+        : m_list(list)
+        , m_target(target)
+        , m_band(band)
+        , m_done(done)
+    {
+    }
+
+    void run() override {
+        QPainter painter(&m_target);
+        m_list->replay(&painter, m_band);
+        painter.end();
+        m_done->release();
+    }
+
+private:
+    const QPainterDisplayList *m_list;
+    QImage m_target;
+    QRect m_band;
+    QSemaphore *m_done;
+};
+
 //****************************************
 // SceneQPainter
 //****************************************
@@ -66,10 +112,13 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+    m_renderPool.setMaxThreadCount(renderThreadCount());
 }
 
 SceneQPainter::~SceneQPainter()
 {
+    m_renderPool.waitForDone();
+    qDeleteAll(m_displayLists);
 }
 
 CompositingType SceneQPainter::compositingType() const
@@ -101,34 +150,40 @@ qint64 SceneQPainter::paint(QRegion damage, QList<Toplevel *> toplevels)
     int mask = 0;
     m_backend->prepareRenderingFrame();
     if (m_backend->perScreenRendering()) {
-        const bool needsFullRepaint = m_backend->needsFullRepaint();
-        if (needsFullRepaint) {
-            mask |= Scene::PAINT_SCREEN_BACKGROUND_FIRST;
-            damage = screens()->geometry();
-        }
         QRegion overallUpdate;
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect geometry = screens()->geometry(i);
+            if (!damage.intersects(geometry)) {
+                // nothing changed on this screen, don't render and present it
+                continue;
+            }
             QImage *buffer = m_backend->bufferForScreen(i);
             if (!buffer || buffer->isNull()) {
                 continue;
             }
-            m_painter->begin(buffer);
+            // every screen has its own buffer, so whether it has to be repainted in full
+            // is decided per screen
+            const bool needsFullRepaint = m_backend->needsFullRepaintForScreen(i);
+            int screenMask = needsFullRepaint ? Scene::PAINT_SCREEN_BACKGROUND_FIRST : 0;
+            beginPaint(buffer, i);
             m_painter->save();
             m_painter->setWindow(geometry);
 
+            const QRegion screenDamage = needsFullRepaint ? QRegion(geometry) : damage.intersected(geometry);
             QRegion updateRegion, validRegion;
-            paintScreen(&mask, damage.intersected(geometry), QRegion(), &updateRegion, &validRegion);
+            paintScreen(&screenMask, screenDamage, QRegion(), &updateRegion, &validRegion, QMatrix4x4(), geometry);
+            mask |= screenMask;
             overallUpdate = overallUpdate.united(updateRegion);
             paintCursor();
 
             m_painter->restore();
-            m_painter->end();
+            endPaint();
         }
+        finishRendering();
         m_backend->showOverlay();
         m_backend->present(mask, overallUpdate);
     } else {
-        m_painter->begin(m_backend->buffer());
+        beginPaint(m_backend->buffer(), 0);
         m_painter->setClipping(true);
         m_painter->setClipRegion(damage);
         if (m_backend->needsFullRepaint()) {
@@ -139,20 +194,115 @@ qint64 SceneQPainter::paint(QRegion damage, QList<Toplevel *> toplevels)
         paintScreen(&mask, damage, QRegion(), &updateRegion, &validRegion);
 
         paintCursor();
-        m_backend->showOverlay();
+        endPaint();
+        finishRendering();
 
-        m_painter->end();
+        m_backend->showOverlay();
         m_backend->present(mask, updateRegion);
     }
 
     // do cleanup
     clearStackingOrder();
+    releaseScratchImages();
 
     emit frameRendered();
 
     return renderTimer.nsecsElapsed();
 }
 
+bool SceneQPainter::perScreenRendering() const
+{
+    return m_backend->perScreenRendering();
+}
+
+bool SceneQPainter::isParallelRendering() const
+{
+    return m_renderPool.maxThreadCount() > 1;
+}
+
+void SceneQPainter::beginPaint(QImage *target, int index)
+{
+    if (!isParallelRendering()) {
+        m_painter->begin(target);
+        return;
+    }
+    while (m_displayLists.count() <= index) {
+        m_displayLists << new QPainterDisplayList;
+    }
+    m_currentDisplayList = m_displayLists.at(index);
+    m_currentDisplayList->setTarget(target);
+    m_painter->begin(m_currentDisplayList);
+}
+
+void SceneQPainter::endPaint()
+{
+    m_painter->end();
+    QPainterDisplayList *list = m_currentDisplayList;
+    if (!list) {
+        return;
+    }
+    m_currentDisplayList = nullptr;
+    QImage *target = list->target();
+    if (list->needsMainThread()) {
+        QPainter painter(target);
+        list->replay(&painter, target->rect());
+        return;
+    }
+    // The bands span the complete width of the buffer, that way every scanline is
+    // rasterized exactly like it is without splitting the buffer.
+    const int bandCount = qBound(1, target->height() / s_minimumBandHeight, m_renderPool.maxThreadCount() * 2);
+    const int bandHeight = (target->height() + bandCount - 1) / bandCount;
+    uchar *bits = target->bits();
+    for (int y = 0; y < target->height(); y += bandHeight) {
+        // every thread needs its own image, they all share the memory of the buffer
+        QImage image(bits, target->width(), target->height(), target->bytesPerLine(), target->format());
+        image.setDotsPerMeterX(target->dotsPerMeterX());
+        image.setDotsPerMeterY(target->dotsPerMeterY());
+        const QRect band(0, y, target->width(), qMin(bandHeight, target->height() - y));
+        m_renderPool.start(new QPainterBandRenderer(list, image, band, &m_renderedBands));
+        ++m_pendingBands;
+    }
+}
+
+QImage *SceneQPainter::scratchImage(const QSize &size)
+{
+    // An image still referenced by a recorded frame would be copied when painting on it.
+    for (ScratchImage &scratch : m_scratchImages) {
+        if (!scratch.used && scratch.image.isDetached()
+                && scratch.image.width() >= size.width() && scratch.image.height() >= size.height()) {
+            scratch.used = true;
+            return &scratch.image;
+        }
+    }
+    m_scratchImages.push_back({QImage(size, QImage::Format_ARGB32_Premultiplied), true});
+    return &m_scratchImages.back().image;
+}
+
+void SceneQPainter::releaseScratchImages()
+{
+    // keep the images used in this frame for the next one, e.g. while a window fades
+    auto it = std::remove_if(m_scratchImages.begin(), m_scratchImages.end(), [](const ScratchImage &scratch) {
+        return !scratch.used;
+    });
+    m_scratchImages.erase(it, m_scratchImages.end());
+    for (ScratchImage &scratch : m_scratchImages) {
+        scratch.used = false;
+    }
+}
+
+void SceneQPainter::finishRendering()
+{
+    if (!isParallelRendering()) {
+        return;
+    }
+    m_renderedBands.acquire(m_pendingBands);
+    m_pendingBands = 0;
+    // drop the references to the painted images, otherwise they would be copied on the next update
+    for (QPainterDisplayList *list : qAsConst(m_displayLists)) {
+        list->clear();
+    }
+}
+
 void SceneQPainter::paintBackground(QRegion region)
 {
     m_painter->setBrush(Qt::black);
@@ -272,14 +422,23 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
     }
 
     const bool opaque = qFuzzyCompare(1.0, data.opacity());
-    QImage tempImage;
+    // If the parts of the window don't overlap each other, they can be blended directly with
+    // the window's opacity. Otherwise they are composed in an intermediate image first, so that
+    // e.g. the shadow doesn't shine through the content.
+    const bool needsIntermediate = !opaque && hasOverlappingLayers(pixmap);
+    if (!opaque && !needsIntermediate) {
+        painter->setOpacity(painter->opacity() * data.opacity());
+    }
+    const QSize intermediateSize = toplevel->visibleRect().size();
+    QImage *tempImage = nullptr;
     QPainter tempPainter;
-    if (!opaque) {
+    if (needsIntermediate) {
         // need a temp render target which we later on blit to the screen
-        tempImage = QImage(toplevel->visibleRect().size(), QImage::Format_ARGB32_Premultiplied);
-        tempImage.fill(Qt::transparent);
-        tempPainter.begin(&tempImage);
-        tempPainter.save();
+        tempImage = m_scene->scratchImage(intermediateSize);
+        tempPainter.begin(tempImage);
+        tempPainter.setCompositionMode(QPainter::CompositionMode_Source);
+        tempPainter.fillRect(QRect(QPoint(0, 0), intermediateSize), Qt::transparent);
+        tempPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
         tempPainter.translate(toplevel->frameGeometry().topLeft() - toplevel->visibleRect().topLeft());
         painter = &tempPainter;
     }
@@ -308,20 +467,30 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
         paintSubSurface(painter, bufferOffset(), static_cast<QPainterWindowPixmap*>(pixmap));
     }
 
-    if (!opaque) {
-        tempPainter.restore();
-        tempPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-        QColor translucent(Qt::transparent);
-        translucent.setAlphaF(data.opacity());
-        tempPainter.fillRect(QRect(QPoint(0, 0), toplevel->visibleRect().size()), translucent);
+    if (needsIntermediate) {
         tempPainter.end();
         painter = scenePainter;
-        painter->drawImage(toplevel->visibleRect().topLeft() - toplevel->frameGeometry().topLeft(), tempImage);
+        painter->setOpacity(painter->opacity() * data.opacity());
+        painter->drawImage(QRect(toplevel->visibleRect().topLeft() - toplevel->frameGeometry().topLeft(), intermediateSize),
+                           *tempImage, QRect(QPoint(0, 0), intermediateSize));
     }
 
     painter->restore();
 }
 
+bool SceneQPainter::Window::hasOverlappingLayers(QPainterWindowPixmap *pixmap) const
+{
+    // the decoration surrounds the content, only the shadow and sub-surfaces overlap them
+    if (toplevel->shadow()) {
+        return true;
+    }
+    const auto &children = pixmap->children();
+    return std::any_of(children.begin(), children.end(), [](WindowPixmap *child) {
+        return !child->subSurface().isNull() && !child->subSurface()->surface().isNull()
+            && child->subSurface()->surface()->isMapped();
+    });
+}
+
 void SceneQPainter::Window::renderShadow(QPainter* painter)
 {
     if (!toplevel->shadow()) {
@@ -439,7 +608,8 @@ void QPainterWindowPixmap::updateBuffer()
     const auto oldBuffer = buffer();
     WindowPixmap::updateBuffer();
     const auto &b = buffer();
-    if (!surface()) {
+    auto s = surface();
+    if (!s) {
         // That's an internal client.
         m_image = internalImage();
         return;
@@ -448,14 +618,44 @@ void QPainterWindowPixmap::updateBuffer()
         m_image = QImage();
         return;
     }
-    if (b == oldBuffer) {
+    const QRegion damage = s->trackedDamage();
+    s->resetTrackedDamage();
+    if (b == oldBuffer && damage.isEmpty()) {
         return;
     }
-    // perform deep copy
-    m_image = b->data().copy();
-    if (auto s = surface()) {
-        s->resetTrackedDamage();
+    // The data of a shm buffer can only be accessed while no other shm buffer is accessed,
+    // so the image cannot reference it beyond this call. Instead the image is kept and only
+    // the parts of the buffer damaged since the last update are copied into it.
+    const QImage &data = b->data();
+    if (data.isNull() || !updateImage(data, damage, s->scale())) {
+        // perform deep copy
+        m_image = data.copy();
+    }
+}
+
+bool QPainterWindowPixmap::updateImage(const QImage &data, const QRegion &damage, qint32 scale)
+{
+    if (m_image.size() != data.size() || m_image.format() != data.format() || data.depth() % 8) {
+        return false;
     }
+    const int bytesPerPixel = data.depth() / 8;
+    const QRect bounds = m_image.rect();
+    uchar *bits = m_image.bits();
+    const int bytesPerLine = m_image.bytesPerLine();
+    // damage is in surface local coordinates, the buffer might be scaled
+    for (const QRect &rect : damage) {
+        const QRect r = QRect(rect.x() * scale, rect.y() * scale,
+                              rect.width() * scale, rect.height() * scale) & bounds;
+        if (r.isEmpty()) {
+            continue;
+        }
+        const int offset = r.x() * bytesPerPixel;
+        const int length = r.width() * bytesPerPixel;
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            memcpy(bits + y * bytesPerLine + offset, data.constScanLine(y) + offset, length);
+        }
+    }
+    return true;
 }
 
 bool QPainterWindowPixmap::isValid() const
@@ -32,8 +32,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "decorations/decorationrenderer.h"
 
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <deque>
+
 namespace KWin {
 
+class QPainterDisplayList;
+
 class UKUI_KWIN_EXPORT SceneQPainter : public Scene
 {
     Q_OBJECT
@@ -50,6 +57,7 @@ public:
     Shadow *createShadow(Toplevel *toplevel) override;
     Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *impl) override;
     void screenGeometryChanged(const QSize &size) override;
+    bool perScreenRendering() const override;
 
     bool animationsSupported() const override {
         return false;
@@ -72,8 +80,43 @@ protected:
 
 private:
     explicit SceneQPainter(QPainterBackend *backend, QObject *parent = nullptr);
+    /**
+     * Starts painting the @p index-th buffer of the frame on @p target.
+     * With parallel rendering the painting is recorded and rasterized later on.
+     */
+    void beginPaint(QImage *target, int index);
+    /**
+     * Finishes painting the buffer, with parallel rendering the recorded frame is
+     * handed over to the render threads.
+     */
+    void endPaint();
+    /**
+     * Waits until all buffers of the frame are rasterized.
+     */
+    void finishRendering();
+    bool isParallelRendering() const;
+    /**
+     * Returns an image of at least @p size which can be used as an intermediate render target
+     * while painting the current frame. The content of the image is undefined.
+     */
+    QImage *scratchImage(const QSize &size);
+    /**
+     * Frees the images not used as intermediate render target in the current frame.
+     */
+    void releaseScratchImages();
     QScopedPointer<QPainterBackend> m_backend;
     QScopedPointer<QPainter> m_painter;
+    QVector<QPainterDisplayList *> m_displayLists;
+    QPainterDisplayList *m_currentDisplayList = nullptr;
+    QThreadPool m_renderPool;
+    QSemaphore m_renderedBands;
+    int m_pendingBands = 0;
+    struct ScratchImage {
+        QImage image;
+        bool used;
+    };
+    // a deque doesn't move its elements when growing, the images are painted on while more get added
+    std::deque<ScratchImage> m_scratchImages;
     class Window;
 };
 
@@ -88,6 +131,7 @@ protected:
 private:
     void renderShadow(QPainter *painter);
     void renderWindowDecorations(QPainter *painter);
+    bool hasOverlappingLayers(QPainterWindowPixmap *pixmap) const;
     SceneQPainter *m_scene;
 };
 
@@ -106,6 +150,11 @@ protected:
     WindowPixmap *createChild(const QPointer<KWayland::Server::SubSurfaceInterface> &subSurface) override;
 private:
     explicit QPainterWindowPixmap(const QPointer<KWayland::Server::SubSurfaceInterface> &subSurface, WindowPixmap *parent);
+    /**
+     * Copies the @p damage of the buffer @p data into the image.
+     * @returns @c false if the image cannot be reused for the buffer
+     */
+    bool updateImage(const QImage &data, const QRegion &damage, qint32 scale);
     QImage m_image;
 };
 
@@ -72,19 +72,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector2D>
 
 #include "x11client.h"
+#include "composite.h"
 #include "deleted.h"
 #include "effects.h"
+#include "main.h"
 #include "overlaywindow.h"
 #include "screens.h"
 #include "shadow.h"
+#include "virtualdesktops.h"
 #include "wayland_server.h"
 
+#include "effects/desktopgrid/desktoprendercache.h"
 #include "thumbnailitem.h"
 
 #include <KWayland/Server/buffer_interface.h>
 #include <KWayland/Server/subcompositor_interface.h>
 #include <KWayland/Server/surface_interface.h>
 
+#include <KConfigGroup>
+
 namespace KWin
 {
 
@@ -140,6 +146,7 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
 
     painted_region = region;
     repaint_region = repaint;
+    m_outputGeometry = outputGeometry;
 
     if (*mask & PAINT_SCREEN_BACKGROUND_FIRST) {
         paintBackground(region);
@@ -160,6 +167,7 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
 
     repaint_region = QRegion();
     damaged_region = QRegion();
+    m_outputGeometry = QRect();
 
     // make sure all clipping is restored
     Q_ASSERT(!PaintClipper::clip());
@@ -209,17 +217,16 @@ void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
     QVector<Phase2Data> phase2;
     phase2.reserve(stacking_order.size());
     foreach (Window * w, stacking_order) { // bottom to top
-        Toplevel* topw = w->window();
-
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
-        topw->resetRepaints();
+        const QRegion repaints = takeRepaints(w);
 
         WindowPrePaintData data;
         data.mask = orig_mask | (w->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         w->resetPaintingEnabled();
         data.paint = infiniteRegion(); // no clipping, so doesn't really matter
+        data.damage = repaints;
         data.clip = QRegion();
         data.quads = w->buildQuads();
         // preparation step
@@ -264,12 +271,12 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         window->resetPaintingEnabled();
         data.paint = region;
-        data.paint |= toplevel->repaints();
 
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
-        toplevel->resetRepaints();
+        data.damage = takeRepaints(window);
+        data.paint |= data.damage;
 
         // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
         opaqueFullscreen = false; // TODO: do we care about unmanged windows here (maybe input windows?)
@@ -384,6 +391,32 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     }
 }
 
+QRegion Scene::takeRepaints(Window *window)
+{
+    Toplevel *toplevel = window->window();
+    const QRegion repaints = toplevel->repaints();
+    toplevel->resetRepaints();
+    if (!repaints.isEmpty()) {
+        // Only one output is painted right now. The repaints on the other outputs go back
+        // to the compositor, otherwise these outputs would never repaint the area.
+        if (m_outputGeometry.isValid()) {
+            const QRegion otherOutputs = repaints - m_outputGeometry;
+            if (!otherOutputs.isEmpty()) {
+                Compositor::self()->addRepaint(otherOutputs);
+            }
+        }
+        window->addRepaints(repaints);
+    }
+    return window->takeRepaints(m_outputGeometry);
+}
+
+void Scene::addWindowRepaints(Toplevel *toplevel, const QRegion &repaints)
+{
+    if (Window *window = m_windows.value(toplevel)) {
+        window->addRepaints(repaints);
+    }
+}
+
 void Scene::addToplevel(Toplevel *c)
 {
     Q_ASSERT(!m_windows.contains(c));
@@ -391,6 +424,24 @@ void Scene::addToplevel(Toplevel *c)
     m_windows[ c ] = w;
     connect(c, SIGNAL(geometryShapeChanged(KWin::Toplevel*,QRect)), SLOT(windowGeometryShapeChanged(KWin::Toplevel*)));
     connect(c, SIGNAL(windowClosed(KWin::Toplevel*,KWin::Deleted*)), SLOT(windowClosed(KWin::Toplevel*,KWin::Deleted*)));
+    // the cached desktop thumbnails showing the window become outdated
+    const auto invalidateDesktopThumbnails = [this, c] {
+        this->invalidateDesktopThumbnails(c);
+    };
+    connect(c, &Toplevel::needsRepaint, this, invalidateDesktopThumbnails);
+    connect(c, &Toplevel::opacityChanged, this, invalidateDesktopThumbnails);
+    connect(c, &Toplevel::windowShown, this, invalidateDesktopThumbnails);
+    connect(c, &Toplevel::windowHidden, this, invalidateDesktopThumbnails);
+    if (AbstractClient *client = qobject_cast<AbstractClient *>(c)) {
+        connect(client, &AbstractClient::minimizedChanged, this, invalidateDesktopThumbnails);
+        connect(client, &AbstractClient::desktopChanged, this,
+            [this] {
+                if (m_desktopThumbnailCache) {
+                    m_desktopThumbnailCache->invalidateAll();
+                }
+            }
+        );
+    }
     //A change of scale won't affect the geometry in compositor co-ordinates, but will affect the window quads.
     if (c->surface()) {
         connect(c->surface(), &KWayland::Server::SurfaceInterface::scaleChanged, this, std::bind(&Scene::windowGeometryShapeChanged, this, c));
@@ -439,6 +490,7 @@ void Scene::windowGeometryShapeChanged(Toplevel *c)
         return;
     Window *w = m_windows[ c ];
     w->discardShape();
+    invalidateDesktopThumbnails(c);
 }
 
 void Scene::createStackingOrder(QList<Toplevel *> toplevels)
@@ -562,6 +614,11 @@ void Scene::paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacit
 void Scene::paintDesktopThumbnails(Scene::Window *w)
 {
     EffectWindowImpl *wImpl = static_cast<EffectWindowImpl*>(effectWindow(w));
+    if (wImpl->desktopThumbnails().isEmpty()) {
+        return;
+    }
+    // thumbnails inside of thumbnails are not painted at their item's position
+    const bool useCache = !s_recursionCheck && prepareDesktopThumbnailCache();
     for (QList<DesktopThumbnailItem*>::const_iterator it = wImpl->desktopThumbnails().constBegin();
             it != wImpl->desktopThumbnails().constEnd();
             ++it) {
@@ -572,7 +629,6 @@ void Scene::paintDesktopThumbnails(Scene::Window *w)
         if (!item->window()) {
             continue;
         }
-        s_recursionCheck = w;
 
         ScreenPaintData data;
         const QSize &screenSize = screens()->size();
@@ -588,11 +644,74 @@ void Scene::paintDesktopThumbnails(Scene::Window *w)
         QRegion clippingRegion = region;
         clippingRegion &= QRegion(wImpl->x(), wImpl->y(), wImpl->width(), wImpl->height());
         adjustClipRegion(item, clippingRegion);
+
+        // a clipped thumbnail can't be copied as a whole
+        const QRect geometry = QRectF(x, y, size.width(), size.height()).toAlignedRect();
+        const int screen = screens()->number(geometry.center());
+        const bool cached = useCache && (QRegion(geometry) - clippingRegion).isEmpty();
+        if (cached && m_desktopThumbnailCache->isValid(item->desktop(), screen, geometry, 1.0)) {
+            m_desktopThumbnailCache->render(item->desktop(), screen, screenProjectionMatrix());
+            continue;
+        }
+
+        s_recursionCheck = w;
         data += QPointF(x, y);
         const int desktopMask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
         paintDesktop(item->desktop(), desktopMask, clippingRegion, data);
         s_recursionCheck = nullptr;
+        if (cached) {
+            m_desktopThumbnailCache->capture(item->desktop(), screen, geometry, 1.0);
+        }
+    }
+}
+
+bool Scene::prepareDesktopThumbnailCache()
+{
+    // Effects taking part in painting the screen would have their painting captured as well.
+    if (!DesktopRenderCache::supported() || static_cast<EffectsHandlerImpl*>(effects)->hasPaintScreenEffects()) {
+        return false;
     }
+    if (!m_desktopThumbnailCache) {
+        const KConfigGroup config(kwinApp()->config(), "Compositing");
+        m_desktopThumbnailCache.reset(new DesktopRenderCache);
+        m_desktopThumbnailCache->setBudget(qint64(config.readEntry("DesktopThumbnailCacheMemory", 32)) * 1024 * 1024,
+                                           qBound(10, config.readEntry("DesktopThumbnailCacheResolution", 100), 100) / 100.0);
+    }
+    if (m_desktopThumbnailStackingOrder != stacking_order) {
+        m_desktopThumbnailStackingOrder = stacking_order;
+        m_desktopThumbnailCache->invalidateAll();
+    }
+    // windows animated by effects change without being damaged
+    for (Window *window : qAsConst(stacking_order)) {
+        const EffectWindowImpl *w = window->window()->effectWindow();
+        if (w->isDeleted() || w->data(WindowAddedGrabRole).value<void *>() || w->data(WindowClosedGrabRole).value<void *>()) {
+            invalidateDesktopThumbnails(window->window());
+        }
+    }
+    return true;
+}
+
+void Scene::invalidateDesktopThumbnails(Toplevel *toplevel)
+{
+    if (!m_desktopThumbnailCache) {
+        return;
+    }
+    // The thumbnails are painted on top of the window hosting them, which shows through
+    // translucent parts of the desktops.
+    const EffectWindowImpl *w = toplevel->effectWindow();
+    if (toplevel->isOnAllDesktops() || (w && !w->desktopThumbnails().isEmpty())) {
+        m_desktopThumbnailCache->invalidateAll();
+        return;
+    }
+    const auto desktops = toplevel->desktops();
+    for (const VirtualDesktop *desktop : desktops) {
+        m_desktopThumbnailCache->invalidate(desktop->x11DesktopNumber());
+    }
+}
+
+void Scene::releaseDesktopThumbnailCache()
+{
+    m_desktopThumbnailCache.reset();
 }
 
 void Scene::paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data)
@@ -631,6 +750,11 @@ bool Scene::syncsToVBlank() const
     return false;
 }
 
+bool Scene::perScreenRendering() const
+{
+    return false;
+}
+
 void Scene::screenGeometryChanged(const QSize &size)
 {
     if (!overlayWindow()) {
@@ -698,6 +822,35 @@ Scene::Window::~Window()
     delete m_shadow;
 }
 
+static QRegion outputsRegion()
+{
+    QRegion outputs;
+    for (int i = 0; i < screens()->count(); ++i) {
+        outputs += screens()->geometry(i);
+    }
+    return outputs;
+}
+
+void Scene::Window::addRepaints(const QRegion &region)
+{
+    // Repaints outside of all outputs would never be taken by an output
+    m_repaints += region & outputsRegion();
+}
+
+QRegion Scene::Window::takeRepaints(const QRect &output)
+{
+    if (!output.isValid()) {
+        const QRegion repaints = m_repaints;
+        m_repaints = QRegion();
+        return repaints;
+    }
+    // the repaints on the other outputs stay until these outputs get painted,
+    // the ones of outputs which went away are dropped
+    const QRegion repaints = m_repaints & output;
+    m_repaints = (m_repaints - output) & outputsRegion();
+    return repaints;
+}
+
 void Scene::Window::referencePreviousPixmap()
 {
     if (!m_previousPixmap.isNull() && m_previousPixmap->isDiscarded()) {
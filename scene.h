@@ -56,6 +56,7 @@ class Renderer;
 
 class AbstractThumbnailItem;
 class Deleted;
+class DesktopRenderCache;
 class EffectFrameImpl;
 class EffectWindowImpl;
 class OverlayWindow;
@@ -153,6 +154,12 @@ public:
     virtual void idle();
     virtual bool blocksForRetrace() const;
     virtual bool syncsToVBlank() const;
+    /**
+     * Whether the Scene renders and presents every screen individually. In that case
+     * screens without damage are skipped by paint() and the Compositor drives every
+     * output with its own frame scheduler.
+     */
+    virtual bool perScreenRendering() const;
     virtual OverlayWindow* overlayWindow() const = 0;
 
     virtual bool makeOpenGLContextCurrent();
@@ -204,6 +211,12 @@ public:
      */
     virtual QVector<QByteArray> openGLPlatformInterfaceExtensions() const;
 
+    /**
+     * Remembers the @p repaints of @p toplevel which the compositor handed to the outputs,
+     * so that the effects get to know the window's own damage when it gets painted.
+     */
+    void addWindowRepaints(Toplevel *toplevel, const QRegion &repaints);
+
 Q_SIGNALS:
     void frameRendered();
     void resetCompositing();
@@ -222,6 +235,8 @@ protected:
                      QRegion *updateRegion, QRegion *validRegion, const QMatrix4x4 &projection = QMatrix4x4(), const QRect &outputGeometry = QRect());
     // Render cursor texture in case hardware cursor is disabled/non-applicable
     virtual void paintCursor() = 0;
+    // releases the textures of cached desktop thumbnails, the OpenGL context has to be current
+    void releaseDesktopThumbnailCache();
     friend class EffectsHandlerImpl;
     // called after all effects had their paintScreen() called
     void finalPaintScreen(int mask, QRegion region, ScreenPaintData& data);
@@ -265,15 +280,26 @@ protected:
     QRegion repaint_region;
     // The dirty region before it was unioned with repaint_region
     QRegion damaged_region;
+    // The output painted by paintScreen(), invalid if all outputs are painted at once
+    QRect m_outputGeometry;
     // time since last repaint
     int time_diff;
     QElapsedTimer last_time;
 private:
+    // takes the repaints of the window which are on the output painted right now
+    QRegion takeRepaints(Window *window);
     void paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacity, qreal brightness, qreal saturation);
     void paintDesktopThumbnails(Scene::Window *w);
+    // whether desktop thumbnails can be drawn from the cache in the current frame
+    bool prepareDesktopThumbnailCache();
+    // drops the cached thumbnails of the desktops the window is on
+    void invalidateDesktopThumbnails(Toplevel *toplevel);
     QHash< Toplevel*, Window* > m_windows;
     // windows in their stacking order
     QVector< Window* > stacking_order;
+    QScopedPointer<DesktopRenderCache> m_desktopThumbnailCache;
+    // the stacking order the cached desktop thumbnails were painted with
+    QVector< Window* > m_desktopThumbnailStackingOrder;
 };
 
 /**
@@ -353,6 +379,9 @@ public:
     void referencePreviousPixmap();
     void unreferencePreviousPixmap();
     void invalidateQuadsCache();
+    // repaints of the window which went to the outputs but were not painted yet
+    void addRepaints(const QRegion &region);
+    QRegion takeRepaints(const QRect &output);
 protected:
     WindowQuadList makeDecorationQuads(const QRect *rects, const QRegion &region, qreal textureScale = 1.0) const;
     WindowQuadList makeContentsQuads() const;
@@ -391,6 +420,7 @@ private:
     mutable QRegion m_bufferShape;
     mutable bool m_bufferShapeIsValid = false;
     mutable QScopedPointer<WindowQuadList> cached_quad_list;
+    QRegion m_repaints;
     Q_DISABLE_COPY(Window)
 };
 
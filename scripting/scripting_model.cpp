@@ -184,64 +184,104 @@ void ClientLevel::addClient(AbstractClient *client)
     if (containsClient(client)) {
         return;
     }
-    emit beginInsert(m_clients.count(), m_clients.count(), id());
-    m_clients.insert(nextId(), client);
+    emit beginInsert(m_ids.count(), m_ids.count(), id());
+    insertClients({client});
     emit endInsert();
 }
 
-void ClientLevel::removeClient(AbstractClient *client)
+void ClientLevel::insertClients(const QVector<AbstractClient*> &clients)
 {
-    int index = 0;
-    auto it = m_clients.begin();
-    for (; it != m_clients.end(); ++it, ++index) {
-        if (it.value() == client) {
-            break;
-        }
+    m_ids.reserve(m_ids.count() + clients.count());
+    for (AbstractClient *client : clients) {
+        const quint32 clientId = nextId();
+        m_rows.insert(clientId, m_ids.count());
+        m_ids.append(clientId);
+        m_clients.insert(clientId, client);
+        m_clientIds.insert(client, clientId);
     }
-    if (it == m_clients.end()) {
+}
+
+void ClientLevel::removeClient(AbstractClient *client)
+{
+    auto it = m_clientIds.find(client);
+    if (it == m_clientIds.end()) {
         return;
     }
-    emit beginRemove(index, index, id());
-    m_clients.erase(it);
+    const quint32 clientId = it.value();
+    const int row = m_rows.value(clientId);
+    emit beginRemove(row, row, id());
+    m_clientIds.erase(it);
+    m_clients.remove(clientId);
+    m_rows.remove(clientId);
+    m_ids.remove(row);
+    // the rows below the removed Client move up by one
+    for (int i = row; i < m_ids.count(); ++i) {
+        m_rows[m_ids.at(i)] = i;
+    }
     emit endRemove();
 }
 
 void ClientLevel::init()
 {
-    const QList<X11Client *> &clients = Workspace::self()->clientList();
-    for (auto it = clients.begin(); it != clients.end(); ++it) {
+    QVector<AbstractClient*> clients;
+    const QList<X11Client *> &x11Clients = Workspace::self()->clientList();
+    for (auto it = x11Clients.begin(); it != x11Clients.end(); ++it) {
         X11Client *client = *it;
         setupClientConnections(client);
         if (!exclude(client) && shouldAdd(client)) {
-            m_clients.insert(nextId(), client);
+            clients << client;
         }
     }
+    if (waylandServer()) {
+        const auto &shellClients = waylandServer()->clients();
+        for (auto *c : shellClients) {
+            setupClientConnections(c);
+            if (!exclude(c) && shouldAdd(c)) {
+                clients << c;
+            }
+        }
+    }
+    insertClients(clients);
 }
 
 void ClientLevel::reInit()
 {
+    // Clients which are no longer included are removed one by one, the newly
+    // included ones are collected and announced as a single range of rows.
+    QVector<AbstractClient*> added;
+    auto check = [this, &added](AbstractClient *client) {
+        const bool shouldInclude = !exclude(client) && shouldAdd(client);
+        const bool contains = containsClient(client);
+        if (shouldInclude && !contains) {
+            added << client;
+        } else if (!shouldInclude && contains) {
+            removeClient(client);
+        }
+    };
     const QList<X11Client *> &clients = Workspace::self()->clientList();
     for (auto it = clients.begin(); it != clients.end(); ++it) {
-        checkClient((*it));
+        check(*it);
     }
     if (waylandServer()) {
         const auto &clients = waylandServer()->clients();
         for (auto *c : clients) {
-            checkClient(c);
+            check(c);
         }
     }
+    if (added.isEmpty()) {
+        return;
+    }
+    emit beginInsert(m_ids.count(), m_ids.count() + added.count() - 1, id());
+    insertClients(added);
+    emit endInsert();
 }
 
 quint32 ClientLevel::idForRow(int row) const
 {
-    if (row >= m_clients.size()) {
+    if (row < 0 || row >= m_ids.count()) {
         return 0;
     }
-    auto it = m_clients.constBegin();
-    for (int i=0; i<row; ++i) {
-        ++it;
-    }
-    return it.key();
+    return m_ids.at(row);
 }
 
 bool ClientLevel::containsId(quint32 id) const
@@ -251,36 +291,17 @@ bool ClientLevel::containsId(quint32 id) const
 
 int ClientLevel::rowForId(quint32 id) const
 {
-    int row = 0;
-    for (auto it = m_clients.constBegin();
-            it != m_clients.constEnd();
-            ++it, ++row) {
-        if (it.key() == id) {
-            return row;
-        }
-    }
-    return -1;
+    return m_rows.value(id, -1);
 }
 
 AbstractClient *ClientLevel::clientForId(quint32 child) const
 {
-    auto it = m_clients.constFind(child);
-    if (it == m_clients.constEnd()) {
-        return nullptr;
-    }
-    return it.value();
+    return m_clients.value(child, nullptr);
 }
 
 bool ClientLevel::containsClient(AbstractClient *client) const
 {
-    for (auto it = m_clients.constBegin();
-            it != m_clients.constEnd();
-            ++it) {
-        if (it.value() == client) {
-            return true;
-        }
-    }
-    return false;
+    return m_clientIds.contains(client);
 }
 
 const AbstractLevel *ClientLevel::levelForId(quint32 id) const
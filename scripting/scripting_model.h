@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QAbstractItemModel>
 #include <QSortFilterProxyModel>
+#include <QHash>
 #include <QList>
+#include <QVector>
 
 namespace KWin {
 class AbstractClient;
@@ -241,7 +243,14 @@ private:
     bool shouldAdd(AbstractClient *client) const;
     bool exclude(AbstractClient *client) const;
     bool containsClient(AbstractClient *client) const;
-    QMap<quint32, AbstractClient*> m_clients;
+    void insertClients(const QVector<AbstractClient*> &clients);
+    /**
+     * The ids of the Clients in row order, new Clients are appended.
+     */
+    QVector<quint32> m_ids;
+    QHash<quint32, AbstractClient*> m_clients;
+    QHash<AbstractClient*, quint32> m_clientIds;
+    QHash<quint32, int> m_rows;
 };
 
 class SimpleClientModel : public ClientModel
@@ -301,7 +310,7 @@ private:
 inline
 int ClientLevel::count() const
 {
-    return m_clients.count();
+    return m_ids.count();
 }
 
 inline
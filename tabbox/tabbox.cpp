@@ -511,6 +511,11 @@ TabBox::TabBox(QObject *parent)
 
     m_tabBoxMode = TabBoxDesktopMode; // init variables
     connect(&m_delayedShowTimer, SIGNAL(timeout()), this, SLOT(show()));
+    // The switcher layouts are instantiated once things calmed down after startup or a
+    // configuration change, so that the first Alt+Tab does not have to load them.
+    m_preloadTimer.setSingleShot(true);
+    m_preloadTimer.setInterval(3000);
+    connect(&m_preloadTimer, &QTimer::timeout, this, &TabBox::preloadSwitchers);
     connect(Workspace::self(), SIGNAL(configChanged()), this, SLOT(reconfigure()));
 }
 
@@ -526,6 +531,17 @@ void TabBox::handlerReady()
     m_ready = true;
 }
 
+void TabBox::preloadSwitchers()
+{
+    if (m_isShown || isGrabbed()) {
+        // the user is already switching, try again later
+        m_preloadTimer.start();
+        return;
+    }
+    m_tabBox->preload(m_defaultConfig);
+    m_tabBox->preload(m_alternativeConfig);
+}
+
 template <typename Slot>
 void TabBox::key(const char *actionName, Slot slot, const QKeySequence &shortcut)
 {
@@ -755,6 +771,7 @@ void TabBox::reconfigure()
     m_alternativeCurrentApplicationConfig.setClientApplicationsMode(TabBoxConfig::AllWindowsCurrentApplication);
 
     m_tabBox->setConfig(m_defaultConfig);
+    m_preloadTimer.start();
 
     m_delayShow = config.readEntry<bool>("ShowDelay", true);
     m_delayShowTime = config.readEntry<int>("DelayTime", 90);
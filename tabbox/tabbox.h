@@ -329,6 +329,7 @@ private:
 
 private Q_SLOTS:
     void reconfigure();
+    void preloadSwitchers();
     void globalShortcutChanged(QAction *action, const QKeySequence &seq);
 
 private:
@@ -338,6 +339,7 @@ private:
     int m_delayShowTime;
 
     QTimer m_delayedShowTimer;
+    QTimer m_preloadTimer;
     int m_displayRefcount;
 
     TabBoxConfig m_defaultConfig;
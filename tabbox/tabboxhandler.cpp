@@ -76,6 +76,7 @@ public:
     void endHighlightWindows(bool abort = false);
 
     void show();
+    void preload(const TabBoxConfig &config);
     QQuickWindow *window() const;
     SwitcherItem *switcherItem() const;
 
@@ -101,7 +102,9 @@ public:
     int wheelAngleDelta = 0;
 
 private:
-    QObject *createSwitcherItem(bool desktopMode);
+    void setupQml();
+    QObject *switcherItemForLayout(bool desktopMode, const QString &layoutName);
+    QObject *createSwitcherItem(bool desktopMode, const QString &layoutName);
 };
 
 TabBoxHandlerPrivate::TabBoxHandlerPrivate(TabBoxHandler *q)
@@ -140,17 +143,22 @@ QQuickWindow *TabBoxHandlerPrivate::window() const
 }
 
 #ifndef KWIN_UNIT_TEST
-SwitcherItem *TabBoxHandlerPrivate::switcherItem() const
+static SwitcherItem *findSwitcherItem(QObject *mainItem)
 {
-    if (!m_mainItem) {
+    if (!mainItem) {
         return nullptr;
     }
-    if (SwitcherItem *i = qobject_cast<SwitcherItem*>(m_mainItem)) {
+    if (SwitcherItem *i = qobject_cast<SwitcherItem*>(mainItem)) {
         return i;
-    } else if (QQuickWindow *w = qobject_cast<QQuickWindow*>(m_mainItem)) {
+    } else if (QQuickWindow *w = qobject_cast<QQuickWindow*>(mainItem)) {
         return w->contentItem()->findChild<SwitcherItem*>();
     }
-    return m_mainItem->findChild<SwitcherItem*>();
+    return mainItem->findChild<SwitcherItem*>();
+}
+
+SwitcherItem *TabBoxHandlerPrivate::switcherItem() const
+{
+    return findSwitcherItem(m_mainItem);
 }
 #endif
 
@@ -233,20 +241,20 @@ void TabBoxHandlerPrivate::endHighlightWindows(bool abort)
 }
 
 #ifndef KWIN_UNIT_TEST
-QObject *TabBoxHandlerPrivate::createSwitcherItem(bool desktopMode)
+QObject *TabBoxHandlerPrivate::createSwitcherItem(bool desktopMode, const QString &layoutName)
 {
     // first try look'n'feel package
     QString file = QStandardPaths::locate(QStandardPaths::GenericDataLocation,
                                           QStringLiteral("plasma/look-and-feel/%1/contents/%2")
-                                              .arg(config.layoutName())
+                                              .arg(layoutName)
                                               .arg(desktopMode ? QStringLiteral("desktopswitcher/DesktopSwitcher.qml") : QStringLiteral("windowswitcher/WindowSwitcher.qml")));
     if (file.isNull()) {
         const QString folderName = QLatin1String(UKUI_KWIN_NAME) + (desktopMode ? QLatin1String("/desktoptabbox/") : QLatin1String("/tabbox/"));
-        auto findSwitcher = [this, desktopMode, folderName] {
+        auto findSwitcher = [layoutName, desktopMode, folderName] {
             const QString type = desktopMode ? QStringLiteral("UKUIKWin/DesktopSwitcher") : QStringLiteral("UKUIKWin/WindowSwitcher");
             auto offers = KPackage::PackageLoader::self()->findPackages(type,  folderName,
-                [this] (const KPluginMetaData &data) {
-                    return data.pluginId().compare(config.layoutName(), Qt::CaseInsensitive) == 0;
+                [layoutName] (const KPluginMetaData &data) {
+                    return data.pluginId().compare(layoutName, Qt::CaseInsensitive) == 0;
                 }
             );
             if (offers.isEmpty()) {
@@ -292,19 +300,17 @@ QObject *TabBoxHandlerPrivate::createSwitcherItem(bool desktopMode)
     } else {
         QObject *object = m_qmlComponent->create(m_qmlContext.data());
         if (desktopMode) {
-            m_desktopTabBoxes.insert(config.layoutName(), object);
+            m_desktopTabBoxes.insert(layoutName, object);
         } else {
-            m_clientTabBoxes.insert(config.layoutName(), object);
+            m_clientTabBoxes.insert(layoutName, object);
         }
         return object;
     }
     return nullptr;
 }
-#endif
 
-void TabBoxHandlerPrivate::show()
+void TabBoxHandlerPrivate::setupQml()
 {
-#ifndef KWIN_UNIT_TEST
     if (m_qmlContext.isNull()) {
         qmlRegisterType<SwitcherItem>("org.ukui.kwin", 2, 0, "Switcher");
         m_qmlContext.reset(new QQmlContext(Scripting::self()->qmlEngine()));
@@ -312,21 +318,51 @@ void TabBoxHandlerPrivate::show()
     if (m_qmlComponent.isNull()) {
         m_qmlComponent.reset(new QQmlComponent(Scripting::self()->qmlEngine()));
     }
+}
+
+QObject *TabBoxHandlerPrivate::switcherItemForLayout(bool desktopMode, const QString &layoutName)
+{
+    const QMap<QString, QObject *> &tabBoxes = desktopMode ? m_desktopTabBoxes : m_clientTabBoxes;
+    auto it = tabBoxes.constFind(layoutName);
+    if (it != tabBoxes.constEnd()) {
+        return it.value();
+    }
+    return createSwitcherItem(desktopMode, layoutName);
+}
+#endif
+
+void TabBoxHandlerPrivate::preload(const TabBoxConfig &config)
+{
+#ifndef KWIN_UNIT_TEST
+    if (!config.isShowTabBox() || !Scripting::self()) {
+        return;
+    }
+    setupQml();
     const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
-    auto findMainItem = [this](const QMap<QString, QObject *> &tabBoxes) -> QObject* {
-        auto it = tabBoxes.constFind(config.layoutName());
-        if (it != tabBoxes.constEnd()) {
-            return it.value();
+    SwitcherItem *item = findSwitcherItem(switcherItemForLayout(desktopMode, config.layoutName()));
+    if (item && !item->model()) {
+        // lets the view create its delegates now instead of on the first show
+        QAbstractItemModel *model = nullptr;
+        if (desktopMode) {
+            model = desktopModel();
+        } else {
+            model = clientModel();
         }
-        return nullptr;
-    };
-    m_mainItem = nullptr;
-    m_mainItem = desktopMode ? findMainItem(m_desktopTabBoxes) : findMainItem(m_clientTabBoxes);
+        item->setModel(model);
+    }
+#else
+    Q_UNUSED(config)
+#endif
+}
+
+void TabBoxHandlerPrivate::show()
+{
+#ifndef KWIN_UNIT_TEST
+    setupQml();
+    const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
+    m_mainItem = switcherItemForLayout(desktopMode, config.layoutName());
     if (!m_mainItem) {
-        m_mainItem = createSwitcherItem(desktopMode);
-        if (!m_mainItem) {
-            return;
-        }
+        return;
     }
     if (SwitcherItem *item = switcherItem()) {
         // In case the model isn't yet set (see below), index will be reset and therefore we
@@ -414,6 +450,11 @@ void TabBoxHandler::initHighlightWindows()
     d->updateHighlightWindows();
 }
 
+void TabBoxHandler::preload(const TabBoxConfig &config)
+{
+    d->preload(config);
+}
+
 void TabBoxHandler::hide(bool abort)
 {
     d->isShown = false;
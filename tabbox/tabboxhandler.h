@@ -243,6 +243,14 @@ public:
      * @see show
      */
     void hide(bool abort = false);
+    /**
+     * Loads and instantiates the switcher layout configured in @p config without showing it.
+     * The next show() with that layout only has to make the switcher visible. Loading the
+     * layout also fills the QML disk cache, so its compiled form survives a restart.
+     * Does nothing if the layout is already instantiated or no switcher is shown for @p config.
+     * @see TabBoxConfig::isShowTabBox
+     */
+    void preload(const TabBoxConfig &config);
 
     /**
      * Sets the current model index in the view and updates
@@ -0,0 +1,202 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "windowgeometryindex.h"
+#include "abstract_client.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// Edge length of the grid cells, in the order of a small window.
+static const int s_cellSize = 256;
+
+static inline int cellCoordinate(int coordinate)
+{
+    // round towards negative infinity, windows can be partially off-screen
+    return coordinate >= 0 ? coordinate / s_cellSize : -((-coordinate - 1) / s_cellSize) - 1;
+}
+
+static inline quint64 cellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+WindowGeometryIndex::WindowGeometryIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+WindowGeometryIndex::~WindowGeometryIndex() = default;
+
+QRect WindowGeometryIndex::cellRange(const QRect &rect) const
+{
+    return QRect(QPoint(cellCoordinate(rect.left()), cellCoordinate(rect.top())),
+                 QPoint(cellCoordinate(rect.right()), cellCoordinate(rect.bottom())));
+}
+
+QRect WindowGeometryIndex::boundingRect() const
+{
+    if (m_occupiedCells.isEmpty()) {
+        return QRect();
+    }
+    return QRect(m_occupiedCells.x() * s_cellSize, m_occupiedCells.y() * s_cellSize,
+                 m_occupiedCells.width() * s_cellSize, m_occupiedCells.height() * s_cellSize);
+}
+
+void WindowGeometryIndex::insert(AbstractClient *client)
+{
+    if (m_entries.contains(client)) {
+        return;
+    }
+    Entry entry;
+    entry.geometry = client->frameGeometry();
+    entry.sequence = m_sequence++;
+    m_entries.insert(client, entry);
+    addToCells(client, entry.geometry);
+    connect(client, &Toplevel::geometryChanged, this, [this, client] { update(client); });
+}
+
+void WindowGeometryIndex::remove(AbstractClient *client)
+{
+    auto it = m_entries.find(client);
+    if (it == m_entries.end()) {
+        return;
+    }
+    removeFromCells(client, it->geometry);
+    m_entries.erase(it);
+    disconnect(client, nullptr, this, nullptr);
+    if (m_entries.isEmpty()) {
+        m_occupiedCells = QRect();
+    }
+}
+
+void WindowGeometryIndex::clear()
+{
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        disconnect(it.key(), nullptr, this, nullptr);
+    }
+    m_entries.clear();
+    m_cells.clear();
+    m_occupiedCells = QRect();
+}
+
+void WindowGeometryIndex::update(AbstractClient *client)
+{
+    auto it = m_entries.find(client);
+    if (it == m_entries.end()) {
+        return;
+    }
+    const QRect geometry = client->frameGeometry();
+    if (geometry == it->geometry) {
+        return;
+    }
+    if (!geometry.isEmpty() && !it->geometry.isEmpty() && cellRange(geometry) == cellRange(it->geometry)) {
+        // moved within the same cells, the common case while dragging
+        it->geometry = geometry;
+        return;
+    }
+    removeFromCells(client, it->geometry);
+    it->geometry = geometry;
+    addToCells(client, geometry);
+}
+
+void WindowGeometryIndex::addToCells(AbstractClient *client, const QRect &geometry)
+{
+    if (geometry.isEmpty()) {
+        return;
+    }
+    const QRect range = cellRange(geometry);
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        for (int x = range.left(); x <= range.right(); ++x) {
+            m_cells[cellKey(x, y)].append(client);
+        }
+    }
+    m_occupiedCells |= range;
+}
+
+void WindowGeometryIndex::removeFromCells(AbstractClient *client, const QRect &geometry)
+{
+    if (geometry.isEmpty()) {
+        return;
+    }
+    const QRect range = cellRange(geometry);
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        for (int x = range.left(); x <= range.right(); ++x) {
+            auto it = m_cells.find(cellKey(x, y));
+            if (it == m_cells.end()) {
+                continue;
+            }
+            it->removeOne(client);
+            if (it->isEmpty()) {
+                m_cells.erase(it);
+            }
+        }
+    }
+}
+
+QVector<AbstractClient *> WindowGeometryIndex::intersecting(const QRect &rect) const
+{
+    if (rect.isEmpty() || m_entries.isEmpty()) {
+        return {};
+    }
+    const QRect range = cellRange(rect) & m_occupiedCells;
+    if (range.isEmpty()) {
+        return {};
+    }
+
+    QVector<QPair<quint64, AbstractClient *>> found;
+    if (qint64(range.width()) * range.height() > m_entries.count()) {
+        // visiting the cells would be more expensive than looking at every Client
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it->geometry.intersects(rect)) {
+                found.append(qMakePair(it->sequence, it.key()));
+            }
+        }
+    } else {
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const auto cell = m_cells.constFind(cellKey(x, y));
+                if (cell == m_cells.constEnd()) {
+                    continue;
+                }
+                for (AbstractClient *client : *cell) {
+                    const auto entry = m_entries.constFind(client);
+                    if (entry->geometry.intersects(rect)) {
+                        found.append(qMakePair(entry->sequence, client));
+                    }
+                }
+            }
+        }
+    }
+    // restore the insertion order, a Client covering several cells is found once per cell
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    QVector<AbstractClient *> clients;
+    clients.reserve(found.count());
+    for (const auto &pair : found) {
+        clients.append(pair.second);
+    }
+    return clients;
+}
+
+}
@@ -0,0 +1,91 @@
+/********************************************************************
+ UKUI-KWin - the UKUI3.0 window manager
+ This file is part of the UKUI project
+ The ukui-kwin is forked from kwin
+
+Copyright (C) 2014-2020 kylinos.cn
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+class AbstractClient;
+
+/**
+ * The WindowGeometryIndex is a spatial index of the frame geometries of the managed Clients.
+ *
+ * The area is divided into a sparse grid of square cells and every Client is referenced from
+ * the cells its frame geometry covers. A query for a rectangle only has to look at the Clients
+ * in the cells the rectangle covers instead of at all Clients, which keeps placement and
+ * snapping cheap with many windows. Since windows on different screens end up in different
+ * cells, the index is implicitly per screen.
+ *
+ * The index follows the geometry of the Clients through Toplevel::geometryChanged. Whether a
+ * Client is on the right virtual desktop or activity is left to the caller, as Clients can be
+ * on several desktops at once.
+ */
+class UKUI_KWIN_EXPORT WindowGeometryIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WindowGeometryIndex(QObject *parent = nullptr);
+    ~WindowGeometryIndex() override;
+
+    void insert(AbstractClient *client);
+    void remove(AbstractClient *client);
+    void clear();
+    bool contains(AbstractClient *client) const {
+        return m_entries.contains(client);
+    }
+    int count() const {
+        return m_entries.count();
+    }
+    /**
+     * A rectangle containing all indexed frame geometries, possibly larger than necessary.
+     */
+    QRect boundingRect() const;
+
+    /**
+     * Returns the Clients whose frame geometry intersects @p rect, in the order the Clients
+     * were inserted. @p rect may extend far beyond the indexed area.
+     */
+    QVector<AbstractClient *> intersecting(const QRect &rect) const;
+
+private:
+    struct Entry {
+        QRect geometry;
+        quint64 sequence = 0;
+    };
+    void update(AbstractClient *client);
+    void addToCells(AbstractClient *client, const QRect &geometry);
+    void removeFromCells(AbstractClient *client, const QRect &geometry);
+    QRect cellRange(const QRect &rect) const;
+
+    QHash<AbstractClient *, Entry> m_entries;
+    QHash<quint64, QVector<AbstractClient *>> m_cells;
+    // the range of cells which ever got a Client since the index was empty
+    QRect m_occupiedCells;
+    quint64 m_sequence = 0;
+};
+
+}
@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "workspace.h"
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 // kwin
 #ifdef KWIN_BUILD_ACTIVITIES
 #include "activities.h"
@@ -64,6 +65,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "virtualdesktops.h"
 #include "xdgshellclient.h"
 #include "was_user_interaction_x11_filter.h"
+#include "windowgeometryindex.h"
 #include "wayland_server.h"
 #include "xcbutils.h"
 #include "main.h"
@@ -135,6 +137,7 @@ Workspace::Workspace(const QString &sessionKey)
     , set_active_client_recursion(0)
     , block_stacking_updates(0)
     , m_sessionManager(new SessionManager(this))
+    , m_geometryIndex(new WindowGeometryIndex(this))
 {
     // If KWin was already running it saved its configuration after loosing the selection -> Reread
     QFuture<void> reparseConfigFuture = QtConcurrent::run(options, &Options::reparseConfiguration);
@@ -253,6 +256,7 @@ void Workspace::init()
                     }
                 }
             }
+            m_desktopIndex.remove(desktop);
         }
     );
 
@@ -320,6 +324,7 @@ void Workspace::init()
                         c->placeIn(area);
                     }
                     m_allClients.append(c);
+                    m_geometryIndex->insert(c);
                     if (!unconstrained_stacking_order.contains(c))
                         unconstrained_stacking_order.append(c);   // Raise if it hasn't got any stacking position yet
                     if (!stacking_order.contains(c))    // It'll be updated later, and updateToolWindows() requires
@@ -361,6 +366,7 @@ void Workspace::init()
         connect(w, &WaylandServer::shellClientRemoved, this,
             [this] (XdgShellClient *c) {
                 m_allClients.removeAll(c);
+                m_geometryIndex->remove(c);
                 if (c == most_recently_raised) {
                     most_recently_raised = nullptr;
                 }
@@ -551,6 +557,7 @@ Workspace::~Workspace()
     // "mutex" the stackingorder, since anything trying to access it from now on will find
     // many dangeling pointers and crash
     stacking_order.clear();
+    m_x11WindowIndex.clear();
 
     for (auto it = stack.constBegin(), end = stack.constEnd(); it != end; ++it) {
         X11Client *c = qobject_cast<X11Client *>(const_cast<Toplevel*>(*it));
@@ -564,7 +571,10 @@ Workspace::~Workspace()
         // from crashing.
         clients.removeAll(c);
         m_allClients.removeAll(c);
+        m_geometryIndex->remove(c);
         desktops.removeAll(c);
+        disconnect(c, &AbstractClient::desktopChanged, this, nullptr);
+        removeFromDesktopIndex(c);
     }
     X11Client::cleanupX11();
 
@@ -654,6 +664,11 @@ void Workspace::addClient(X11Client *c)
 {
     Group* grp = findGroup(c->window());
 
+    registerX11Window(c->window(), c);
+    registerX11Window(c->wrapperId(), c);
+    registerX11Window(c->frameId(), c);
+    registerX11Window(c->inputId(), c);
+
     emit clientAdded(c);
 
     if (grp != nullptr)
@@ -667,7 +682,10 @@ void Workspace::addClient(X11Client *c)
         FocusChain::self()->update(c, FocusChain::Update);
         clients.append(c);
         m_allClients.append(c);
+        m_geometryIndex->insert(c);
     }
+    updateDesktopIndex(c);
+    connect(c, &AbstractClient::desktopChanged, this, [this, c] { updateDesktopIndex(c); });
     if (!unconstrained_stacking_order.contains(c))
         unconstrained_stacking_order.append(c);   // Raise if it hasn't got any stacking position yet
     if (!stacking_order.contains(c))    // It'll be updated later, and updateToolWindows() requires
@@ -709,6 +727,7 @@ void Workspace::addClient(X11Client *c)
 void Workspace::addUnmanaged(Unmanaged* c)
 {
     unmanaged.append(c);
+    registerX11Window(c->window(), c);
     markXStackingOrderAsDirty();
 }
 
@@ -734,7 +753,11 @@ void Workspace::removeClient(X11Client *c)
     // TODO: if marked client is removed, notify the marked list
     clients.removeAll(c);
     m_allClients.removeAll(c);
+    m_geometryIndex->remove(c);
     desktops.removeAll(c);
+    disconnect(c, &AbstractClient::desktopChanged, this, nullptr);
+    removeFromDesktopIndex(c);
+    unregisterX11Windows(c);
     markXStackingOrderAsDirty();
     attention_chain.removeAll(c);
     Group* group = findGroup(c->window());
@@ -761,6 +784,7 @@ void Workspace::removeUnmanaged(Unmanaged* c)
 {
     Q_ASSERT(unmanaged.contains(c));
     unmanaged.removeAll(c);
+    unregisterX11Windows(c);
     emit unmanagedRemoved(c);
     markXStackingOrderAsDirty();
 }
@@ -970,17 +994,43 @@ void Workspace::slotCurrentDesktopChanged(uint oldDesktop, uint newDesktop)
 
 void Workspace::updateClientVisibilityOnDesktopChange(uint newDesktop)
 {
-    for (auto it = stacking_order.constBegin();
-            it != stacking_order.constEnd();
-            ++it) {
-        X11Client *c = qobject_cast<X11Client *>(*it);
-        if (!c) {
-            continue;
-        }
-        if (!c->isOnDesktop(newDesktop) && c != movingClient && c->isOnCurrentActivity()) {
-            (c)->updateVisibility();
+    VirtualDesktop *previous = m_visibleDesktop;
+    m_visibleDesktop = VirtualDesktopManager::self()->currentDesktop();
+
+    // Only the clients on exactly one of both desktops change their visibility. If the previous
+    // desktop is not known (first switch or it got removed) all clients have to be updated.
+    const QSet<X11Client *> leaving = m_desktopIndex.value(previous);
+    const QSet<X11Client *> entering = m_desktopIndex.value(m_visibleDesktop);
+
+    QVector<X11Client *> hide;
+    QVector<X11Client *> show;
+    if (!previous || !leaving.isEmpty() || !entering.isEmpty()) {
+        for (auto it = stacking_order.constBegin(); it != stacking_order.constEnd(); ++it) {
+            X11Client *c = qobject_cast<X11Client *>(*it);
+            if (!c || !c->isOnCurrentActivity()) {
+                continue;
+            }
+            if (previous && leaving.contains(c) == entering.contains(c)) {
+                continue;
+            }
+            if (c->isOnDesktop(newDesktop)) {
+                show.append(c);
+            } else if (c != movingClient) {
+                hide.append(c);
+            }
         }
     }
+    // Show from top to bottom
+    std::reverse(show.begin(), show.end());
+
+    // Send all unmap, map and property requests as one transaction with a single flush
+    QScopedPointer<XServerGrabber> grabber;
+    if (!hide.isEmpty() || !show.isEmpty()) {
+        grabber.reset(new XServerGrabber);
+    }
+    for (X11Client *c : qAsConst(hide)) {
+        c->updateVisibility();
+    }
     // Now propagate the change, after hiding, before showing
     if (rootInfo()) {
         rootInfo()->setCurrentDesktop(VirtualDesktopManager::self()->current());
@@ -990,18 +1040,42 @@ void Workspace::updateClientVisibilityOnDesktopChange(uint newDesktop)
         movingClient->setDesktop(newDesktop);
     }
 
-    for (int i = stacking_order.size() - 1; i >= 0 ; --i) {
-        X11Client *c = qobject_cast<X11Client *>(stacking_order.at(i));
-        if (!c) {
-            continue;
-        }
-        if (c->isOnDesktop(newDesktop) && c->isOnCurrentActivity())
-            c->updateVisibility();
+    for (X11Client *c : qAsConst(show)) {
+        c->updateVisibility();
     }
+    grabber.reset();
+
     if (showingDesktop())   // Do this only after desktop change to avoid flicker
         setShowingDesktop(false);
 }
 
+void Workspace::updateDesktopIndex(X11Client *c)
+{
+    removeFromDesktopIndex(c);
+    const QVector<VirtualDesktop *> clientDesktops = c->desktops();
+    for (VirtualDesktop *desktop : clientDesktops) {
+        m_desktopIndex[desktop].insert(c);
+    }
+    if (!clientDesktops.isEmpty()) {
+        m_indexedDesktops.insert(c, clientDesktops);
+    }
+}
+
+void Workspace::removeFromDesktopIndex(X11Client *c)
+{
+    const QVector<VirtualDesktop *> clientDesktops = m_indexedDesktops.take(c);
+    for (VirtualDesktop *desktop : clientDesktops) {
+        auto it = m_desktopIndex.find(desktop);
+        if (it == m_desktopIndex.end()) {
+            continue;
+        }
+        it->remove(c);
+        if (it->isEmpty()) {
+            m_desktopIndex.erase(it);
+        }
+    }
+}
+
 void Workspace::activateClientOnNewDesktop(uint desktop)
 {
     AbstractClient* c = nullptr;
@@ -1647,6 +1721,18 @@ QString Workspace::supportInformation() const
             }
 
             support.append(QStringLiteral("OpenGL 2 Shaders are used\n"));
+            support.append(QStringLiteral("Shader program cache: "));
+            if (ShaderManager::instance()->isProgramCacheEnabled()) {
+                const ShaderManager::CacheStatistics cache = ShaderManager::instance()->cacheStatistics();
+                const int lookups = cache.hits + cache.misses;
+                support.append(QStringLiteral("%1 of %2 programs loaded from cache (%3%), %4 ms compile time saved, %5 ms spent compiling\n")
+                               .arg(cache.hits).arg(lookups)
+                               .arg(lookups ? cache.hits * 100 / lookups : 0)
+                               .arg(cache.savedTime / 1000000)
+                               .arg(cache.compileTime / 1000000));
+            } else {
+                support.append(QStringLiteral(" no\n"));
+            }
             support.append(QStringLiteral("Painting blocks for vertical retrace: "));
             if (m_compositor->scene()->blocksForRetrace())
                 support.append(QStringLiteral(" yes\n"));
@@ -1718,34 +1804,65 @@ Unmanaged *Workspace::findUnmanaged(std::function<bool (const Unmanaged*)> func)
 
 Unmanaged *Workspace::findUnmanaged(xcb_window_t w) const
 {
-    return findUnmanaged([w](const Unmanaged *u) {
-        return u->window() == w;
-    });
+    Unmanaged *u = qobject_cast<Unmanaged *>(findX11Toplevel(w));
+    if (u && u->window() == w) {
+        return u;
+    }
+    return nullptr;
 }
 
 X11Client *Workspace::findClient(Predicate predicate, xcb_window_t w) const
 {
+    X11Client *c = qobject_cast<X11Client *>(findX11Toplevel(w));
+    if (!c) {
+        return nullptr;
+    }
     switch (predicate) {
     case Predicate::WindowMatch:
-        return findClient([w](const X11Client *c) {
-            return c->window() == w;
-        });
+        return c->window() == w ? c : nullptr;
     case Predicate::WrapperIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->wrapperId() == w;
-        });
+        return c->wrapperId() == w ? c : nullptr;
     case Predicate::FrameIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->frameId() == w;
-        });
+        return c->frameId() == w ? c : nullptr;
     case Predicate::InputIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->inputId() == w;
-        });
+        return c->inputId() == w ? c : nullptr;
     }
     return nullptr;
 }
 
+Toplevel *Workspace::findX11Toplevel(xcb_window_t w) const
+{
+    if (w == XCB_WINDOW_NONE) {
+        return nullptr;
+    }
+    return m_x11WindowIndex.value(w);
+}
+
+void Workspace::registerX11Window(xcb_window_t w, Toplevel *toplevel)
+{
+    if (w == XCB_WINDOW_NONE) {
+        return;
+    }
+    m_x11WindowIndex.insert(w, toplevel);
+}
+
+void Workspace::unregisterX11Window(xcb_window_t w)
+{
+    m_x11WindowIndex.remove(w);
+}
+
+void Workspace::unregisterX11Windows(Toplevel *toplevel)
+{
+    // The window ids might already be reset, so don't rely on them
+    for (auto it = m_x11WindowIndex.begin(); it != m_x11WindowIndex.end();) {
+        if (it.value() == toplevel) {
+            it = m_x11WindowIndex.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 Toplevel *Workspace::findToplevel(std::function<bool (const Toplevel*)> func) const
 {
     if (X11Client *ret = Toplevel::findInList(clients, func)) {
@@ -1847,6 +1964,7 @@ void Workspace::updateTabbox()
 void Workspace::addInternalClient(InternalClient *client)
 {
     m_internalClients.append(client);
+    m_geometryIndex->insert(client);
 
     setupClientConnections(client);
     client->updateLayer();
@@ -1865,6 +1983,7 @@ void Workspace::addInternalClient(InternalClient *client)
 void Workspace::removeInternalClient(InternalClient *client)
 {
     m_internalClients.removeOne(client);
+    m_geometryIndex->remove(client);
 
     markXStackingOrderAsDirty();
     updateStackingOrder(true);
@@ -2451,8 +2570,15 @@ QPoint Workspace::adjustClientPosition(AbstractClient* c, QPoint pos, bool unres
         // windows snap
         int snap = options->windowSnapZone() * snapAdjust;
         if (snap) {
-            for (auto l = m_allClients.constBegin(); l != m_allClients.constEnd(); ++l) {
-                if ((*l) == c)
+            // Only clients near the moved window can attract it. Besides the snap zone the
+            // window can already have been shifted by the border snap, which might let a
+            // corner of a client further away line up with it.
+            const QMargins frameMargins = c->frameMargins();
+            const int reachX = qMax(snap, snapX + qMax(frameMargins.left(), frameMargins.right())) + 1;
+            const int reachY = qMax(snap, snapY + qMax(frameMargins.top(), frameMargins.bottom())) + 1;
+            const auto candidates = m_geometryIndex->intersecting(QRect(cx, cy, cw, ch).adjusted(-reachX, -reachY, reachX, reachY));
+            for (auto l = candidates.constBegin(); l != candidates.constEnd(); ++l) {
+                if ((*l) == c || (*l)->isInternal())
                     continue;
                 if ((*l)->isMinimized())
                     continue; // is minimized
@@ -35,6 +35,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sm.h"
 #include "utils.h"
 // Qt
+#include <QHash>
+#include <QPointer>
+#include <QSet>
 #include <QTimer>
 #include <QVector>
 // std
@@ -67,6 +70,8 @@ class ShortcutDialog;
 class Toplevel;
 class Unmanaged;
 class UserActionsMenu;
+class VirtualDesktop;
+class WindowGeometryIndex;
 class X11Client;
 class X11EventFilter;
 enum class Predicate;
@@ -137,6 +142,26 @@ public:
      * @return KWin::Unmanaged* Found Unmanaged or @c null if there is no Unmanaged with given Id.
      */
     Unmanaged *findUnmanaged(xcb_window_t w) const;
+    /**
+     * @brief Finds the X11Client or Unmanaged owning the X11 window @p w.
+     *
+     * The window can be any of the windows managed by KWin for a Toplevel: the client
+     * window, the wrapper, the frame or the decoration input window of an X11Client, or
+     * the window of an Unmanaged. The lookup is a single hash probe.
+     *
+     * @param w The window id to search for
+     * @return KWin::Toplevel* Found Toplevel or @c null if no Toplevel owns the window.
+     */
+    Toplevel *findX11Toplevel(xcb_window_t w) const;
+    /**
+     * Adds the X11 window @p w to the index used by findX11Toplevel().
+     * Called by X11Client when the decoration input window gets created.
+     */
+    void registerX11Window(xcb_window_t w, Toplevel *toplevel);
+    /**
+     * Removes the X11 window @p w from the index used by findX11Toplevel().
+     */
+    void unregisterX11Window(xcb_window_t w);
     void forEachUnmanaged(std::function<void (Unmanaged*)> func);
     Toplevel *findToplevel(std::function<bool (const Toplevel*)> func) const;
     void forEachToplevel(std::function<void (Toplevel *)> func);
@@ -253,6 +278,13 @@ public:
         return m_internalClients;
     }
 
+    /**
+     * @returns Spatial index of the frame geometries of all managed and internal clients
+     */
+    WindowGeometryIndex *geometryIndex() const {
+        return m_geometryIndex;
+    }
+
     void stackScreenEdgesUnderOverrideRedirect();
 
     SessionManager *sessionManager() const;
@@ -558,6 +590,8 @@ private:
 
     void propagateClients(bool propagate_new_clients);   // Called only from updateStackingOrder
     QList<Toplevel *> constrainedStackingOrder();
+    void recordRestack(AbstractClient *c, bool batched);
+    bool moveRestackedClient(QList<Toplevel *> &stacking) const;
     void raiseClientWithinApplication(AbstractClient* c);
     void lowerClientWithinApplication(AbstractClient* c);
     bool allowFullClientRaising(const AbstractClient* c, xcb_timestamp_t timestamp);
@@ -574,6 +608,7 @@ private:
     void addClient(X11Client *c);
     Unmanaged* createUnmanaged(xcb_window_t w);
     void addUnmanaged(Unmanaged* c);
+    void unregisterX11Windows(Toplevel *toplevel);
 
     //---------------------------------------------------------------------
 
@@ -581,6 +616,8 @@ private:
     void updateClientArea(bool force);
     void resetClientAreas(uint desktopCount);
     void updateClientVisibilityOnDesktopChange(uint newDesktop);
+    void updateDesktopIndex(X11Client *c);
+    void removeFromDesktopIndex(X11Client *c);
     void activateClientOnNewDesktop(uint desktop);
     AbstractClient *findClientToActivateOnDesktop(uint desktop);
 
@@ -611,12 +648,17 @@ private:
     QList<X11Client *> desktops;
     QList<Unmanaged *> unmanaged;
     QList<Deleted *> deleted;
+    // All X11 windows of clients and unmanaged, see findX11Toplevel()
+    QHash<xcb_window_t, Toplevel *> m_x11WindowIndex;
     QList<InternalClient *> m_internalClients;
 
     QList<Toplevel *> unconstrained_stacking_order; // Topmost last
     QList<Toplevel *> stacking_order; // Topmost last   至少比clients多一个desktop窗口，还可以多包含XdgShellClient
     QVector<xcb_window_t> manual_overlays; //Topmost last
     bool force_restacking;
+    QHash<Toplevel *, Layer> m_stackingLayers; // Layers from the last constrainedStackingOrder()
+    AbstractClient *m_restackedClient = nullptr;
+    int m_restackCount = 0; // Moves since the last stacking update, see recordRestack()
     QList<Toplevel *> x_stacking; // From XQueryTree()
     std::unique_ptr<Xcb::Tree> m_xStackingQueryTree;
     bool m_xStackingDirty = false;
@@ -681,6 +723,14 @@ private:
     QScopedPointer<X11EventFilter> m_movingClientFilter;
 
     SessionManager *m_sessionManager;
+    WindowGeometryIndex *m_geometryIndex;
+    /**
+     * X11 clients per virtual desktop, clients on all desktops are not indexed as
+     * switching the desktop never changes their visibility.
+     */
+    QHash<VirtualDesktop *, QSet<X11Client *>> m_desktopIndex;
+    QHash<X11Client *, QVector<VirtualDesktop *>> m_indexedDesktops;
+    QPointer<VirtualDesktop> m_visibleDesktop;
 private:
     friend bool performTransiencyCheck();
     friend Workspace *workspace();
@@ -1017,6 +1017,7 @@ void X11Client::updateInputWindow()
     }
 
     if (region.isEmpty()) {
+        workspace()->unregisterX11Window(m_decoInputExtent);
         m_decoInputExtent.reset();
         return;
     }
@@ -1040,6 +1041,10 @@ void X11Client::updateInputWindow()
             XCB_EVENT_MASK_POINTER_MOTION
         };
         m_decoInputExtent.create(bounds, XCB_WINDOW_CLASS_INPUT_ONLY, mask, values);
+        // Before the client got added to the workspace, addClient() takes care of the index
+        if (workspace()->findClient(Predicate::WindowMatch, window()) == this) {
+            workspace()->registerX11Window(m_decoInputExtent, this);
+        }
         if (mapping_state == Mapped)
             m_decoInputExtent.map();
     } else {
@@ -1122,6 +1127,7 @@ void X11Client::destroyDecoration()
             emit geometryShapeChanged(this, oldgeom);
         }
     }
+    workspace()->unregisterX11Window(m_decoInputExtent);
     m_decoInputExtent.reset();
 }
 
@@ -292,6 +292,7 @@ void Xvisit::sendEnter()
     // then we can get rid of m_drag.
     const auto mimeTypesNames = m_drag->dataSourceIface()->mimeTypes();
     const int mimesCount = mimeTypesNames.size();
+    Selection::prefetchAtoms(mimeTypesNames);
     size_t cnt = 0;
     size_t totalCnt = 0;
     for (const auto mimeName : mimeTypesNames) {
@@ -380,6 +380,7 @@ bool WlVisit::handleEnter(xcb_client_message_event_t *event)
     Mimes offers;
     if (!(data->data32[1] & 1)) {
         // message has only max 3 types (which are directly in data)
+        Selection::prefetchAtomNames(data->data32 + 2, 3);
         for (size_t i = 0; i < 3; i++) {
             xcb_atom_t mimeAtom = data->data32[2 + i];
             const auto mimeStrings = atomToMimeTypes(mimeAtom);
@@ -419,6 +420,7 @@ void WlVisit::getMimesFromWinProperty(Mimes &offers)
     }
 
     xcb_atom_t *mimeAtoms = static_cast<xcb_atom_t *>(xcb_get_property_value(reply));
+    Selection::prefetchAtomNames(mimeAtoms, reply->value_len);
     for (size_t i = 0; i < reply->value_len; ++i) {
         const auto mimeStrings = atomToMimeTypes(mimeAtoms[i]);
         for (const auto mime : mimeStrings) {
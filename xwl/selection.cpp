@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xcb_event.h>
 #include <xcb/xfixes.h>
 
+#include <QHash>
 #include <QTimer>
 
 namespace KWin
@@ -36,7 +37,31 @@ namespace KWin
 namespace Xwl
 {
 
-xcb_atom_t Selection::mimeTypeToAtom(const QString &mimeType)
+namespace
+{
+/**
+ * Bidirectional mapping between atoms and their names. Atoms are never freed by the X server,
+ * so the mapping stays valid as long as the connection to Xwayland exists.
+ */
+struct AtomCache
+{
+    QHash<QString, xcb_atom_t> atoms;
+    QHash<xcb_atom_t, QString> names;
+
+    void insert(const QString &name, xcb_atom_t atom) {
+        atoms.insert(name, atom);
+        names.insert(atom, name);
+    }
+};
+}
+
+static AtomCache &atomCache()
+{
+    static AtomCache cache;
+    return cache;
+}
+
+static xcb_atom_t wellKnownMimeTypeAtom(const QString &mimeType)
 {
     if (mimeType == QLatin1String("text/plain;charset=utf-8")) {
         return atoms->utf8_string;
@@ -47,27 +72,98 @@ xcb_atom_t Selection::mimeTypeToAtom(const QString &mimeType)
     if (mimeType == QLatin1String("text/x-uri")) {
         return atoms->uri_list;
     }
+    return XCB_ATOM_NONE;
+}
+
+xcb_atom_t Selection::mimeTypeToAtom(const QString &mimeType)
+{
+    const xcb_atom_t atom = wellKnownMimeTypeAtom(mimeType);
+    if (atom != XCB_ATOM_NONE) {
+        return atom;
+    }
     return mimeTypeToAtomLiteral(mimeType);
 }
 
 xcb_atom_t Selection::mimeTypeToAtomLiteral(const QString &mimeType)
 {
-    return Xcb::Atom(mimeType.toLatin1(), false, kwinApp()->x11Connection());
+    prefetchAtoms(QStringList{mimeType});
+    return atomCache().atoms.value(mimeType, XCB_ATOM_NONE);
 }
 
-QString Selection::atomName(xcb_atom_t atom)
+void Selection::clearAtomCache()
 {
+    atomCache().atoms.clear();
+    atomCache().names.clear();
+}
+
+void Selection::prefetchAtoms(const QStringList &mimeTypes)
+{
+    AtomCache &cache = atomCache();
+    QStringList pending;
+    for (const QString &mimeType : mimeTypes) {
+        if (wellKnownMimeTypeAtom(mimeType) == XCB_ATOM_NONE && !cache.atoms.contains(mimeType)
+                && !pending.contains(mimeType)) {
+            pending << mimeType;
+        }
+    }
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    // send all requests before waiting for the first reply, so that
+    // resolving them costs a single round trip
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-    xcb_get_atom_name_cookie_t nameCookie = xcb_get_atom_name(xcbConn, atom);
-    xcb_get_atom_name_reply_t *nameReply = xcb_get_atom_name_reply(xcbConn, nameCookie, nullptr);
-    if (!nameReply) {
-        return QString();
+    QVector<xcb_intern_atom_cookie_t> cookies;
+    cookies.reserve(pending.count());
+    for (const QString &mimeType : qAsConst(pending)) {
+        const QByteArray name = mimeType.toLatin1();
+        cookies << xcb_intern_atom(xcbConn, false, name.length(), name.constData());
+    }
+    for (int i = 0; i < cookies.count(); ++i) {
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(xcbConn, cookies.at(i), nullptr);
+        if (!reply) {
+            continue;
+        }
+        cache.insert(pending.at(i), reply->atom);
+        free(reply);
+    }
+}
+
+QString Selection::atomName(xcb_atom_t atom)
+{
+    prefetchAtomNames(&atom, 1);
+    return atomCache().names.value(atom);
+}
+
+void Selection::prefetchAtomNames(const xcb_atom_t *atomList, int count)
+{
+    AtomCache &cache = atomCache();
+    QVector<xcb_atom_t> pending;
+    for (int i = 0; i < count; ++i) {
+        const xcb_atom_t atom = atomList[i];
+        if (atom != XCB_ATOM_NONE && !cache.names.contains(atom) && !pending.contains(atom)) {
+            pending << atom;
+        }
+    }
+    if (pending.isEmpty()) {
+        return;
     }
 
-    const size_t length = xcb_get_atom_name_name_length(nameReply);
-    QString name = QString::fromLatin1(xcb_get_atom_name_name(nameReply), length);
-    free(nameReply);
-    return name;
+    xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+    QVector<xcb_get_atom_name_cookie_t> cookies;
+    cookies.reserve(pending.count());
+    for (xcb_atom_t atom : qAsConst(pending)) {
+        cookies << xcb_get_atom_name(xcbConn, atom);
+    }
+    for (int i = 0; i < cookies.count(); ++i) {
+        xcb_get_atom_name_reply_t *nameReply = xcb_get_atom_name_reply(xcbConn, cookies.at(i), nullptr);
+        if (!nameReply) {
+            continue;
+        }
+        const size_t length = xcb_get_atom_name_name_length(nameReply);
+        cache.insert(QString::fromLatin1(xcb_get_atom_name_name(nameReply), length), pending.at(i));
+        free(nameReply);
+    }
 }
 
 QStringList Selection::atomToMimeTypes(xcb_atom_t atom)
@@ -62,6 +62,21 @@ public:
     static xcb_atom_t mimeTypeToAtomLiteral(const QString &mimeType);
     static QStringList atomToMimeTypes(xcb_atom_t atom);
     static QString atomName(xcb_atom_t atom);
+    /**
+     * Resolves the atoms of all @p mimeTypes not yet cached with a single round trip
+     * to the X server. Call before converting many MIME types one by one.
+     */
+    static void prefetchAtoms(const QStringList &mimeTypes);
+    /**
+     * Resolves the names of the first @p count atoms of @p atomList not yet cached with
+     * a single round trip to the X server. Call before converting many atoms one by one.
+     */
+    static void prefetchAtomNames(const xcb_atom_t *atomList, int count);
+    /**
+     * Forgets all cached atoms. Must be called when the connection to Xwayland goes away,
+     * the atoms of a restarted Xwayland differ.
+     */
+    static void clearAtomCache();
     static void sendSelectionNotify(xcb_selection_request_event_t *event, bool success);
 
     // on selection owner changes by X clients (Xwl -> Wl)
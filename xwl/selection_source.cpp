@@ -104,6 +104,7 @@ void WlSource::sendTargets(xcb_selection_request_event_t *event)
     targets[0] = atoms->timestamp;
     targets[1] = atoms->targets;
 
+    Selection::prefetchAtoms(m_offers.toList());
     size_t cnt = 2;
     for (const auto mime : m_offers) {
         targets[cnt] = Selection::mimeTypeToAtom(mime);
@@ -222,6 +223,7 @@ void X11Source::handleTargets()
 
     Mimes all;
     xcb_atom_t *value = static_cast<xcb_atom_t *>(xcb_get_property_value(reply));
+    Selection::prefetchAtomNames(value, reply->value_len);
     for (uint32_t i = 0; i < reply->value_len; i++) {
         if (value[i] == XCB_ATOM_NONE) {
             continue;
@@ -40,6 +40,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xfixes.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <xwayland_logging.h>
@@ -51,6 +53,15 @@ namespace Xwl
 
 // in Bytes: equals 64KB
 static const uint32_t s_incrChunkSize = 63 * 1024;
+// in Bytes: incremental chunks grow up to 4MB while the source is faster than the requestor
+static const uint32_t s_maxIncrChunkSize = 4 * 1024 * 1024;
+
+static uint32_t maxIncrChunkSize()
+{
+    // a chunk has to fit into a single ChangeProperty request, leave space for its header
+    const uint32_t maxRequestSize = xcb_get_maximum_request_length(kwinApp()->x11Connection()) * 4;
+    return qBound(s_incrChunkSize, maxRequestSize - 1024, s_maxIncrChunkSize);
+}
 
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
@@ -58,6 +69,10 @@ Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, Q
     , m_fd(fd)
     , m_timestamp(timestamp)
 {
+    if (m_fd >= 0) {
+        // don't block on a slow client, its socket notifier tells when to continue
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    }
 }
 
 void Transfer::createSocketNotifier(QSocketNotifier::Type type)
@@ -100,6 +115,8 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
                              qint32 fd, QObject *parent)
     : Transfer(selection, fd, 0, parent)
     , m_request(request)
+    , m_chunkSize(s_incrChunkSize)
+    , m_maxChunkSize(maxIncrChunkSize())
 {
 }
 
@@ -130,21 +147,24 @@ int TransferWltoX::flushSourceData()
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        m_bufferSize,
+                        m_buffer.constData());
     xcb_flush(xcbConn);
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    // the request has been written out, the buffer can be filled again
+    const int flushed = m_bufferSize;
+    m_bufferSize = 0;
+    if (socketNotifier()) {
+        socketNotifier()->setEnabled(true);
+    }
+    return flushed;
 }
 
 void TransferWltoX::startIncr()
 {
-    Q_ASSERT(m_chunks.size() == 1);
-
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
     uint32_t mask[] = { XCB_EVENT_MASK_PROPERTY_CHANGE };
@@ -165,48 +185,65 @@ void TransferWltoX::startIncr()
     setIncr(true);
     // first data will be flushed after the property has been deleted
     // again by the requestor
-    m_flushPropertyOnDelete = true;
     m_propertyIsSet = true;
     Q_EMIT selectionNotify(m_request, true);
 }
 
+void TransferWltoX::endIncr()
+{
+    xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+
+    uint32_t mask[] = {0};
+    xcb_change_window_attributes (xcbConn,
+                                  m_request->requestor,
+                                  XCB_CW_EVENT_MASK, mask);
+
+    // a property of zero length marks the end of the transfer
+    xcb_change_property(xcbConn,
+                        XCB_PROP_MODE_REPLACE,
+                        m_request->requestor,
+                        m_request->property,
+                        m_request->target,
+                        8, 0, nullptr);
+    xcb_flush(xcbConn);
+    endTransfer();
+}
+
 void TransferWltoX::readWlSource()
 {
-    if (m_chunks.size() == 0 ||
-            m_chunks.last().second == s_incrChunkSize) {
-        // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
+    if (m_buffer.size() < int(m_chunkSize)) {
+        m_buffer.resize(m_chunkSize);
     }
-
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
+    const int avail = m_chunkSize - m_bufferSize;
     Q_ASSERT(avail > 0);
 
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
+    const ssize_t readLen = read(fd(), m_buffer.data() + m_bufferSize, avail);
     if (readLen == -1) {
+        if (errno == EAGAIN || errno == EINTR) {
+            return;
+        }
         qCWarning(KWIN_XWL) << "Error reading in Wl data.";
 
         // TODO: cleanup X side?
         endTransfer();
         return;
     }
-    m_chunks.last().second = oldLen + readLen;
+    m_bufferSize += readLen;
 
     if (readLen == 0) {
         // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
+        clearSocketNotifier();
 
         if (incr()) {
-            // incremental transfer is to be completed now
-            m_flushPropertyOnDelete = true;
+            // incremental transfer is to be completed now, if the target's property
+            // is set at the moment the rest is flushed once it got deleted
             if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
+                if (m_bufferSize > 0) {
+                    flushSourceData();
+                } else {
+                    endIncr();
+                }
             }
-            clearSocketNotifier();
         } else {
             // non incremental transfer is to be completed now,
             // data can be transferred to X client via a single property set
@@ -214,17 +251,20 @@ void TransferWltoX::readWlSource()
             Q_EMIT selectionNotify(m_request, true);
             endTransfer();
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
-        // first chunk full, but not yet at fd end -> go incremental
-        if (incr()) {
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
-            }
-        } else {
-            // starting incremental transfer
+        return;
+    }
+
+    if (m_bufferSize == int(m_chunkSize)) {
+        // chunk full, but not yet at fd end -> go incremental
+        if (!incr()) {
             startIncr();
+        } else if (!m_propertyIsSet) {
+            flushSourceData();
+        }
+        if (m_propertyIsSet && m_bufferSize > 0) {
+            // the requestor still has to fetch the previous chunk,
+            // stop reading from the source until it did
+            socketNotifier()->setEnabled(false);
         }
     }
     resetTimeout();
@@ -250,29 +290,20 @@ void TransferWltoX::handlePropertyDelete()
     }
     m_propertyIsSet = false;
 
-    if (m_flushPropertyOnDelete) {
-        if (!socketNotifier() && m_chunks.isEmpty()) {
-            // transfer complete
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-
-            uint32_t mask[] = {0};
-            xcb_change_window_attributes (xcbConn,
-                                          m_request->requestor,
-                                          XCB_CW_EVENT_MASK, mask);
-
-            xcb_change_property(xcbConn,
-                                XCB_PROP_MODE_REPLACE,
-                                m_request->requestor,
-                                m_request->property,
-                                m_request->target,
-                                8, 0, nullptr);
-            xcb_flush(xcbConn);
-            m_flushPropertyOnDelete = false;
-            endTransfer();
-        } else {
+    if (m_bufferSize == int(m_chunkSize)) {
+        // the source is faster than the round trips to the requestor,
+        // use larger chunks to need less of them
+        flushSourceData();
+        m_chunkSize = qMin(m_chunkSize * 2, m_maxChunkSize);
+    } else if (!socketNotifier()) {
+        // at the fd end
+        if (m_bufferSize > 0) {
             flushSourceData();
+        } else {
+            endIncr();
         }
     }
+    // otherwise the chunk is flushed as soon as it is full
 }
 
 TransferXtoWl::TransferXtoWl(xcb_atom_t selection, xcb_atom_t target, qint32 fd,
@@ -321,7 +352,12 @@ bool TransferXtoWl::handlePropertyNotify(xcb_property_notify_event_t *event)
     if (event->window == m_window) {
         if (event->state == XCB_PROPERTY_NEW_VALUE &&
                 event->atom == atoms->wl_selection) {
-            getIncrChunk();
+            if (socketNotifier()) {
+                // still writing the previous chunk
+                m_incrChunkPending = true;
+            } else {
+                getIncrChunk();
+            }
         }
         return true;
     }
@@ -405,8 +441,10 @@ void TransferXtoWl::getIncrChunk()
     }
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
+    // Deleting the property right away lets the source prepare the next
+    // chunk while this one is written to the Wayland client.
     auto cookie = xcb_get_property(xcbConn,
-                                   0,
+                                   1,
                                    m_window,
                                    atoms->wl_selection,
                                    XCB_GET_PROPERTY_TYPE_ANY,
@@ -557,21 +595,25 @@ void TransferXtoWl::dataSourceWrite()
 
     ssize_t len = write(fd(), property.constData(), property.size());
     if (len == -1) {
-        qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
-        endTransfer();
-        return;
+        if (errno != EAGAIN && errno != EINTR) {
+            qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
+            endTransfer();
+            return;
+        }
+        // the pipe is full, continue once the client read from it
+        len = 0;
     }
 
     m_receiver->partRead(len);
     if (len == property.size()) {
         // property completely transferred
         if (incr()) {
+            // the property got already deleted when it was fetched
             clearSocketNotifier();
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-            xcb_delete_property(xcbConn,
-                                m_window,
-                                atoms->wl_selection);
-            xcb_flush(xcbConn);
+            if (m_incrChunkPending) {
+                m_incrChunkPending = false;
+                getIncrChunk();
+            }
         } else {
             // transfer complete
             endTransfer();
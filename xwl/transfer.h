@@ -131,19 +131,22 @@ Q_SIGNALS:
 
 private:
     void startIncr();
+    void endIncr();
     void readWlSource();
     int flushSourceData();
     void handlePropertyDelete();
 
     xcb_selection_request_event_t *m_request = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
+    /* Data read from the source, but not yet flushed to the requestor. The
+     * buffer is reused for all chunks, reading pauses while it is full.
      */
-    QVector<QPair<QByteArray, int> > m_chunks;
+    QByteArray m_buffer;
+    int m_bufferSize = 0;
+    uint32_t m_chunkSize;
+    uint32_t m_maxChunkSize;
 
     bool m_propertyIsSet = false;
-    bool m_flushPropertyOnDelete = false;
 
     Q_DISABLE_COPY(TransferWltoX)
 };
@@ -220,6 +223,8 @@ private:
 
     xcb_window_t m_window;
     DataReceiver *m_receiver = nullptr;
+    // the source provided the next chunk while the previous one is still being written
+    bool m_incrChunkPending = false;
 
     Q_DISABLE_COPY(TransferXtoWl)
 };
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "xwayland.h"
 #include "databridge.h"
+#include "selection.h"
 
 #include "main_wayland.h"
 #include "utils.h"
@@ -92,6 +93,8 @@ Xwayland::~Xwayland()
     if (m_app->x11Connection()) {
         Xcb::setInputFocus(XCB_INPUT_FOCUS_POINTER_ROOT);
         m_app->destroyAtoms();
+        // the atoms of the next Xwayland session differ
+        Selection::clearAtomCache();
         Q_EMIT m_app->x11ConnectionAboutToBeDestroyed();
         xcb_disconnect(m_app->x11Connection());
         m_app->setX11Connection(nullptr);